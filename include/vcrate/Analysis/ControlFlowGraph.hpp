@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <ostream>
+#include <vector>
+
+namespace vcrate { namespace analysis {
+
+struct BasicBlock {
+    // Instruction indices in the Program, [first, last)
+    ui32 first = 0;
+    ui32 last = 0;
+    // Byte addresses, [begin_pc, end_pc)
+    ui32 begin_pc = 0;
+    ui32 end_pc = 0;
+
+    std::vector<ui32> successors;
+    std::vector<ui32> predecessors;
+    // Blocks called by the CALL ending this block, only static targets are known
+    std::vector<ui32> callees;
+
+    // Ends with a jump whose target is only known while running
+    // Its successors are then every entry of the jump table
+    bool indirect = false;
+    bool reachable = false;
+
+    // ControlFlowGraph::none for the roots and the unreachable blocks
+    ui32 immediate_dominator = ~0u;
+    // Innermost loop, in ControlFlowGraph::get_loops
+    ui32 loop = ~0u;
+};
+
+struct Loop {
+    ui32 header;
+    // Sorted, including the header
+    std::vector<ui32> blocks;
+    // Blocks jumping back to the header
+    std::vector<ui32> latches;
+    ui32 parent = ~0u;
+    // 1 for an outermost loop
+    ui32 depth = 1;
+};
+
+// Basic blocks of an executable, split after each jump, call, RET and HLT and at every known target
+// Calls don't link the caller to the callee: the block after a CALL is its successor,
+// and the callee is a root like the entry point, the symbols and the jump table entries
+class ControlFlowGraph {
+public:
+
+    static constexpr ui32 none = ~0u;
+
+    // The program must outlive the graph
+    ControlFlowGraph(vcx::Executable const& exe, program::Program const& program);
+
+    std::vector<BasicBlock> const& get_blocks() const;
+    std::vector<Loop> const& get_loops() const;
+    // Sorted blocks where an execution can start: entry point, callees, symbols and jump table entries
+    std::vector<ui32> const& get_roots() const;
+
+    // Block holding the instruction at pc, or none
+    ui32 block_of(ui32 pc) const;
+
+    bool dominates(ui32 a, ui32 b) const;
+    // 0 outside of any loop
+    ui32 loop_depth(ui32 block) const;
+
+    // Graphviz format
+    void to_dot(std::ostream& os, vcx::Executable const& exe) const;
+
+private:
+
+    void build_blocks(vcx::Executable const& exe);
+    void link(vcx::Executable const& exe);
+    void find_reachable();
+    void compute_dominators();
+    void find_loops();
+
+    program::Program const& program;
+    std::vector<BasicBlock> blocks;
+    std::vector<Loop> loops;
+    std::vector<ui32> roots;
+    // Roots that don't need a call to be reached: entry point, symbols and jump table entries
+    std::vector<ui32> entries;
+    // One per instruction of the program
+    std::vector<ui32> block_of_instruction;
+
+};
+
+}}
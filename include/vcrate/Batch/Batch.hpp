@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Coverage/Coverage.hpp>
+#include <vcrate/Server/Server.hpp>
+
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vcrate { namespace batch {
+
+struct Input {
+    std::string name;
+    // Either the contents are known, or they are read from `path` when the input is run
+    std::string path;
+    std::string contents;
+};
+
+// Inputs handed one at a time, so the lines of a file are read as they are run and not held in memory
+// A directory is listed once, only the names and paths of its files are held.
+class InputReader {
+public:
+
+    // The regular files of a directory sorted by name, or the lines of a file named by their number from 1
+    explicit InputReader(std::string const& path);
+    explicit InputReader(std::vector<Input> inputs);
+
+    // False if the path can't be read
+    bool is_open() const;
+    // Nothing once all the inputs were given
+    std::optional<Input> next();
+
+private:
+
+    std::vector<Input> listed;
+    std::ifstream lines;
+    // Inputs given so far
+    ui64 position = 0;
+    bool open = true;
+
+};
+
+// The results of a batch, written in the order of the inputs
+// In a directory, the output of an input goes to "<name>.out" and a line of "results.tsv" holds its name,
+// status, halt code, instructions and message, separated by tabs.
+// On a stream, each result is a frame as the server sends them (a 32 bits little endian size, then that
+// many bytes) holding the name, sized like the strings of the protocol, followed by the encoded response.
+class ResultWriter {
+public:
+
+    // A directory, created if needed, or "-" for a stream on std::cout
+    explicit ResultWriter(std::string const& output);
+
+    bool is_open() const;
+    // False once a result couldn't be written
+    bool good() const;
+
+    void write(Input const& input, server::Response const& response);
+
+private:
+
+    std::string directory;
+    std::ofstream results;
+    bool to_stream;
+    bool ok = true;
+
+};
+
+struct Summary {
+    ui64 runs = 0;
+    // The runs that didn't halt, see server::Status
+    ui64 failures = 0;
+};
+
+// Runs the executable at `path` once per input, on `workers` threads sharing what `server` loaded
+// A worker doesn't take an input further than a few ahead of the one being written, so neither inputs
+// nor results pile up in memory. With a coverage, each worker collects its own and they are merged into
+// it at the end.
+Summary run(server::Server& server, std::string const& path, InputReader& inputs, ResultWriter& writer, ui32 workers,
+            ui64 max_instructions = 0, coverage::Coverage* coverage = nullptr);
+
+}}
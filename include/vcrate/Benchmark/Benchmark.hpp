@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vcrate { namespace benchmark {
+
+// Something able to run a sandbox, loaded with `exe`, until it halts
+// Any preparation of the executable is part of the measure
+struct Engine {
+    std::string name;
+    void (*run)(vcx::Executable const& exe, SandBox& sandbox, interpreter::Counters& counters);
+};
+
+std::vector<Engine> const& engines();
+
+struct Kernel {
+    std::string name;
+    vcx::Executable exe;
+};
+
+struct Options {
+    ui32 warmup = 2;
+    ui32 repetitions = 10;
+    ui32 memory_size = 1 << 24;
+};
+
+struct Result {
+    std::string kernel;
+    std::string engine;
+    ui64 instructions = 0;
+    ui32 halt_code = 0;
+    // What the first run printed
+    std::string output;
+    // One per repetition, in nanoseconds
+    std::vector<f64> durations;
+
+    f64 median() const;
+    f64 min() const;
+    f64 max() const;
+    f64 ns_per_instruction() const;
+    f64 instructions_per_second() const;
+};
+
+// Sandbox creation and loading aren't part of the measure
+// The output of the program is kept for the first run and discarded for the others
+Result measure(Kernel const& kernel, Engine const& engine, Options const& options);
+
+void print_results(std::ostream& os, std::vector<Result> const& results);
+
+// One row per kernel and one column per engine, with the speedup against the first engine of each row
+// Engines whose output or halt code differ from the first one are reported as mismatches
+// Returns false if there is any mismatch
+bool print_comparison(std::ostream& os, std::vector<Result> const& results);
+
+// Tab separated, one line per result with every repetition, so a baseline can be recomputed from it
+void save_results(std::ostream& os, std::vector<Result> const& results);
+std::optional<std::vector<Result>> load_results(std::istream& is);
+
+// A result regresses when its median is slower than the baseline median by more than `tolerance` (0.05 for 5 %)
+// and its fastest run is still slower than the baseline median, so a single noisy run can't trigger it
+// Returns false if anything regressed
+bool check_regressions(std::ostream& os, std::vector<Result> const& baseline, std::vector<Result> const& results, f64 tolerance);
+
+}}
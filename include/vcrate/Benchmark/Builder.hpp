@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/bytecode/Operations.hpp>
+#include <vcrate/instruction/Instruction.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <string>
+#include <vector>
+
+namespace vcrate { namespace benchmark {
+
+// Assembles an executable in the style of try.cpp, with labels for jumps and calls
+class Builder {
+public:
+
+    using Label = ui32;
+
+    // Byte address of the next instruction
+    ui32 here() const;
+
+    void push(instruction::Instruction const& i);
+    void push(interpreter::WideInstruction const& i);
+
+    Label label();
+    void bind(Label label);
+    // Binds the label and makes it a symbol of the executable
+    void bind(Label label, std::string const& symbol);
+
+    // `ope` is JMP or one of the conditional jumps
+    void jump(bytecode::Operations ope, Label label);
+    void call(Label label);
+    // Moves the absolute address of the label into `reg`, for indirect jumps and calls
+    void address(instruction::Register reg, Label label);
+
+    vcx::Executable build(Label entry);
+
+private:
+
+    struct Fixup {
+        ui32 extra_word;
+        ui32 relative_to;
+        Label label;
+    };
+
+    void push_relative(bytecode::Operations ope, Label label, bool from_next);
+
+    vcx::Executable exe;
+    std::vector<ui32> labels;
+    std::vector<Fixup> fixups;
+
+};
+
+}}
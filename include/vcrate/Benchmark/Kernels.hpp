@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Benchmark/Benchmark.hpp>
+
+#include <vector>
+
+namespace vcrate { namespace benchmark {
+
+// Absolute address used by the Address operand kernels
+// It lies in the middle of the default 16 MiB sandbox, away from the code, the heap and the stack
+constexpr ui32 scratch_address = 1 << 23;
+
+ui32 float_bits(f32 f);
+
+// Small loops stressing one part of the interpreter each, running about `iterations` times
+std::vector<Kernel> micro_kernels(ui32 iterations);
+
+}}
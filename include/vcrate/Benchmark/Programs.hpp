@@ -0,0 +1,15 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Benchmark/Benchmark.hpp>
+
+#include <vector>
+
+namespace vcrate { namespace benchmark {
+
+// Whole programs closer to real workloads than the micro kernels
+// Each one prints its result, so engines can be checked against each other
+std::vector<Kernel> macro_programs();
+
+}}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <optional>
+#include <string>
+
+namespace vcrate { namespace cache {
+
+// An executable as the engines use it, without its file
+struct Prepared {
+    vcx::Executable exe;
+    program::Program program;
+    // The verifier found no error in it
+    bool verified = false;
+};
+
+// Prepared executables kept on disk from one run to the next, one file per executable in `directory`
+// An entry is keyed by a hash of the file contents and of the cache version, so an executable changed on
+// disk, or a build decoding differently, never finds a stale entry. Entries are read with mmap and copied
+// as they are, nothing is parsed, decoded or verified again. Since the verified flag is trusted, an entry also
+// holds the size of the file it comes from and a checksum of everything after its header: a key colliding
+// with a file of another size, or an entry truncated or corrupted on disk, is a miss. They are written to
+// a temporary file renamed in place, so concurrent runs either see a whole entry or none.
+class DiskCache {
+public:
+
+    // To bump when the decoding, DecodedInstruction or the layout of an entry changes
+    static constexpr ui32 version = 2;
+
+    explicit DiskCache(std::string directory);
+
+    static ui64 key_of(std::string const& contents);
+
+    // Nothing if there is no valid entry for the key and a file of `source_size` bytes
+    std::optional<Prepared> load(ui64 key, ui64 source_size) const;
+    // False if the entry couldn't be written
+    bool store(ui64 key, ui64 source_size, Prepared const& prepared) const;
+
+    // The entry of `contents` if there is one, otherwise the contents are read, decoded and verified,
+    // and stored for the next time. Nothing if they aren't an executable.
+    std::optional<Prepared> prepare(std::string const& contents) const;
+
+    std::string path_of(ui64 key) const;
+
+private:
+
+    std::string directory;
+
+};
+
+}}
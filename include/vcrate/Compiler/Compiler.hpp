@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/vcx/Executable.hpp>
+
+#include <ostream>
+
+namespace vcrate { namespace compiler {
+
+// Names of what the generated C++ exports, with C linkage so NativeProgram finds them with dlsym
+constexpr char const* run_symbol = "vcrate_native_run";
+constexpr char const* hash_symbol = "vcrate_native_hash";
+
+// Writes C++ running `exe` on a SandBox the same way the VerifiedInterpreter does:
+//     extern "C" void vcrate_native_run(vcrate::SandBox&, vcrate::interpreter::Counters&);
+//     extern "C" vcrate::ui64 const vcrate_native_hash; // replay::hash_of(exe)
+// Each instruction becomes a few lines of C++ under a case of a switch on the pc, static jumps and calls
+// become gotos and registers A to L live in locals. Wide operations are handed to the Interpreter.
+// Throws std::runtime_error if the executable doesn't pass the verifier or uses the flags register as an argument
+void compile(std::ostream& os, vcx::Executable const& exe);
+
+}}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <string>
+
+namespace vcrate { namespace compiler {
+
+// A shared object built from the C++ written by compile, loaded with dlopen
+// It resolves the sandbox and the Interpreter from the executable loading it, which must export them (-rdynamic)
+class NativeProgram {
+public:
+
+    explicit NativeProgram(std::string const& path);
+    ~NativeProgram();
+
+    NativeProgram(NativeProgram const&) = delete;
+    NativeProgram& operator=(NativeProgram const&) = delete;
+
+    bool is_loaded() const;
+    // Why it couldn't be loaded
+    std::string const& get_error() const;
+
+    // True if it was compiled from `exe`
+    bool is_compiled_from(vcx::Executable const& exe) const;
+
+    // Runs until the sandbox is halted, the sandbox must be loaded with the executable it was compiled from
+    void run(SandBox& sandbox, interpreter::Counters& counters) const;
+
+private:
+
+    void* handle = nullptr;
+    void (*entry)(SandBox&, interpreter::Counters&) = nullptr;
+    ui64 const* hash = nullptr;
+    std::string error;
+
+};
+
+}}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/Interpreter/Interpreter.hpp>
+#include <vcrate/Interpreter/Trap.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// What the C++ generated by compiler::compile needs, header only so a compiled program only links
+// against what the executable running it already has: the sandbox, the counters and the Interpreter
+namespace vcrate { namespace compiler { namespace runtime {
+
+inline f32 float_of(ui32 u) {
+    f32 f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+inline ui32 bits_of(f32 f) {
+    ui32 u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline i32 int_of(ui32 u) {
+    return static_cast<i32>(u);
+}
+
+// Registers A to L and the flags live in locals while the compiled code runs, so the C++ compiler keeps them
+// in machine registers, and are written back to the sandbox when it stops or hands an instruction to the Interpreter
+struct State {
+    static constexpr ui32 register_count = 12;
+
+    SandBox& sandbox;
+    ui32 code_size;
+    ui32 r[register_count];
+    bool zero;
+    bool greater;
+
+    State(SandBox& sandbox, ui32 code_size) : sandbox(sandbox), code_size(code_size) {
+        load();
+    }
+
+    ~State() {
+        store();
+    }
+
+    State(State const&) = delete;
+    State& operator=(State const&) = delete;
+
+    void load() {
+        for(ui32 i = 0; i < register_count; ++i)
+            r[i] = sandbox.get_register(i);
+        zero = sandbox.get_flag_zero();
+        greater = sandbox.get_flag_greater();
+    }
+
+    void store() const {
+        for(ui32 i = 0; i < register_count; ++i)
+            sandbox.set_register(i, r[i]);
+        sandbox.set_flag_zero(zero);
+        sandbox.set_flag_greater(greater);
+    }
+
+    // Same rule as the VerifiedInterpreter, the compiled code can't follow a change of the code
+    // False if the write is to the code, nothing is written then
+    bool write_memory(ui32 address, ui32 value) {
+        if (address < code_size)
+            return false;
+        sandbox.set_memory_at(address, value);
+        return true;
+    }
+
+    // The pc has to be the one of the instruction, the Interpreter moves it
+    // False if the instruction trapped, the compiled code goes on at the pc of the sandbox then, if not halted
+    bool interpret(ui32 pc, ui32 next, interpreter::Counters& counters) {
+        store();
+        sandbox.set_pc(pc);
+        interpreter::Interpreter::run_next_instruction(sandbox, counters);
+        load();
+        return !sandbox.is_halted() && sandbox.get_pc() == next;
+    }
+
+    // A fault of the instruction at `pc`, handled as the interpreters do, `next` is where it would have continued
+    // The compiled code goes on at the pc of the sandbox, if not halted
+    void trap(interpreter::TrapCode code, ui32 pc, ui32 next, interpreter::Counters& counters) {
+        store();
+        sandbox.set_pc(next);
+        interpreter::raise_trap(code);
+        interpreter::handle_trap(sandbox, counters, pc);
+        load();
+    }
+};
+
+}}}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace vcrate { namespace coverage {
+
+struct Summary {
+    ui32 instructions = 0;
+    ui32 executed = 0;
+    // Two per conditional jump, taken and not taken
+    ui32 directions = 0;
+    ui32 directions_covered = 0;
+};
+
+// Which instructions of an executable ran, and in which directions its conditional jumps went
+// A bit per word of code, for the instruction starting on it, in three bitmaps: executed, taken and not taken.
+// Runs of the same executable are merged by or-ing the bitmaps, so coverages of any number of runs add up
+// in one of the same size.
+class Coverage {
+public:
+
+    static constexpr ui32 magic = 0x56434356; // "VCCV"
+    static constexpr ui32 version = 1;
+
+    // Empty, it takes the executable of the first coverage merged into it
+    Coverage() = default;
+    explicit Coverage(vcx::Executable const& exe);
+
+    // Must surround each run_next_instruction, like the Profiler
+    // Only a coverage built from the executable can record, a loaded one doesn't know its conditional jumps
+    void before(SandBox const& sandbox) {
+        pc = sandbox.get_pc();
+        ui32 word = pc / 4;
+        branch_size = 0;
+        if (pc % 4 != 0 || word >= branch_sizes.size())
+            return;
+        executed[word / 64] |= ui64(1) << (word % 64);
+        branch_size = branch_sizes[word];
+    }
+
+    void after(SandBox const& sandbox) {
+        if (branch_size == 0)
+            return;
+        ui32 word = pc / 4;
+        auto& bitmap = sandbox.get_pc() == pc + branch_size ? not_taken : taken;
+        bitmap[word / 64] |= ui64(1) << (word % 64);
+    }
+
+    // False, and nothing changes, if `other` is of another executable
+    bool merge(Coverage const& other);
+
+    bool is_empty() const;
+    ui64 get_executable_hash() const;
+
+    bool is_executed(ui32 pc) const;
+    bool is_taken(ui32 pc) const;
+    bool is_not_taken(ui32 pc) const;
+
+    // Over the instructions of `program`, decoded from the executable of the coverage
+    Summary summarize(program::Program const& program) const;
+
+    // The magic, the version, the hash of the executable (replay::hash_of), the words of code on 32 bits,
+    // then the three bitmaps as 64 bits words
+    void save(std::ostream& os) const;
+    static std::optional<Coverage> load(std::istream& is);
+
+private:
+
+    static bool test(std::vector<ui64> const& bitmap, ui32 pc);
+
+    ui64 executable_hash = 0;
+    ui32 code_words = 0;
+    std::vector<ui64> executed;
+    std::vector<ui64> taken;
+    std::vector<ui64> not_taken;
+    // Size of the conditional jump starting on each word, 0 for the other words
+    std::vector<ui8> branch_sizes;
+
+    // Of the instruction being run
+    ui32 pc = 0;
+    ui8 branch_size = 0;
+
+};
+
+}}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/Interpreter/DecodeCache.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <istream>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace vcrate { namespace debugger {
+
+enum class Stop : ui8 {
+    // On an instruction with a breakpoint, not run yet
+    Breakpoint,
+    // After the instruction that changed a watched word
+    Watchpoint,
+    // Where a step, next or finish ends
+    Step,
+    Halted
+};
+
+char const* to_string(Stop stop);
+
+// Runs a program loaded in a sandbox under control: breakpoints, watchpoints, and a few instructions at a time
+// A program passing the verifier runs on the VerifiedInterpreter, with its own copy of the decoded code where
+// the instructions holding a breakpoint are patched with program::breakpoint_operation: running to the next
+// breakpoint checks nothing per instruction, and the engines without a debugger aren't changed at all.
+// Other programs run on the Interpreter, looking the pc up in the breakpoints after every instruction.
+// Watchpoints compare the words they watch after every instruction, so only a run with some set is slowed down.
+class Debugger {
+public:
+
+    struct Watchpoint {
+        // In bytes
+        ui32 address;
+        // Last value seen
+        ui32 value;
+    };
+
+    // `sandbox` must hold `exe`, as SandBox::load_executable leaves it, and outlive the debugger
+    Debugger(vcx::Executable const& exe, SandBox& sandbox, interpreter::Counters& counters);
+
+    Debugger(Debugger const&) = delete;
+    Debugger& operator=(Debugger const&) = delete;
+
+    // True if the program runs on the VerifiedInterpreter
+    bool is_verified() const;
+
+    // A symbol, "symbol+offset", or a number (decimal, or hexadecimal with "0x")
+    std::optional<ui32> address_of(std::string const& location) const;
+
+    // False if no instruction starts at `pc`
+    bool add_breakpoint(ui32 pc);
+    bool remove_breakpoint(ui32 pc);
+    std::set<ui32> const& get_breakpoints() const;
+
+    // `address` is rounded down to a word
+    void add_watchpoint(ui32 address);
+    bool remove_watchpoint(ui32 address);
+    std::vector<Watchpoint> const& get_watchpoints() const;
+
+    // Runs until a breakpoint, a watchpoint or the halt
+    // The instruction at the pc runs even if it holds a breakpoint, so a stopped program can go on.
+    Stop resume();
+    // Runs one instruction
+    Stop step();
+    // Runs one instruction, a whole call for a call
+    Stop next();
+    // Runs until the function at the pc returns to its caller
+    // Its frame is the one of the bp, set by the ETR at its start, or the one starting on an ETR at the pc.
+    Stop finish();
+
+    // The watchpoint that stopped the last run, nullptr if it didn't stop on one
+    Watchpoint const* get_triggered() const;
+
+    // Reads commands from `is` until the program halts, `quit`, or the end of the input
+    // Stops and answers are written to `os`, "help" lists the commands.
+    void repl(std::istream& is, std::ostream& os);
+
+private:
+
+    // Runs until a breakpoint, a watchpoint, the halt, or one of `temporaries` reached with `done` true
+    // Temporaries are patched like breakpoints for the run only.
+    template<typename F>
+    Stop run(std::set<ui32> const& temporaries, F const& done);
+
+    // Runs the instruction at the pc, even if it is patched
+    void run_one();
+    // The instruction decoded at `pc` before any patch, nullptr if none starts there
+    program::DecodedInstruction const* original_at(ui32 pc) const;
+    // True if a watched word changed, its watchpoint is then the triggered one
+    bool check_watchpoints();
+
+    void patch(ui32 pc);
+    void unpatch(ui32 pc);
+
+    // "pc in location : instruction"
+    std::string describe(ui32 pc) const;
+    bool execute(std::string const& line, std::ostream& os);
+    void report(Stop stop, std::ostream& os) const;
+
+    vcx::Executable const& exe;
+    SandBox& sandbox;
+    interpreter::Counters& counters;
+    program::SymbolIndex symbols;
+
+    // Decoded even if it doesn't pass the verifier, to know where instructions and calls are
+    program::Program program;
+    bool verified;
+    interpreter::DecodeCache cache;
+
+    std::set<ui32> breakpoints;
+    // The instructions patched over, by pc
+    std::map<ui32, program::DecodedInstruction> originals;
+    // Where calls return, for finish
+    std::set<ui32> return_sites;
+
+    std::vector<Watchpoint> watchpoints;
+    std::optional<ui32> triggered;
+
+};
+
+}}
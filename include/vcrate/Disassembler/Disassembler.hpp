@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/vcx/Executable.hpp>
+#include <vcrate/Coverage/Coverage.hpp>
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vcrate { namespace disassembler {
+
+// One instruction of the code, as instruction_to_string prints it, or "<unknown XXXXXXXX>" for a word that
+// isn't an operation
+struct Line {
+    // In bytes
+    ui32 pc;
+    ui32 size;
+    std::string text;
+    // JMPE, JMPNE, JMPG or JMPGE
+    bool conditional_jump = false;
+};
+
+// The instruction starting at the word `word` of the code
+Line line_at(vcx::Executable const& exe, ui32 word);
+
+// The instructions from the word `begin`, taken as the start of one, until one starts at or past the word `end`
+std::vector<Line> decode_chunk(vcx::Executable const& exe, ui32 begin, ui32 end);
+
+// Hands every instruction of the code to `emit` in order, as soon as the chunk holding it is decoded
+// The code is split in chunks of `chunk_words` words decoded on `workers` threads, each one as if an
+// instruction started on its first word. Once the previous chunk is emitted, the end of its last
+// instruction tells where the chunk really starts: the lines before are dropped, and if that start isn't
+// one of the chunk's own it's decoded again from there until both decodings meet, which only takes a few
+// instructions since none is longer than 3 words.
+void disassemble(vcx::Executable const& exe, std::function<void(Line const&)> const& emit, ui32 workers = 1, ui32 chunk_words = 1 << 16);
+
+// How `line` was covered: "missed", "executed", or for a conditional jump that ran "taken", "not-taken" or "both"
+char const* coverage_of(coverage::Coverage const& coverage, Line const& line);
+
+// The machine readable form, written as it's decoded, one record per line with fields separated by tabs:
+//   entry   <address>
+//   symbol  <name>  <address>
+//   jump    <index>  <word>
+//   data    <offset>  <word in hexadecimal>
+//   code    <pc>  <words in hexadecimal separated by spaces>  <instruction>  <location>
+// Addresses and offsets are in bytes, offsets from the start of the data. A location is the enclosing symbol
+// and the offset from it, as program::SymbolIndex gives it. With a coverage of the executable, code records
+// get a last field telling how the instruction was covered, as coverage_of gives it.
+void write_plain(std::ostream& os, vcx::Executable const& exe, ui32 workers = 1, coverage::Coverage const* coverage = nullptr);
+
+}}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Trap.hpp>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace vcrate { namespace interpreter {
+
+// Statistics of one sandbox, updated by the Interpreter on every instruction
+// One instance per sandbox, so these are plain integers and not atomics
+struct Counters {
+
+    Counters() = default;
+    // The current stack pointer of the sandbox is used as the bottom of the stack
+    explicit Counters(SandBox const& sandbox);
+
+    ui64 instructions = 0;
+    ui64 calls = 0;
+    ui64 allocations = 0;
+    ui64 deallocations = 0;
+    ui64 allocated_bytes = 0;
+    ui64 output_bytes = 0;
+
+    ui32 stack_base = 0;
+    ui32 peak_stack_depth = 0;
+
+    // Only followed once track_heap is called
+    ui64 heap_in_use = 0;
+    ui64 peak_heap = 0;
+
+    ui64 traps = 0;
+    // The last one
+    Trap trap;
+    // Address called on a trap, the sandbox is halted on the first trap without one
+    std::optional<ui32> trap_handler;
+
+    void on_stack(ui32 sp) {
+        if (sp < stack_base && stack_base - sp > peak_stack_depth)
+            peak_stack_depth = stack_base - sp;
+    }
+
+    void on_allocate(ui32 address, ui32 size) {
+        ++allocations;
+        allocated_bytes += size;
+        if (block_sizes)
+            track_allocate(address, size);
+    }
+
+    void on_deallocate(ui32 address) {
+        ++deallocations;
+        if (block_sizes)
+            track_deallocate(address);
+    }
+
+    // Follows the size of each block to know heap_in_use and peak_heap, a NEW and a DEL then update a map
+    // Blocks allocated before aren't known, their DEL doesn't change heap_in_use
+    void track_heap();
+    bool is_tracking_heap() const;
+
+    // Without heap tracking, heap_in_use and peak_heap are left out
+    std::string to_json() const;
+
+private:
+
+    void track_allocate(ui32 address, ui32 size);
+    void track_deallocate(ui32 address);
+
+    std::optional<std::unordered_map<ui32, ui32>> block_sizes;
+
+};
+
+}}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/instruction/Instruction.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <vector>
+
+namespace vcrate { namespace interpreter {
+
+// An instruction::Instruction or a WideInstruction with its arguments decoded once
+// It has the accessors the handlers of the Interpreter use, so they work on it the same way
+struct CachedInstruction {
+    // The words it was decoded from, the unused extras are 0
+    ui32 words[3] = { 0, 0, 0 };
+    ui32 size = 4;
+    bool wide = false;
+    ui8 operation = 0;
+    // The complete argument of one argument operations is the first one
+    instruction::Argument args[2];
+
+    // Unknown operations are kept as is, without arguments, so running them raises UnknownOperation as before
+    static CachedInstruction decode(ui32 main_instruction, ui32 extra0, ui32 extra1);
+
+    bytecode::Operations get_operation() const { return static_cast<bytecode::Operations>(operation); }
+    WideOperations get_wide_operation() const { return static_cast<WideOperations>(operation); }
+    ui32 get_byte_size() const { return size; }
+
+    instruction::Argument const& get_first_argument() const { return args[0]; }
+    instruction::Argument const& get_second_argument() const { return args[1]; }
+    instruction::Argument const& get_complete_argument() const { return args[0]; }
+
+    bool decoded_from(SandBox const& sandbox, ui32 pc) const;
+};
+
+// Decoded instructions of a range of memory, the code of the executable usually, one slot per word
+// A slot is checked against the words in memory before being used, so code written by the program
+// is decoded again instead of running stale instructions
+class DecodeCache {
+public:
+
+    DecodeCache() = default;
+    DecodeCache(ui32 begin, ui32 end);
+    // The code of `exe`, loaded at address 0 by SandBox::load_executable
+    explicit DecodeCache(vcx::Executable const& exe);
+
+    // Instructions outside of the range are decoded every time
+    CachedInstruction const& fetch(SandBox const& sandbox, ui32 pc);
+
+    ui64 get_hits() const;
+    ui64 get_misses() const;
+
+private:
+
+    ui32 begin = 0;
+    std::vector<CachedInstruction> slots;
+    std::vector<bool> filled;
+    CachedInstruction outside;
+
+    ui64 hits = 0;
+    ui64 misses = 0;
+
+};
+
+}}
@@ -4,13 +4,23 @@
 
 #include <vcrate/Sandbox/SandBox.hpp>
 #include <vcrate/instruction/Instruction.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/Interpreter/DecodeCache.hpp>
+#include <vcrate/Interpreter/Trap.hpp>
 
 namespace vcrate { namespace interpreter {
 
+// Faults of the program are traps, see Trap.hpp, they don't throw
 class Interpreter {
 public:
 
-    static void run_next_instruction(SandBox& sandbox);
+    static void run_next_instruction(SandBox& sandbox, Counters& counters);
+    // Same, reusing the instructions already decoded by `cache`
+    static void run_next_instruction(SandBox& sandbox, Counters& counters, DecodeCache& cache);
+    // Runs until the sandbox is halted
+    static void run(SandBox& sandbox, Counters& counters);
+    static void run(SandBox& sandbox, Counters& counters, DecodeCache& cache);
 
     static instruction::Instruction fetch_instruction(SandBox const& sandbox);
     static instruction::Instruction fetch_instruction_and_move(SandBox& sandbox);
@@ -21,59 +31,100 @@ private:
     static ui32 value_of(SandBox& sandbox, instruction::Argument const& arg);
     static ui32 address_of(SandBox& sandbox, instruction::Argument const& arg);
 
-    static void instruction_ADD(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_ADDF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_SUB(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_SUBF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_MOD(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_MODF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_MUL(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_MULU(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_MULF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DIV(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DIVU(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DIVF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_MOV(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_LEA(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_POP(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_PUSH(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_JMP(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_JMPE(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_JMPNE(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_JMPG(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_JMPGE(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_AND(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_OR(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_XOR(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_NOT(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_SHL(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_RTL(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_SHR(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_RTR(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_SWP(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_CMP(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_CMPU(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_INC(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_INCF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DEC(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DECF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_NEW(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DEL(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_CALL(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_RET(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_ETR(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_LVE(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_HLT(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_OUT(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DBG(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DBGU(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_DBGF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_ITU(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_ITF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_UTI(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_UTF(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_FTI(SandBox& sandbox, instruction::Instruction const& instruction);
-    static void instruction_FTU(SandBox& sandbox, instruction::Instruction const& instruction);
+    static void write64_to(SandBox& sandbox, instruction::Argument const& arg, ui64 value);
+    static ui64 value64_of(SandBox& sandbox, instruction::Argument const& arg);
+    static f64 double_of(SandBox& sandbox, instruction::Argument const& arg);
+
+    // Handles the trap the instruction may raise
+    static void execute(SandBox& sandbox, Counters& counters, CachedInstruction const& instruction);
+    static void execute_operation(SandBox& sandbox, Counters& counters, CachedInstruction const& instruction);
+    static void execute_wide(SandBox& sandbox, CachedInstruction const& instruction);
+
+    static void instruction_ADD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_ADDF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SUB(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SUBF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MOD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MODF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MUL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MULU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MULF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DIV(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DIVU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DIVF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MOV(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_LEA(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_POP(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_PUSH(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters);
+    static void instruction_JMP(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_JMPE(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_JMPNE(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_JMPG(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_JMPGE(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_AND(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_OR(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_XOR(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_NOT(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SHL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_RTL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SHR(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_RTR(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SWP(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_CMP(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_CMPU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_INC(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_INCF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DEC(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DECF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_NEW(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters);
+    static void instruction_DEL(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters);
+    static void instruction_CALL(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters);
+    static void instruction_RET(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_ETR(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters);
+    static void instruction_LVE(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_HLT(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_OUT(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters);
+    static void instruction_DBG(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DBGU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DBGF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_ITU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_ITF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_UTI(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_UTF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_FTI(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_FTU(SandBox& sandbox, CachedInstruction const& instruction);
+
+    static void instruction_ADDL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SUBL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MULL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DIVL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DIVLU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MODL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SHLL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SHRL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_CMPL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_CMPLU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MOVL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_INCL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DECL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_ADDD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_SUBD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MULD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DIVD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_MODD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_CMPD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_ITL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_UTL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_LTI(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_LTD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DTL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_ITD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DTI(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_FTD(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DTF(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DBGL(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DBGLU(SandBox& sandbox, CachedInstruction const& instruction);
+    static void instruction_DBGD(SandBox& sandbox, CachedInstruction const& instruction);
 
 };
 
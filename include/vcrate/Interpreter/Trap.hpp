@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+
+namespace vcrate { namespace interpreter {
+
+struct Counters;
+
+enum class TrapCode : ui8 {
+    None,
+    UnknownOperation,
+    // A Value argument written to
+    InvalidWrite,
+    // A Value or Register argument used as an address
+    NoAddress,
+    // L can't hold the low half of a 64 bits value, the next register is the pc
+    InvalidRegisterPair,
+    DivisionByZero,
+    // Only raised by the engines running decoded code, which can't follow a change of it
+    WriteToCode,
+    InvalidPc,
+    // Not a fault: an instruction patched by a debugger is reached, it stops the engine instead of a handler
+    Breakpoint
+};
+
+char const* to_string(TrapCode code);
+
+struct Trap {
+    TrapCode code = TrapCode::None;
+    // Address of the faulting instruction
+    ui32 pc = 0;
+};
+
+// The fault of the instruction being run, for the engine running it
+// A fault doesn't unwind: the instruction goes on with harmless values but doesn't write its destination,
+// and the engine checks this once per instruction. Only the first fault of an instruction is kept.
+inline thread_local TrapCode pending_trap = TrapCode::None;
+
+inline void raise_trap(TrapCode code) {
+    if (pending_trap == TrapCode::None)
+        pending_trap = code;
+}
+
+// The cold path of every engine, for the pending trap of the instruction at `pc`
+// The trap is recorded in `counters`. Without a trap handler the sandbox is halted, otherwise the handler
+// is called like a function returning where the instruction would have continued, with the trap code
+// pushed above the return address. Registers and memory written before the fault keep their value.
+// An InvalidPc halts even with a handler, the address it would return to is the invalid pc itself.
+void handle_trap(SandBox& sandbox, Counters& counters, ui32 pc);
+
+}}
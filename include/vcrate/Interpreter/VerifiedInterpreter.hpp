@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/Program/Program.hpp>
+
+namespace vcrate { namespace interpreter {
+
+// Runs a program decoded once and accepted by verifier::verify
+// Instructions aren't decoded again and the checks done by the verifier (known operations, argument kinds,
+// register pairs) are skipped. The only checks left are the ones the verifier can't do:
+// the pc must be the address of an instruction, and the code can't be written to. They raise traps.
+// Wide operations are handed to the Interpreter.
+// Jumps and calls look their target up in the Program, even through a register or memory: per-site inline caches
+// of the last targets ran no faster than this indexed lookup.
+class VerifiedInterpreter {
+public:
+
+    static void run_next_instruction(program::Program const& program, SandBox& sandbox, Counters& counters);
+    // Runs until the sandbox is halted
+    // A call to a function starting with ETR, and a LVE followed by a RET, run as a single step
+    // A return still pops its address from the stack of the sandbox and looks it up, there is no shadow return stack
+    static void run(program::Program const& program, SandBox& sandbox, Counters& counters);
+    // Runs like `run` until an instruction patched with program::breakpoint_operation is reached
+    // True if stopped on one, the pc is then its address and nothing of it is run
+    static bool run_until_breakpoint(program::Program const& program, SandBox& sandbox, Counters& counters);
+
+};
+
+}}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/instruction/Instruction.hpp>
+
+#include <string>
+
+namespace vcrate { namespace interpreter {
+
+// 64 bits integer (L) and double precision (D) operations
+// They live in the upper operation range, left unused by bytecode::Operations
+// A 64 bits operand is a register pair (id, id + 1) or two consecutive words in memory (low word first)
+// DIVL is signed and DIVLU unsigned, but MODL is unsigned like the 32 bits MOD: there is no signed remainder
+enum class WideOperations : ui8 {
+    ADDL = 0xC0, SUBL, MULL, DIVL, DIVLU, MODL, SHLL, SHRL, CMPL, CMPLU, MOVL, INCL, DECL,
+    ADDD, SUBD, MULD, DIVD, MODD, CMPD,
+    ITL, UTL, LTI, LTD, DTL, ITD, DTI, FTD, DTF,
+    DBGL, DBGLU, DBGD,
+
+    // Must be the last one
+    _COUNT
+};
+
+class WideInstruction {
+public:
+
+    static constexpr ui32 first_operation = static_cast<ui32>(WideOperations::ADDL);
+    static constexpr ui32 operation_count = static_cast<ui32>(WideOperations::_COUNT) - first_operation;
+
+    static bool is_wide(ui32 main_instruction);
+
+    WideInstruction(ui32 main_instruction, ui32 extra0 = 0, ui32 extra1 = 0);
+    WideInstruction(WideOperations ope, instruction::Argument const& arg);
+    WideInstruction(WideOperations ope, instruction::Argument const& arg0, instruction::Argument const& arg1);
+
+    WideOperations get_operation() const;
+
+    instruction::Argument get_first_argument() const;
+    instruction::Argument get_second_argument() const;
+    instruction::Argument get_complete_argument() const;
+
+    ui32 get_byte_size() const;
+    ui32 get_main_instruction() const;
+    ui32 get_first_extra() const;
+    ui32 get_second_extra() const;
+
+    std::string to_string() const;
+
+    static std::string name_of(WideOperations ope);
+    static ui32 arg_count_of(WideOperations ope);
+
+private:
+
+    // The arguments are encoded the same way as a bytecode::Operations with the same arguments count
+    // so the decoding is done by an instruction::Instruction carrying one of those
+    WideOperations ope;
+    instruction::Instruction carrier;
+
+};
+
+// Works on both bytecode::Operations and WideOperations
+ui32 instruction_byte_size(ui32 main_instruction, ui32 extra0, ui32 extra1);
+std::string instruction_to_string(ui32 main_instruction, ui32 extra0, ui32 extra1);
+
+}}
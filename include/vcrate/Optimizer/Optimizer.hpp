@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/vcx/Executable.hpp>
+
+#include <ostream>
+
+namespace vcrate { namespace optimizer {
+
+struct Options {
+    // Instructions whose operands are all known constants become a MOV of the result
+    bool fold_constants = true;
+    // Unreachable instructions are dropped
+    bool eliminate_dead_code = true;
+    // Jumps to an unconditional jump go to its target, jumps to the next instruction are dropped
+    bool thread_jumps = true;
+    // MOV of a register to itself, of a value the register already holds or overwritten before being read
+    bool remove_redundant_moves = true;
+    // MUL and MULU by 2^n become SHL, DIVU becomes SHR and MOD becomes AND
+    bool reduce_strength = true;
+};
+
+struct Statistics {
+    ui32 folded = 0;
+    ui32 dead = 0;
+    ui32 threaded = 0;
+    ui32 moves = 0;
+    ui32 reduced = 0;
+    ui32 code_bytes_before = 0;
+    ui32 code_bytes_after = 0;
+
+    void print(std::ostream& os) const;
+};
+
+// Returns the optimized executable, with its entry point, symbols and jump table moved along the code
+// The code is moved, so the executable must not depend on the address of its instructions other than through
+// static jumps and calls, the entry point, symbols and the jump table: reading PC, using an Address
+// inside the code or jumping and calling through a register or memory throws std::runtime_error,
+// as do unknown operations
+// When the executable has data, the code is padded back to its original size with HLT so data addresses don't move
+vcx::Executable optimize(vcx::Executable const& exe, Options const& options, Statistics& statistics);
+
+}}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vcrate { namespace pool {
+
+// Sandboxes loaded with one executable, kept from one run to the next
+// The executable is loaded once into a pristine sandbox, and a sandbox given back is reset by assigning
+// the pristine one to it: its memory is reused instead of allocated, cleared and loaded again.
+// The halted state and the heap live in the sandbox library and can only be reset that way, so the
+// reset copies the whole memory, not only what the run touched.
+// Acquiring and giving back are thread safe, a sandbox is only used by the one holding its lease.
+class SandBoxPool {
+public:
+
+    // Gives the sandbox back to the pool when destroyed
+    class Lease {
+    public:
+
+        Lease(Lease&&) = default;
+        ~Lease();
+
+        SandBox& operator*() const { return *sandbox; }
+        SandBox* operator->() const { return sandbox.get(); }
+
+    private:
+
+        friend class SandBoxPool;
+        Lease(SandBoxPool& pool, std::unique_ptr<SandBox> sandbox);
+
+        SandBoxPool* pool;
+        std::unique_ptr<SandBox> sandbox;
+
+    };
+
+    // At most `capacity` idle sandboxes are kept, the others are freed when given back
+    SandBoxPool(vcx::Executable const& exe, ui32 memory_size, ui32 capacity = 8);
+
+    SandBoxPool(SandBoxPool const&) = delete;
+    SandBoxPool& operator=(SandBoxPool const&) = delete;
+
+    // A sandbox as SandBox::load_executable leaves it
+    Lease acquire();
+
+    ui64 get_created() const;
+    ui64 get_reused() const;
+
+private:
+
+    void give_back(std::unique_ptr<SandBox> sandbox);
+
+    SandBox pristine;
+    ui32 capacity;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<SandBox>> idle;
+    ui64 created = 0;
+    ui64 reused = 0;
+
+};
+
+// One SandBoxPool per executable, found by replay::hash_of
+class SandBoxPools {
+public:
+
+    explicit SandBoxPools(ui32 memory_size, ui32 capacity = 8);
+
+    // The pool of `exe`, created on first use
+    SandBoxPool& of(vcx::Executable const& exe);
+
+private:
+
+    ui32 memory_size;
+    ui32 capacity;
+
+    std::mutex mutex;
+    std::unordered_map<ui64, std::unique_ptr<SandBoxPool>> pools;
+
+};
+
+}}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vcrate { namespace profiler {
+
+enum class OperationClass : ui8 {
+    Integer, Float, Wide, Logic, Memory, Jump, Call, Conversion, IO,
+
+    // Must be the last one
+    _COUNT
+};
+
+std::string to_string(OperationClass c);
+OperationClass class_of(ui32 operation);
+
+// Counts every instruction executed (per operation and per PC), the time spent in each operation class
+// and the call graph. Every `sample_period` instructions, the call stack is sampled to produce folded stacks
+class Profiler {
+public:
+
+    Profiler(vcx::Executable const& exe, ui32 sample_period = 1000);
+
+    // Must surround each Interpreter::run_next_instruction
+    void before(SandBox const& sandbox);
+    void after(SandBox const& sandbox);
+
+    void report(std::ostream& os) const;
+    // One line per sampled stack: "caller;callee count", readable by flamegraph.pl
+    void folded_stacks(std::ostream& os) const;
+
+private:
+
+    using clock = std::chrono::steady_clock;
+
+    std::string function_name(ui32 address) const;
+
+    vcx::Executable const& exe;
+    program::SymbolIndex symbols;
+    ui32 sample_period;
+
+    ui64 instructions = 0;
+    ui64 out_of_code = 0;
+    std::array<ui64, 256> operations{};
+    std::array<ui64, static_cast<ui32>(OperationClass::_COUNT)> class_counts{};
+    std::array<clock::duration, static_cast<ui32>(OperationClass::_COUNT)> class_durations{};
+    std::vector<ui64> hits;
+
+    // Entry point of each function currently called
+    std::vector<ui32> stack;
+    std::map<std::pair<ui32, ui32>, ui64> call_edges;
+    std::map<std::vector<ui32>, ui64> samples;
+
+    ui32 current_operation = 0;
+    clock::time_point current_start;
+
+};
+
+}}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/vcx/Executable.hpp>
+
+#include <istream>
+#include <optional>
+#include <ostream>
+
+namespace vcrate { namespace program {
+
+// A denser encoding of an executable, to ship and store it
+// Each instruction is its operation byte followed, for each argument, by a byte holding its kind and register
+// and a varint for its value, address or displacement, so most instructions take 2 to 4 bytes instead of 4 to 12
+// Words that don't re-encode to themselves, as unknown operations or data in the code, are kept raw
+// Reading it gives back the exact same vcx::Executable, the sandbox and the tools see no difference
+constexpr char compact_magic[4] = { 'V', 'C', 'X', 'C' };
+constexpr ui8 compact_version = 1;
+
+void write_compact(std::ostream& os, vcx::Executable const& exe);
+// Nothing if the stream doesn't hold a compact executable of this version or if it's truncated
+std::optional<vcx::Executable> read_compact(std::istream& is);
+
+// Looks at the magic without consuming it
+bool is_compact(std::istream& is);
+
+// Either encoding, nothing if the executable can't be read
+std::optional<vcx::Executable> read_executable(std::istream& is);
+
+}}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/bytecode/Operations.hpp>
+#include <vcrate/instruction/Instruction.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <vector>
+
+namespace vcrate { namespace program {
+
+enum class OperandKind : ui8 {
+    None, Register, Value, Address, Deferred, Displacement
+};
+
+// Plain data, so a decoded program can be copied or written as is
+struct Operand {
+    OperandKind kind = OperandKind::None;
+    ui8 reg = 0;
+    // Immediate, absolute address or displacement, depending on the kind
+    ui32 value = 0;
+};
+
+// How an operation uses one of its arguments
+enum class Access : ui8 {
+    None, Read, Write, ReadWrite, Address
+};
+
+// Not an operation of bytecode::Operations nor of WideOperations, a debugger patches it over the
+// instructions it stops at
+constexpr ui8 breakpoint_operation = 0xFE;
+
+struct DecodedInstruction {
+    ui32 pc = 0;
+    // A bytecode::Operations, or an interpreter::WideOperations if `wide` is set
+    ui8 op = 0;
+    // In bytes
+    ui8 size = 0;
+    bool wide = false;
+    // False if the operation is unknown or the instruction doesn't fit in the code
+    bool valid = false;
+    Operand args[2];
+};
+
+bool is_known_operation(bytecode::Operations ope);
+
+ui32 arg_count_of(DecodedInstruction const& d);
+Access access_of(DecodedInstruction const& d, ui32 index);
+// True if the instruction writes to the register `id` through a Register argument
+bool writes_register(DecodedInstruction const& d, ui32 id);
+
+bool is_jump(DecodedInstruction const& d);
+bool is_conditional_jump(DecodedInstruction const& d);
+bool is_call(DecodedInstruction const& d);
+bool is_return(DecodedInstruction const& d);
+bool is_halt(DecodedInstruction const& d);
+
+// Jumps and calls with a Value argument are relative and known before running
+// Jumps are relative to their own address, calls to the next instruction, like in the Interpreter
+bool has_static_target(DecodedInstruction const& d);
+ui32 static_target_of(DecodedInstruction const& d);
+
+Operand to_operand(instruction::Argument const& arg);
+instruction::Argument to_argument(Operand const& operand);
+
+// The words of a valid instruction, as instruction::Instruction or WideInstruction encode it
+std::vector<ui32> encode(DecodedInstruction const& d);
+
+// The code of an executable decoded once, from its first word, instruction after instruction
+// The code is expected to be loaded at address 0, as SandBox::load_executable does
+class Program {
+public:
+
+    static constexpr ui32 invalid_index = ~0u;
+
+    Program() = default;
+    explicit Program(vcx::Executable const& exe);
+    // Instructions decoded before from `code_words` words of code, as cache::DiskCache gives them back
+    Program(std::vector<DecodedInstruction> instructions, ui32 code_words);
+
+    // nullptr if pc isn't the address of a decoded instruction
+    DecodedInstruction const* at(ui32 pc) const {
+        ui32 word = pc / 4;
+        if (pc % 4 != 0 || word >= indices.size() || indices[word] == invalid_index)
+            return nullptr;
+        return &instructions[indices[word]];
+    }
+
+    ui32 index_of(ui32 pc) const;
+
+    // Replaces the instruction at `pc` with `d` moved there, false if no instruction starts at `pc`
+    // For a debugger patching breakpoints in: the decoded form changes, not the code in the sandbox
+    bool patch(ui32 pc, DecodedInstruction d);
+
+    std::vector<DecodedInstruction> const& get_instructions() const;
+    // In bytes
+    ui32 get_code_size() const;
+
+private:
+
+    std::vector<DecodedInstruction> instructions;
+    // One per word of code
+    std::vector<ui32> indices;
+
+};
+
+}}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/vcx/Executable.hpp>
+
+#include <string>
+#include <vector>
+
+namespace vcrate { namespace program {
+
+// The symbols of an executable sorted by address, built once to find the function holding an address
+// Symbols sharing an address stay in the order of their names, the first one is the one found.
+class SymbolIndex {
+public:
+
+    struct Symbol {
+        ui32 address;
+        std::string name;
+    };
+
+    SymbolIndex() = default;
+    explicit SymbolIndex(vcx::Executable const& exe);
+
+    // The last symbol at or before `address`, nullptr if there is none
+    Symbol const* enclosing(ui32 address) const;
+    // The symbol at `address`, nullptr if there is none
+    Symbol const* at(ui32 address) const;
+
+    // "name" or "name+offset" from the enclosing symbol, "0x..." without one
+    std::string location_of(ui32 address) const;
+
+    std::vector<Symbol> const& get_symbols() const;
+
+private:
+
+    std::vector<Symbol> symbols;
+
+};
+
+}}
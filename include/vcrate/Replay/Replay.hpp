@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace vcrate { namespace replay {
+
+ui64 hash_of(vcx::Executable const& exe);
+
+// Everything a run depends on that doesn't come from the executable itself
+struct Recording {
+    static constexpr ui32 magic = 0x52524356; // "VCRR"
+    static constexpr ui32 version = 2;
+
+    ui64 executable_hash = 0;
+    ui32 seed = 0;
+    ui32 memory_size = 0;
+    // A trap goes to it instead of halting, so the replay must trap the same way
+    std::optional<ui32> trap_handler;
+
+    // Outcome of the recorded run, used to detect a divergent replay
+    ui64 instructions = 0;
+    ui32 halt_code = 0;
+
+    void save(std::ostream& os) const;
+    static std::optional<Recording> load(std::istream& is);
+};
+
+// Re-executes a recording, taking a checkpoint (a copy of the sandbox) every `checkpoint_period` instructions
+// so seeking backward only replays from the closest checkpoint
+// At most `max_checkpoints` are kept: past that every other one is dropped and the period doubles, so checkpoints
+// take at most `max_checkpoints` times the memory size of the recording (256 MiB for 16 MiB sandboxes), whatever
+// the length of the run. Seeking backward replays less than one period, which grows with the run.
+// std::rand isn't part of a checkpoint: it must be seeded with the recording's seed before the replayer is created
+class Replayer {
+public:
+
+    Replayer(vcx::Executable const& exe, Recording const& recording, ui64 checkpoint_period = 1 << 20, ui32 max_checkpoints = 16);
+
+    SandBox& get_sandbox();
+    interpreter::Counters& get_counters();
+    ui64 get_instruction() const;
+    bool is_halted() const;
+
+    void step();
+    void seek(ui64 instruction);
+
+private:
+
+    ui64 checkpoint_period;
+    ui32 max_checkpoints;
+
+    struct Checkpoint {
+        SandBox sandbox;
+        interpreter::Counters counters;
+    };
+
+    SandBox sandbox;
+    interpreter::Counters counters;
+    std::vector<Checkpoint> checkpoints;
+
+};
+
+}}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/Interpreter/DecodeCache.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vcrate { namespace sanitizer {
+
+enum class Kind : ui8 {
+    // An access to a block given back with DEL
+    UseAfterFree,
+    // A DEL of a block already given back
+    DoubleFree,
+    // A DEL of an address that isn't the start of a block
+    InvalidFree,
+    // An access next to a block or crossing its end, or to the stack below the sp
+    OutOfBounds,
+    // A read of a byte of a block or a word of the stack never written since it was allocated or pushed
+    Uninitialized
+};
+
+char const* to_string(Kind kind);
+
+struct Report {
+    Kind kind;
+    // Of the faulting instruction
+    ui32 pc;
+    // Of the access, or given to DEL
+    ui32 address;
+    // In bytes, 0 for a DEL
+    ui32 size;
+    bool write;
+    // Where the address is, relative to a block or the stack
+    std::string detail;
+    // Faults of the same kind by the same instruction, only the first one is described
+    ui64 count;
+};
+
+// Runs a program on the Interpreter, checking every access to memory against the state of the heap and the stack
+// The sanitizer runs NEW and DEL itself. Blocks get a redzone after them, so an access past the end doesn't land
+// in the next block, and a bit per byte telling if it was written. A freed block stays in a quarantine, given back
+// to the sandbox only once enough memory is freed after it, and is remembered until a NEW gives its memory again.
+// The stack is followed from the sp, with a bit per word. Memory outside of the blocks and of the stack (the code,
+// the data and whatever a program uses by address) isn't checked, unless it lies between the first and last blocks
+// allocated. A DEL of an invalid address is reported and does nothing.
+// It's a separate engine: the Interpreter and the VerifiedInterpreter don't check anything.
+class Sanitizer {
+public:
+
+    // In bytes
+    static constexpr ui32 redzone = 16;
+    static constexpr ui32 quarantine_size = 1 << 20;
+
+    // `sandbox` must hold `exe`, as SandBox::load_executable leaves it, nothing allocated yet
+    Sanitizer(vcx::Executable const& exe, SandBox const& sandbox);
+
+    // Runs until the sandbox is halted
+    void run(SandBox& sandbox, interpreter::Counters& counters);
+    void run_next_instruction(SandBox& sandbox, interpreter::Counters& counters);
+
+    // In the order they were first found
+    std::vector<Report> const& get_reports() const;
+    // One line per report, with the location of its instruction and of the block it's about
+    void report(std::ostream& os) const;
+
+private:
+
+    struct Block {
+        ui32 size;
+        // Pcs of the NEW, and of the DEL once freed
+        ui32 allocated_at;
+        ui32 freed_at;
+        bool live;
+        // One per byte
+        std::vector<bool> written;
+    };
+
+    // Checks the accesses of `d` to memory through its arguments and the stack, before it runs
+    // False if it was run by the sanitizer instead of the Interpreter
+    bool before(SandBox& sandbox, interpreter::Counters& counters, program::DecodedInstruction const& d);
+    void after(SandBox const& sandbox, program::DecodedInstruction const& d, ui32 sp);
+
+    void access(ui32 address, ui32 size, bool write);
+    void allocate(SandBox& sandbox, interpreter::Counters& counters, program::DecodedInstruction const& d);
+    void free(SandBox& sandbox, interpreter::Counters& counters, ui32 address);
+    void fault(Kind kind, ui32 address, ui32 size, bool write, std::string detail);
+
+    // "the block of 16 bytes at 1024 allocated at 8 in main+8"
+    std::string describe(ui32 address, Block const& block) const;
+
+    program::SymbolIndex symbols;
+    interpreter::DecodeCache cache;
+
+    std::map<ui32, Block> blocks;
+    std::map<ui32, Block> freed;
+    // Freed blocks not given back to the sandbox yet, oldest first
+    std::deque<ui32> quarantine;
+    ui64 quarantined = 0;
+    // Of all the blocks allocated so far
+    ui32 heap_begin = ~0u;
+    ui32 heap_end = 0;
+
+    ui32 stack_base;
+    ui32 lowest_sp;
+    // One per word from the stack base down to the sp, the first one is right below the base
+    std::vector<bool> stack_written;
+
+    // Of the instruction being checked
+    ui32 pc = 0;
+    std::vector<Report> reports;
+    std::map<std::pair<Kind, ui32>, ui32> report_indices;
+
+};
+
+}}
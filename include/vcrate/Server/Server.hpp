@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Coverage/Coverage.hpp>
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+
+namespace vcrate { namespace server {
+
+// What a client asks for, one executable run
+struct Request {
+    // Of an executable in either encoding, as main reads it, resolved by the server
+    std::string path;
+    // Copied to a heap block before running, with its address in A and its size in B
+    std::string input;
+    // 0 for no limit
+    ui64 max_instructions = 0;
+    // In bytes, 0 for the size of the server
+    ui32 memory_size = 0;
+};
+
+enum class Status : ui8 {
+    Halted,
+    // The executable couldn't be read, `message` tells why
+    LoadError,
+    // The frame couldn't be decoded, the memory size is over the limit of the server, the input doesn't fit
+    // in the sandbox or the run failed, `message` tells why
+    InvalidRequest,
+    // Stopped after `max_instructions`, not halted
+    LimitReached,
+    // Halted by a trap, `message` tells which
+    Trapped
+};
+
+char const* to_string(Status status);
+
+struct Response {
+    Status status = Status::Halted;
+    // Register A once stopped
+    ui32 halt_code = 0;
+    ui64 instructions = 0;
+    // Everything the program wrote with OUT and the DBG operations
+    std::string output;
+    std::string message;
+};
+
+// Frames on the socket are a 32 bits little endian size followed by that many bytes
+// A request is the magic "VCRQ", the path and the input (each a 32 bits size and the bytes), then
+// max_instructions on 64 bits and memory_size on 32 bits.
+// A response is the magic "VCRS", the status on 8 bits, the halt code on 32 bits, the instructions
+// on 64 bits, then the output and the message, sized like the strings of a request.
+// A connection can send any number of requests, each one answered before the next is read.
+std::string encode(Request const& request);
+std::string encode(Response const& response);
+std::optional<Request> decode_request(std::string const& frame);
+std::optional<Response> decode_response(std::string const& frame);
+
+// Sends one request to the server listening on `socket_path`, std::nullopt if the connection failed
+std::optional<Response> send(std::string const& socket_path, Request const& request);
+
+struct Options {
+    std::string socket_path;
+    // Connections served at the same time
+    ui32 workers = 4;
+    // Of the sandboxes, unless a request asks for another size
+    ui32 memory_size = 1 << 24;
+    // Largest size a request can ask for, in bytes
+    ui32 max_memory_size = 1 << 28;
+    // Of a cache::DiskCache read before an executable is decoded, none if empty
+    std::string cache_directory;
+};
+
+// A long lived interpreter serving run requests over a Unix domain socket
+// Executables are cached by path: one is read, decoded and verified once by the first request for it,
+// and again only once the modification time or the size of its file changed. A file that can't be read
+// stays an error until it changes too. With a cache directory, even the first request of a server finds
+// it decoded if another run did it before. A verified executable runs on the VerifiedInterpreter, the
+// others on the Interpreter with a DecodeCache. Sandboxes of the default size come from a SandBoxPool
+// of the executable, so a request doesn't load it again either.
+// While a Server exists, std::cout goes through a buffer sending the output of a request to its response,
+// and the rest to where std::cout went before. Only one Server should exist at a time.
+class Server {
+public:
+
+    explicit Server(Options options);
+    ~Server();
+
+    Server(Server const&) = delete;
+    Server& operator=(Server const&) = delete;
+
+    // Runs one request in the calling thread, an exception while doing it becomes an InvalidRequest
+    // With a coverage, what the run covers is or-ed into it. It starts over if it was of another executable.
+    Response handle(Request const& request, coverage::Coverage* coverage = nullptr);
+
+    // Listens on the socket and serves connections on `workers` threads until accepting fails
+    // False if the socket couldn't be listened on. Messages go to `log`.
+    bool serve(std::ostream& log);
+
+    // Executables read since the server started, the other requests found theirs in the cache
+    ui64 get_loads() const;
+
+private:
+
+    struct Loaded;
+
+    struct Loading {
+        // nullptr if the executable couldn't be read, `error` tells why
+        std::shared_ptr<Loaded> loaded;
+        std::string error;
+    };
+
+    struct Cached {
+        i64 modified;
+        i64 size;
+        std::shared_future<Loading> loading;
+    };
+
+    // nullptr with `error` set if the executable couldn't be read
+    std::shared_ptr<Loaded> load(std::string const& path, std::string& error);
+    Loading read(std::string const& path) const;
+    Response run(Request const& request, coverage::Coverage* coverage);
+    void serve_connection(int client);
+
+    Options options;
+
+    std::unique_ptr<std::streambuf> capture;
+    std::streambuf* previous;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Cached> cache;
+    ui64 loads = 0;
+
+};
+
+}}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Sandbox/SandBox.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <istream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vcrate { namespace trace {
+
+// State of the sandbox just before an instruction is executed
+// Records are written in the host byte order
+struct TraceRecord {
+    static constexpr ui32 flag_zero = 1 << 0;
+    static constexpr ui32 flag_greater = 1 << 1;
+
+    ui32 pc;
+    ui32 instruction[3];
+    ui32 values[2];
+    ui32 flags;
+    ui32 sp;
+};
+
+static_assert(sizeof(TraceRecord) == 32, "Trace records must stay compact");
+
+struct TraceHeader {
+    static constexpr ui32 expected_magic = 0x52544356; // "VCTR"
+    static constexpr ui32 expected_version = 1;
+
+    ui32 magic = expected_magic;
+    ui32 version = expected_version;
+    ui32 record_size = sizeof(TraceRecord);
+    ui32 reserved = 0;
+};
+
+// The interpreter thread fills a single producer/single consumer ring buffer
+// which is written to the file by a background thread
+// When the buffer is full, the interpreter waits for the writer instead of dropping records
+class TraceWriter {
+public:
+
+    // Records nothing if the file can't be opened
+    TraceWriter(std::string const& file, ui32 capacity = 1 << 16);
+    ~TraceWriter();
+
+    TraceWriter(TraceWriter const&) = delete;
+    TraceWriter& operator = (TraceWriter const&) = delete;
+
+    bool is_open() const;
+
+    void record(SandBox const& sandbox);
+
+private:
+
+    void flush_loop();
+
+    std::ofstream os;
+    std::vector<TraceRecord> ring;
+    ui64 mask;
+
+    alignas(64) std::atomic<ui64> head;
+    alignas(64) std::atomic<ui64> tail;
+    std::atomic<bool> done;
+
+    std::thread writer;
+
+};
+
+class TraceReader {
+public:
+
+    TraceReader(std::istream& is);
+
+    bool is_valid() const;
+    // Records have a fixed size, the next one read is the `index`-th
+    bool seek(ui64 index);
+    bool next(TraceRecord& record);
+
+private:
+
+    std::istream& is;
+    TraceHeader header;
+    bool valid;
+
+};
+
+}}
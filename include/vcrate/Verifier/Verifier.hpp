@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vcrate/Alias.hpp>
+
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vcrate { namespace verifier {
+
+struct Issue {
+    enum class Severity { Error, Warning };
+
+    Severity severity;
+    ui32 pc;
+    std::string message;
+};
+
+std::string to_string(Issue::Severity severity);
+
+// Checks, without running it, that the program:
+// - only contains known operations, each fitting in the code
+// - never writes to a Value argument and never takes the address of a Register or a Value
+// - only uses register pairs that exist for the wide operations
+// - jumps and calls, when the target is known, to instruction boundaries, and starts on one
+// - never writes to its own code through an absolute address
+// - keeps the stack balanced in every function: same depth on every path, nothing popped below
+//   the return address, LVE matching an ETR and the depth back to zero at each RET
+// Indirect jumps and stack pointer changes outside of a frame can't be followed, they are warnings
+std::vector<Issue> verify(vcx::Executable const& exe, program::Program const& program);
+
+bool has_errors(std::vector<Issue> const& issues);
+
+void print_issues(std::ostream& os, std::vector<Issue> const& issues, vcx::Executable const& exe);
+
+}}
@@ -0,0 +1,358 @@
+#include <vcrate/Analysis/ControlFlowGraph.hpp>
+
+#include <vcrate/Interpreter/WideInstruction.hpp>
+
+#include <algorithm>
+
+namespace vcrate { namespace analysis {
+
+using program::DecodedInstruction;
+
+namespace {
+
+bool ends_block(DecodedInstruction const& d) {
+    return !d.valid || program::is_jump(d) || program::is_call(d) || program::is_return(d) || program::is_halt(d)
+        || program::writes_register(d, instruction::Register::PC.id);
+}
+
+void sort_unique(std::vector<ui32>& v) {
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+}
+
+ControlFlowGraph::ControlFlowGraph(vcx::Executable const& exe, program::Program const& program) : program(program) {
+    build_blocks(exe);
+    link(exe);
+    find_reachable();
+    compute_dominators();
+    find_loops();
+}
+
+void ControlFlowGraph::build_blocks(vcx::Executable const& exe) {
+    auto const& instructions = program.get_instructions();
+    std::vector<bool> leaders(instructions.size(), false);
+
+    auto mark = [this, &leaders] (ui32 pc) {
+        auto index = program.index_of(pc);
+        if (index != program::Program::invalid_index)
+            leaders[index] = true;
+    };
+
+    mark(0);
+    mark(exe.entry_point);
+    for(auto pc : exe.jmp_table)
+        mark(pc);
+    for(auto const& s : exe.symbols)
+        mark(s.second);
+
+    for(ui32 i = 0; i < instructions.size(); ++i) {
+        auto const& d = instructions[i];
+        if (ends_block(d) && i + 1 < instructions.size())
+            leaders[i + 1] = true;
+        if (program::has_static_target(d))
+            mark(program::static_target_of(d));
+    }
+
+    block_of_instruction.assign(instructions.size(), none);
+    for(ui32 i = 0; i < instructions.size(); ++i) {
+        if (leaders[i]) {
+            BasicBlock b;
+            b.first = i;
+            b.begin_pc = instructions[i].pc;
+            blocks.push_back(b);
+        }
+        auto& b = blocks.back();
+        b.last = i + 1;
+        b.end_pc = instructions[i].pc + instructions[i].size;
+        block_of_instruction[i] = blocks.size() - 1;
+    }
+}
+
+void ControlFlowGraph::link(vcx::Executable const& exe) {
+    auto const& instructions = program.get_instructions();
+
+    std::vector<ui32> table;
+    for(auto pc : exe.jmp_table)
+        if (block_of(pc) != none)
+            table.push_back(block_of(pc));
+    sort_unique(table);
+
+    for(ui32 id = 0; id < blocks.size(); ++id) {
+        auto& b = blocks[id];
+        auto const& d = instructions[b.last - 1];
+        ui32 next = b.last < instructions.size() ? block_of_instruction[b.last] : none;
+
+        auto add = [&b] (ui32 target) {
+            if (target != none)
+                b.successors.push_back(target);
+        };
+        auto add_table = [&b, &table] {
+            b.indirect = true;
+            b.successors.insert(b.successors.end(), table.begin(), table.end());
+        };
+
+        if (!d.valid || program::is_return(d) || program::is_halt(d)) {
+            // Nothing follows
+        } else if (program::is_jump(d)) {
+            if (program::has_static_target(d))
+                add(block_of(program::static_target_of(d)));
+            else
+                add_table();
+            if (program::is_conditional_jump(d))
+                add(next);
+        } else if (program::is_call(d)) {
+            if (program::has_static_target(d) && block_of(program::static_target_of(d)) != none)
+                b.callees.push_back(block_of(program::static_target_of(d)));
+            add(next);
+        } else if (program::writes_register(d, instruction::Register::PC.id)) {
+            add_table();
+        } else {
+            add(next);
+        }
+
+        sort_unique(b.successors);
+    }
+
+    for(ui32 id = 0; id < blocks.size(); ++id)
+        for(auto s : blocks[id].successors)
+            blocks[s].predecessors.push_back(id);
+
+    auto add_entry = [this] (ui32 pc) {
+        if (block_of(pc) != none)
+            entries.push_back(block_of(pc));
+    };
+    add_entry(exe.entry_point);
+    for(auto pc : exe.jmp_table)
+        add_entry(pc);
+    for(auto const& s : exe.symbols)
+        add_entry(s.second);
+    sort_unique(entries);
+
+    roots = entries;
+    for(auto const& b : blocks)
+        roots.insert(roots.end(), b.callees.begin(), b.callees.end());
+    sort_unique(roots);
+}
+
+void ControlFlowGraph::find_reachable() {
+    std::vector<ui32> pending;
+    auto visit = [this, &pending] (ui32 id) {
+        if (!blocks[id].reachable) {
+            blocks[id].reachable = true;
+            pending.push_back(id);
+        }
+    };
+
+    for(auto e : entries)
+        visit(e);
+    while(!pending.empty()) {
+        auto id = pending.back();
+        pending.pop_back();
+        for(auto s : blocks[id].successors)
+            visit(s);
+        for(auto c : blocks[id].callees)
+            visit(c);
+    }
+}
+
+// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+// A virtual block, numbered blocks.size(), precedes every root
+void ControlFlowGraph::compute_dominators() {
+    ui32 virtual_root = blocks.size();
+
+    std::vector<ui32> postorder;
+    std::vector<ui32> order(blocks.size() + 1, none);
+    {
+        std::vector<bool> seen(blocks.size(), false);
+        // Block and index of the next successor to visit
+        std::vector<std::pair<ui32, ui32>> stack;
+        for(auto r : roots) {
+            if (!blocks[r].reachable || seen[r])
+                continue;
+            seen[r] = true;
+            stack.push_back({ r, 0 });
+            while(!stack.empty()) {
+                auto& [id, next] = stack.back();
+                if (next < blocks[id].successors.size()) {
+                    auto s = blocks[id].successors[next++];
+                    if (!seen[s]) {
+                        seen[s] = true;
+                        stack.push_back({ s, 0 });
+                    }
+                } else {
+                    order[id] = postorder.size();
+                    postorder.push_back(id);
+                    stack.pop_back();
+                }
+            }
+        }
+    }
+    order[virtual_root] = postorder.size();
+
+    std::vector<ui32> idom(blocks.size() + 1, none);
+    idom[virtual_root] = virtual_root;
+
+    auto intersect = [&idom, &order] (ui32 a, ui32 b) {
+        while(a != b) {
+            while(order[a] < order[b])
+                a = idom[a];
+            while(order[b] < order[a])
+                b = idom[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+            auto id = *it;
+            ui32 new_idom = std::binary_search(roots.begin(), roots.end(), id) ? virtual_root : none;
+            for(auto p : blocks[id].predecessors) {
+                if (idom[p] == none)
+                    continue;
+                new_idom = new_idom == none ? p : intersect(p, new_idom);
+            }
+            if (new_idom != idom[id]) {
+                idom[id] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    for(ui32 id = 0; id < blocks.size(); ++id)
+        blocks[id].immediate_dominator = idom[id] == virtual_root ? none : idom[id];
+}
+
+// Natural loops, the ones sharing a header are merged
+void ControlFlowGraph::find_loops() {
+    for(ui32 id = 0; id < blocks.size(); ++id) {
+        if (!blocks[id].reachable)
+            continue;
+        for(auto header : blocks[id].successors) {
+            if (!dominates(header, id))
+                continue;
+
+            auto it = std::find_if(loops.begin(), loops.end(), [header] (Loop const& l) { return l.header == header; });
+            if (it == loops.end()) {
+                loops.push_back(Loop { header, { header }, {} });
+                it = loops.end() - 1;
+            }
+            auto& loop = *it;
+            loop.latches.push_back(id);
+
+            std::vector<ui32> pending { id };
+            while(!pending.empty()) {
+                auto b = pending.back();
+                pending.pop_back();
+                if (std::find(loop.blocks.begin(), loop.blocks.end(), b) != loop.blocks.end())
+                    continue;
+                loop.blocks.push_back(b);
+                for(auto p : blocks[b].predecessors)
+                    if (blocks[p].reachable)
+                        pending.push_back(p);
+            }
+        }
+    }
+
+    for(auto& loop : loops) {
+        sort_unique(loop.blocks);
+        sort_unique(loop.latches);
+    }
+
+    auto contains = [] (Loop const& l, ui32 block) {
+        return std::binary_search(l.blocks.begin(), l.blocks.end(), block);
+    };
+
+    // The parent is the smallest other loop holding the header
+    for(ui32 i = 0; i < loops.size(); ++i) {
+        for(ui32 j = 0; j < loops.size(); ++j) {
+            if (i == j || !contains(loops[j], loops[i].header) || loops[j].blocks.size() <= loops[i].blocks.size())
+                continue;
+            if (loops[i].parent == none || loops[j].blocks.size() < loops[loops[i].parent].blocks.size())
+                loops[i].parent = j;
+        }
+    }
+
+    for(auto& loop : loops)
+        for(auto p = loop.parent; p != none; p = loops[p].parent)
+            ++loop.depth;
+
+    for(ui32 i = 0; i < loops.size(); ++i)
+        for(auto b : loops[i].blocks)
+            if (blocks[b].loop == none || loops[i].depth > loops[blocks[b].loop].depth)
+                blocks[b].loop = i;
+}
+
+std::vector<BasicBlock> const& ControlFlowGraph::get_blocks() const {
+    return blocks;
+}
+
+std::vector<Loop> const& ControlFlowGraph::get_loops() const {
+    return loops;
+}
+
+std::vector<ui32> const& ControlFlowGraph::get_roots() const {
+    return roots;
+}
+
+ui32 ControlFlowGraph::block_of(ui32 pc) const {
+    auto index = program.index_of(pc);
+    if (index == program::Program::invalid_index)
+        return none;
+    return block_of_instruction[index];
+}
+
+bool ControlFlowGraph::dominates(ui32 a, ui32 b) const {
+    if (!blocks[a].reachable || !blocks[b].reachable)
+        return false;
+    for(; b != none; b = blocks[b].immediate_dominator)
+        if (a == b)
+            return true;
+    return false;
+}
+
+ui32 ControlFlowGraph::loop_depth(ui32 block) const {
+    auto loop = blocks[block].loop;
+    return loop == none ? 0 : loops[loop].depth;
+}
+
+void ControlFlowGraph::to_dot(std::ostream& os, vcx::Executable const& exe) const {
+    auto const& instructions = program.get_instructions();
+    auto word_at = [&exe] (ui32 word) { return word < exe.code.size() ? exe.code[word] : 0; };
+
+    os << "digraph cfg {\n";
+    os << "    node [shape=box, fontname=monospace];\n";
+    for(ui32 id = 0; id < blocks.size(); ++id) {
+        auto const& b = blocks[id];
+        os << "    b" << id << " [label=\"";
+        for(auto const& s : exe.symbols)
+            if (s.second == b.begin_pc)
+                os << s.first << ":\\l";
+        for(ui32 i = b.first; i < b.last; ++i) {
+            auto w = instructions[i].pc / 4;
+            auto text = interpreter::instruction_to_string(word_at(w), word_at(w + 1), word_at(w + 2));
+            os << instructions[i].pc << ": ";
+            for(auto c : text)
+                os << (c == '"' || c == '\\' ? "\\" : "") << c;
+            os << "\\l";
+        }
+        os << "\"";
+        if (!b.reachable)
+            os << ", color=gray, fontcolor=gray";
+        else if (std::any_of(loops.begin(), loops.end(), [id] (Loop const& l) { return l.header == id; }))
+            os << ", penwidth=2";
+        os << "];\n";
+    }
+    for(ui32 id = 0; id < blocks.size(); ++id) {
+        for(auto s : blocks[id].successors)
+            os << "    b" << id << " -> b" << s << (blocks[id].indirect ? " [style=dotted]" : "") << ";\n";
+        for(auto c : blocks[id].callees)
+            os << "    b" << id << " -> b" << c << " [style=dashed];\n";
+    }
+    os << "}\n";
+}
+
+}}
@@ -0,0 +1,193 @@
+#include <vcrate/Batch/Batch.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace vcrate { namespace batch {
+
+namespace {
+
+void put_32(std::string& s, ui32 v) {
+    for(ui32 i = 0; i < 4; ++i)
+        s.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+void put_string(std::string& s, std::string const& v) {
+    put_32(s, v.size());
+    s += v;
+}
+
+// Tabs and line breaks would split the line of a result
+std::string escaped(std::string const& message) {
+    std::string s = message;
+    std::replace(s.begin(), s.end(), '\t', ' ');
+    std::replace(s.begin(), s.end(), '\n', ' ');
+    return s;
+}
+
+}
+
+InputReader::InputReader(std::string const& path) {
+    std::error_code error;
+    if (std::filesystem::is_directory(path, error)) {
+        for(auto const& entry : std::filesystem::directory_iterator(path, error)) {
+            if (entry.is_regular_file(error))
+                listed.push_back({ entry.path().filename().string(), entry.path().string(), "" });
+        }
+        open = !error;
+        std::sort(listed.begin(), listed.end(), [] (Input const& a, Input const& b) { return a.name < b.name; });
+        return;
+    }
+
+    lines.open(path, std::ios::binary);
+    open = lines.is_open();
+}
+
+InputReader::InputReader(std::vector<Input> inputs) : listed(std::move(inputs)) {}
+
+bool InputReader::is_open() const {
+    return open;
+}
+
+std::optional<Input> InputReader::next() {
+    if (!lines.is_open()) {
+        if (position >= listed.size())
+            return std::nullopt;
+        return std::move(listed[position++]);
+    }
+
+    std::string line;
+    if (!std::getline(lines, line))
+        return std::nullopt;
+    return Input{ std::to_string(++position), "", std::move(line) };
+}
+
+ResultWriter::ResultWriter(std::string const& output) : to_stream(output == "-") {
+    if (to_stream)
+        return;
+    std::error_code error;
+    std::filesystem::create_directories(output, error);
+    directory = output;
+    results.open((std::filesystem::path(directory) / "results.tsv").string());
+}
+
+bool ResultWriter::is_open() const {
+    return to_stream || results.is_open();
+}
+
+bool ResultWriter::good() const {
+    return ok;
+}
+
+void ResultWriter::write(Input const& input, server::Response const& response) {
+    if (to_stream) {
+        std::string frame;
+        put_string(frame, input.name);
+        frame += server::encode(response);
+        std::string sized;
+        put_string(sized, frame);
+        ok = std::cout.write(sized.data(), sized.size()) && ok;
+        return;
+    }
+
+    std::ofstream os(std::filesystem::path(directory) / (input.name + ".out"), std::ios::binary);
+    os.write(response.output.data(), response.output.size());
+    results << input.name << '\t' << server::to_string(response.status) << '\t' << response.halt_code << '\t'
+            << response.instructions << '\t' << escaped(response.message) << '\n';
+    ok = os && results && ok;
+}
+
+Summary run(server::Server& server, std::string const& path, InputReader& inputs, ResultWriter& writer, ui32 workers,
+            ui64 max_instructions, coverage::Coverage* coverage) {
+    workers = std::max(workers, 1u);
+    ui64 const window = 4 * workers;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    // With the name of their input, the rest of it is dropped once run
+    std::map<ui64, std::pair<std::string, server::Response>> finished;
+    ui64 next = 0;
+    ui64 written = 0;
+    bool exhausted = false;
+
+    std::vector<std::thread> threads;
+    for(ui32 w = 0; w < workers; ++w) {
+        threads.emplace_back([&] {
+            coverage::Coverage covered;
+            for(;;) {
+                ui64 i;
+                std::optional<Input> input;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&] { return exhausted || next < written + window; });
+                    if (!exhausted)
+                        input = inputs.next();
+                    if (!input) {
+                        exhausted = true;
+                        changed.notify_all();
+                        if (coverage)
+                            coverage->merge(covered);
+                        return;
+                    }
+                    i = next++;
+                }
+
+                server::Request request;
+                request.path = path;
+                request.max_instructions = max_instructions;
+                server::Response response;
+                if (input->path.empty()) {
+                    request.input = std::move(input->contents);
+                    response = server.handle(request, coverage ? &covered : nullptr);
+                } else if (std::ifstream is{ input->path, std::ios::binary }) {
+                    request.input.assign(std::istreambuf_iterator<char>(is), {});
+                    response = server.handle(request, coverage ? &covered : nullptr);
+                } else {
+                    response.status = server::Status::InvalidRequest;
+                    response.message = "File (" + input->path + ") couldn't be opened";
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.emplace(i, std::make_pair(std::move(input->name), std::move(response)));
+                changed.notify_all();
+            }
+        });
+    }
+
+    Summary summary;
+    for(;;) {
+        Input input;
+        server::Response response;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return finished.count(written) > 0 || (exhausted && written == next); });
+            auto it = finished.find(written);
+            if (it == finished.end())
+                break;
+            input.name = std::move(it->second.first);
+            response = std::move(it->second.second);
+            finished.erase(it);
+        }
+
+        writer.write(input, response);
+        ++summary.runs;
+        if (response.status != server::Status::Halted)
+            ++summary.failures;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++written;
+        changed.notify_all();
+    }
+
+    for(auto& thread : threads)
+        thread.join();
+    return summary;
+}
+
+}}
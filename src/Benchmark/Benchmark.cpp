@@ -0,0 +1,274 @@
+#include <vcrate/Benchmark/Benchmark.hpp>
+
+#include <vcrate/Interpreter/Interpreter.hpp>
+#include <vcrate/Interpreter/VerifiedInterpreter.hpp>
+#include <vcrate/Pool/SandBoxPool.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+
+namespace vcrate { namespace benchmark {
+
+namespace {
+
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+}
+
+std::vector<Engine> const& engines() {
+    static std::vector<Engine> engines {
+        { "interpreter", [] (vcx::Executable const&, SandBox& sandbox, interpreter::Counters& counters) {
+            interpreter::Interpreter::run(sandbox, counters);
+        } },
+        { "cached", [] (vcx::Executable const& exe, SandBox& sandbox, interpreter::Counters& counters) {
+            interpreter::DecodeCache cache(exe);
+            interpreter::Interpreter::run(sandbox, counters, cache);
+        } },
+        { "verified", [] (vcx::Executable const& exe, SandBox& sandbox, interpreter::Counters& counters) {
+            program::Program program(exe);
+            if (verifier::has_errors(verifier::verify(exe, program)))
+                throw std::runtime_error("The executable doesn't pass the verifier");
+            interpreter::VerifiedInterpreter::run(program, sandbox, counters);
+        } }
+    };
+    return engines;
+}
+
+f64 Result::median() const {
+    if (durations.empty())
+        return 0;
+    auto sorted = durations;
+    std::sort(sorted.begin(), sorted.end());
+    auto middle = sorted.size() / 2;
+    return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+}
+
+f64 Result::min() const {
+    return durations.empty() ? 0 : *std::min_element(durations.begin(), durations.end());
+}
+
+f64 Result::max() const {
+    return durations.empty() ? 0 : *std::max_element(durations.begin(), durations.end());
+}
+
+f64 Result::ns_per_instruction() const {
+    return instructions ? median() / instructions : 0;
+}
+
+f64 Result::instructions_per_second() const {
+    auto m = median();
+    return m > 0 ? instructions / m * 1'000'000'000. : 0;
+}
+
+Result measure(Kernel const& kernel, Engine const& engine, Options const& options) {
+    Result result;
+    result.kernel = kernel.name;
+    result.engine = engine.name;
+
+    NullBuffer null;
+    std::ostringstream output;
+    pool::SandBoxPool pool(kernel.exe, options.memory_size, 1);
+    for(ui32 i = 0; i < options.warmup + options.repetitions; ++i) {
+        auto sandbox = pool.acquire();
+        interpreter::Counters counters(*sandbox);
+
+        auto old = std::cout.rdbuf(i == 0 ? output.rdbuf() : static_cast<std::streambuf*>(&null));
+        auto start = std::chrono::steady_clock::now();
+        engine.run(kernel.exe, *sandbox, counters);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout.rdbuf(old);
+
+        if (i >= options.warmup)
+            result.durations.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        result.instructions = counters.instructions;
+        result.halt_code = sandbox->get_register(0);
+    }
+    result.output = output.str();
+
+    return result;
+}
+
+void print_results(std::ostream& os, std::vector<Result> const& results) {
+    std::ios old_state(nullptr);
+    old_state.copyfmt(os);
+
+    os << std::left << std::setw(24) << "Kernel" << std::setw(14) << "Engine" << std::right
+       << std::setw(14) << "Instructions" << std::setw(12) << "Median ms"
+       << std::setw(10) << "Spread" << std::setw(12) << "ns/instr" << std::setw(14) << "Minstr/s" << '\n';
+
+    os << std::fixed;
+    for(auto const& r : results) {
+        auto median = r.median();
+        os << std::left << std::setw(24) << r.kernel << std::setw(14) << r.engine << std::right
+           << std::setw(14) << r.instructions
+           << std::setw(12) << std::setprecision(3) << median / 1'000'000.
+           << std::setw(8) << std::setprecision(1) << (median > 0 ? 100. * (r.max() - r.min()) / median : 0.) << " %"
+           << std::setw(12) << std::setprecision(2) << r.ns_per_instruction()
+           << std::setw(14) << std::setprecision(2) << r.instructions_per_second() / 1'000'000. << '\n';
+    }
+
+    os.copyfmt(old_state);
+}
+
+bool print_comparison(std::ostream& os, std::vector<Result> const& results) {
+    std::vector<std::string> kernels;
+    std::vector<std::string> engine_names;
+    for(auto const& r : results) {
+        if (std::find(kernels.begin(), kernels.end(), r.kernel) == kernels.end())
+            kernels.push_back(r.kernel);
+        if (std::find(engine_names.begin(), engine_names.end(), r.engine) == engine_names.end())
+            engine_names.push_back(r.engine);
+    }
+
+    std::ios old_state(nullptr);
+    old_state.copyfmt(os);
+
+    os << std::left << std::setw(24) << "Program" << std::right;
+    for(auto const& e : engine_names)
+        os << std::setw(24) << e + " ms";
+    os << '\n';
+
+    bool same = true;
+    os << std::fixed;
+    for(auto const& k : kernels) {
+        os << std::left << std::setw(24) << k << std::right;
+        Result const* reference = nullptr;
+        for(auto const& e : engine_names) {
+            auto it = std::find_if(results.begin(), results.end(), [&] (Result const& r) { return r.kernel == k && r.engine == e; });
+            if (it == results.end()) {
+                os << std::setw(24) << "-";
+                continue;
+            }
+            if (!reference)
+                reference = &*it;
+
+            std::ostringstream cell;
+            cell << std::fixed << std::setprecision(3) << it->median() / 1'000'000.;
+            if (it->output != reference->output || it->halt_code != reference->halt_code) {
+                cell << " (mismatch)";
+                same = false;
+            } else if (reference != &*it && it->median() > 0) {
+                cell << " (x" << std::setprecision(2) << reference->median() / it->median() << ")";
+            }
+            os << std::setw(24) << cell.str();
+        }
+        os << '\n';
+    }
+
+    os.copyfmt(old_state);
+    return same;
+}
+
+namespace {
+
+constexpr char const* results_header = "kernel\tengine\tinstructions\tmedian_ns\tmin_ns\tmax_ns\tdurations_ns";
+
+}
+
+void save_results(std::ostream& os, std::vector<Result> const& results) {
+    os << results_header << '\n';
+    os << std::fixed << std::setprecision(0);
+    for(auto const& r : results) {
+        os << r.kernel << '\t' << r.engine << '\t' << r.instructions << '\t'
+           << r.median() << '\t' << r.min() << '\t' << r.max() << '\t';
+        for(ui32 i = 0; i < r.durations.size(); ++i)
+            os << (i ? "," : "") << r.durations[i];
+        os << '\n';
+    }
+}
+
+std::optional<std::vector<Result>> load_results(std::istream& is) {
+    std::string line;
+    if (!std::getline(is, line) || line != results_header)
+        return {};
+
+    std::vector<Result> results;
+    while(std::getline(is, line)) {
+        if (line.empty())
+            continue;
+
+        std::istringstream fields(line);
+        Result r;
+        std::string median, min, max, durations;
+        std::getline(fields, r.kernel, '\t');
+        std::getline(fields, r.engine, '\t');
+        fields >> r.instructions >> median >> min >> max >> durations;
+        if (fields.fail())
+            return {};
+
+        std::istringstream values(durations);
+        std::string value;
+        while(std::getline(values, value, ',')) {
+            char* end = nullptr;
+            auto duration = std::strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0')
+                return {};
+            r.durations.push_back(duration);
+        }
+        if (r.durations.empty())
+            return {};
+
+        results.push_back(std::move(r));
+    }
+    return results;
+}
+
+bool check_regressions(std::ostream& os, std::vector<Result> const& baseline, std::vector<Result> const& results, f64 tolerance) {
+    std::ios old_state(nullptr);
+    old_state.copyfmt(os);
+
+    os << std::left << std::setw(24) << "Kernel" << std::setw(14) << "Engine" << std::right
+       << std::setw(14) << "Baseline ms" << std::setw(12) << "Spread" << std::setw(14) << "Current ms"
+       << std::setw(12) << "Spread" << std::setw(10) << "Change" << "  Status\n";
+
+    auto spread_of = [] (Result const& r) {
+        auto median = r.median();
+        return median > 0 ? 100. * (r.max() - r.min()) / median : 0.;
+    };
+
+    bool ok = true;
+    os << std::fixed;
+    for(auto const& r : results) {
+        os << std::left << std::setw(24) << r.kernel << std::setw(14) << r.engine << std::right;
+
+        auto it = std::find_if(baseline.begin(), baseline.end(), [&r] (Result const& b) { return b.kernel == r.kernel && b.engine == r.engine; });
+        if (it == baseline.end()) {
+            os << std::setw(14) << "-" << std::setw(12) << "-" << std::setw(14) << std::setprecision(3) << r.median() / 1'000'000.
+               << std::setw(10) << std::setprecision(1) << spread_of(r) << " %" << std::setw(10) << "-" << "  new\n";
+            continue;
+        }
+
+        auto base = it->median();
+        auto change = base > 0 ? r.median() / base - 1 : 0.;
+        os << std::setw(14) << std::setprecision(3) << base / 1'000'000.
+           << std::setw(10) << std::setprecision(1) << spread_of(*it) << " %"
+           << std::setw(14) << std::setprecision(3) << r.median() / 1'000'000.
+           << std::setw(10) << std::setprecision(1) << spread_of(r) << " %"
+           << std::setw(8) << std::setprecision(1) << std::showpos << 100. * change << std::noshowpos << " %";
+
+        if (r.instructions != it->instructions) {
+            os << "  changed (" << it->instructions << " instructions in the baseline)\n";
+        } else if (change > tolerance && r.min() > base) {
+            os << "  REGRESSION\n";
+            ok = false;
+        } else {
+            os << "  ok\n";
+        }
+    }
+
+    os.copyfmt(old_state);
+    return ok;
+}
+
+}}
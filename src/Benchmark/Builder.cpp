@@ -0,0 +1,85 @@
+#include <vcrate/Benchmark/Builder.hpp>
+
+#include <limits>
+#include <stdexcept>
+
+namespace vcrate { namespace benchmark {
+
+namespace {
+
+constexpr ui32 unbound = std::numeric_limits<ui32>::max();
+
+template<typename I>
+void push_words(vcx::Executable& exe, I const& i) {
+    exe.code.push_back(i.get_main_instruction());
+    if (i.get_byte_size() > sizeof(ui32)) {
+        exe.code.push_back(i.get_first_extra());
+        if (i.get_byte_size() > 2 * sizeof(ui32)) {
+            exe.code.push_back(i.get_second_extra());
+        }
+    }
+}
+
+}
+
+ui32 Builder::here() const {
+    return exe.code.size() * sizeof(ui32);
+}
+
+void Builder::push(instruction::Instruction const& i) {
+    push_words(exe, i);
+}
+
+void Builder::push(interpreter::WideInstruction const& i) {
+    push_words(exe, i);
+}
+
+Builder::Label Builder::label() {
+    labels.push_back(unbound);
+    return labels.size() - 1;
+}
+
+void Builder::bind(Label label) {
+    labels.at(label) = here();
+}
+
+void Builder::bind(Label label, std::string const& symbol) {
+    bind(label);
+    exe.symbols[symbol] = here();
+}
+
+void Builder::jump(bytecode::Operations ope, Label label) {
+    push_relative(ope, label, false);
+}
+
+void Builder::call(Label label) {
+    push_relative(bytecode::Operations::CALL, label, true);
+}
+
+void Builder::address(instruction::Register reg, Label label) {
+    instruction::Instruction i(bytecode::Operations::MOV, reg, instruction::Value(std::numeric_limits<i32>::max()));
+    push(i);
+    fixups.push_back({ here() / 4 - 1, 0, label });
+}
+
+void Builder::push_relative(bytecode::Operations ope, Label label, bool from_next) {
+    // The placeholder doesn't fit in the instruction, so the offset always lives in the first extra word
+    instruction::Instruction i(ope, instruction::Value(std::numeric_limits<i32>::max()));
+    ui32 start = here();
+    push(i);
+    fixups.push_back({ start / 4 + 1, from_next ? here() : start, label });
+}
+
+vcx::Executable Builder::build(Label entry) {
+    for(auto const& f : fixups) {
+        if (labels.at(f.label) == unbound)
+            throw std::runtime_error("Label not bound");
+        exe.code[f.extra_word] = labels[f.label] - f.relative_to;
+    }
+    if (labels.at(entry) == unbound)
+        throw std::runtime_error("Label not bound");
+    exe.entry_point = labels[entry];
+    return exe;
+}
+
+}}
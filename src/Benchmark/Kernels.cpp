@@ -0,0 +1,216 @@
+#include <vcrate/Benchmark/Kernels.hpp>
+
+#include <vcrate/Benchmark/Builder.hpp>
+
+#include <cstring>
+#include <functional>
+
+namespace vcrate { namespace benchmark {
+
+using namespace instruction;
+using Ope = bytecode::Operations;
+using interpreter::WideInstruction;
+using interpreter::WideOperations;
+
+ui32 float_bits(f32 f) {
+    ui32 u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+namespace {
+
+// L counts the iterations down, the other registers are free for the kernel
+Kernel counted_loop(std::string const& name, ui32 iterations, std::function<void(Builder&)> const& setup, std::function<void(Builder&)> const& body) {
+    Builder b;
+    auto entry = b.label();
+    auto loop = b.label();
+
+    b.bind(entry, "main");
+    setup(b);
+    b.push(Instruction(Ope::MOV, Register::L, Value(iterations)));
+    b.bind(loop);
+    body(b);
+    b.push(Instruction(Ope::DEC, Register::L));
+    b.push(Instruction(Ope::CMP, Register::L, Value(0)));
+    b.jump(Ope::JMPNE, loop);
+    b.push(Instruction(Ope::HLT));
+
+    return { name, b.build(entry) };
+}
+
+void nothing(Builder&) {}
+
+void allocate_block(Builder& b) {
+    b.push(Instruction(Ope::NEW, Register::D, Value(64)));
+}
+
+Kernel read_kernel(std::string const& name, ui32 iterations, Argument const& arg) {
+    return counted_loop(name, iterations, allocate_block, [arg] (Builder& b) {
+        for(ui32 i = 0; i < 4; ++i)
+            b.push(Instruction(Ope::MOV, Register::A, arg));
+    });
+}
+
+Kernel write_kernel(std::string const& name, ui32 iterations, Argument const& arg) {
+    return counted_loop(name, iterations, allocate_block, [arg] (Builder& b) {
+        for(ui32 i = 0; i < 4; ++i)
+            b.push(Instruction(Ope::MOV, arg, Register::A));
+    });
+}
+
+// fib(A) in A, with a frame per call
+Kernel call_kernel(ui32 iterations) {
+    ui32 n = 2;
+    for(ui64 a = 1, b = 1, calls = 1; calls < iterations; ++n) {
+        calls = 2 * b - 1;
+        b = a + b;
+        a = b - a;
+    }
+
+    Builder b;
+    auto entry = b.label();
+    auto fib = b.label();
+    auto recurse = b.label();
+
+    b.bind(entry, "main");
+    b.push(Instruction(Ope::MOV, Register::A, Value(n)));
+    b.call(fib);
+    b.push(Instruction(Ope::HLT));
+
+    b.bind(fib, "fib");
+    b.push(Instruction(Ope::CMPU, Register::A, Value(2)));
+    b.jump(Ope::JMPGE, recurse);
+    b.push(Instruction(Ope::RET));
+    b.bind(recurse);
+    b.push(Instruction(Ope::ETR));
+    b.push(Instruction(Ope::PUSH, Register::A));
+    b.push(Instruction(Ope::DEC, Register::A));
+    b.call(fib);
+    b.push(Instruction(Ope::POP, Register::B));
+    b.push(Instruction(Ope::PUSH, Register::A));
+    b.push(Instruction(Ope::MOV, Register::A, Register::B));
+    b.push(Instruction(Ope::SUB, Register::A, Value(2)));
+    b.call(fib);
+    b.push(Instruction(Ope::POP, Register::B));
+    b.push(Instruction(Ope::ADD, Register::A, Register::B));
+    b.push(Instruction(Ope::LVE));
+    b.push(Instruction(Ope::RET));
+
+    return { "call-recursion", b.build(entry) };
+}
+
+// Calls through a register alternating between two methods, like a virtual call on a mixed collection
+Kernel indirect_call_kernel(ui32 iterations) {
+    Builder b;
+    auto entry = b.label();
+    auto loop = b.label();
+    auto first = b.label();
+    auto second = b.label();
+
+    b.bind(entry, "main");
+    b.address(Register::C, first);
+    b.address(Register::E, second);
+    b.push(Instruction(Ope::MOV, Register::L, Value(iterations)));
+    b.bind(loop);
+    b.push(Instruction(Ope::CALL, Register::C));
+    b.push(Instruction(Ope::SWP, Register::C, Register::E));
+    b.push(Instruction(Ope::DEC, Register::L));
+    b.push(Instruction(Ope::CMP, Register::L, Value(0)));
+    b.jump(Ope::JMPNE, loop);
+    b.push(Instruction(Ope::HLT));
+
+    b.bind(first, "first");
+    b.push(Instruction(Ope::ADD, Register::A, Value(1)));
+    b.push(Instruction(Ope::RET));
+    b.bind(second, "second");
+    b.push(Instruction(Ope::XOR, Register::A, Value(3)));
+    b.push(Instruction(Ope::RET));
+
+    return { "indirect-call", b.build(entry) };
+}
+
+}
+
+std::vector<Kernel> micro_kernels(ui32 iterations) {
+    std::vector<Kernel> kernels;
+
+    kernels.push_back(counted_loop("alu-loop", iterations, [] (Builder& b) {
+        b.push(Instruction(Ope::MOV, Register::B, Value(1)));
+        b.push(Instruction(Ope::MOV, Register::C, Value(3)));
+    }, [] (Builder& b) {
+        b.push(Instruction(Ope::ADD, Register::B, Register::C));
+        b.push(Instruction(Ope::XOR, Register::C, Register::B));
+        b.push(Instruction(Ope::MULU, Register::B, Value(3)));
+        b.push(Instruction(Ope::SHR, Register::C, Value(1)));
+    }));
+
+    kernels.push_back(counted_loop("dispatch-mix", iterations, nothing, [] (Builder& b) {
+        b.push(Instruction(Ope::INC, Register::A));
+        b.push(Instruction(Ope::AND, Register::B, Register::A));
+        b.push(Instruction(Ope::OR, Register::C, Value(5)));
+        b.push(Instruction(Ope::SUB, Register::C, Register::B));
+        b.push(Instruction(Ope::SWP, Register::B, Register::C));
+        b.push(Instruction(Ope::NOT, Register::E));
+        b.push(Instruction(Ope::RTL, Register::E, Value(3)));
+        b.push(Instruction(Ope::CMPU, Register::B, Register::C));
+        b.push(Instruction(Ope::DIVU, Register::E, Value(7)));
+        b.push(Instruction(Ope::MOD, Register::E, Value(5)));
+        b.push(Instruction(Ope::LEA, Register::F, Displacement(Register::F, 4)));
+        b.push(Instruction(Ope::ITF, Register::G));
+        b.push(Instruction(Ope::FTI, Register::G));
+    }));
+
+    kernels.push_back(read_kernel("read-register", iterations, Register::B));
+    kernels.push_back(read_kernel("read-value", iterations, Value(42)));
+    kernels.push_back(read_kernel("read-value-extra", iterations, Value(1 << 30)));
+    kernels.push_back(read_kernel("read-deferred", iterations, Deferred(Register::D)));
+    kernels.push_back(read_kernel("read-displacement", iterations, Displacement(Register::D, 8)));
+    kernels.push_back(read_kernel("read-address", iterations, Address(scratch_address)));
+
+    kernels.push_back(write_kernel("write-register", iterations, Register::B));
+    kernels.push_back(write_kernel("write-deferred", iterations, Deferred(Register::D)));
+    kernels.push_back(write_kernel("write-displacement", iterations, Displacement(Register::D, 8)));
+    kernels.push_back(write_kernel("write-address", iterations, Address(scratch_address)));
+
+    kernels.push_back(call_kernel(iterations));
+    kernels.push_back(indirect_call_kernel(iterations));
+
+    kernels.push_back(counted_loop("new-del", iterations, nothing, [] (Builder& b) {
+        b.push(Instruction(Ope::NEW, Register::B, Value(64)));
+        b.push(Instruction(Ope::MOV, Deferred(Register::B), Register::L));
+        b.push(Instruction(Ope::DEL, Register::B));
+    }));
+
+    kernels.push_back(counted_loop("out-stream", iterations, nothing, [] (Builder& b) {
+        b.push(Instruction(Ope::OUT, Value('v')));
+        b.push(Instruction(Ope::OUT, Value('c')));
+        b.push(Instruction(Ope::OUT, Value('x')));
+        b.push(Instruction(Ope::OUT, Value('\n')));
+    }));
+
+    kernels.push_back(counted_loop("float-math", iterations, [] (Builder& b) {
+        b.push(Instruction(Ope::MOV, Register::B, Value(float_bits(1.f))));
+        b.push(Instruction(Ope::MOV, Register::C, Value(float_bits(1.0001f))));
+    }, [] (Builder& b) {
+        b.push(Instruction(Ope::MULF, Register::B, Register::C));
+        b.push(Instruction(Ope::ADDF, Register::B, Register::C));
+        b.push(Instruction(Ope::DIVF, Register::B, Register::C));
+        b.push(Instruction(Ope::SUBF, Register::B, Register::C));
+        b.push(Instruction(Ope::INCF, Register::B));
+    }));
+
+    kernels.push_back(counted_loop("wide-math", iterations, [] (Builder& b) {
+        b.push(Instruction(Ope::MOV, Register::E, Value(3)));
+        b.push(WideInstruction(WideOperations::ITD, Register::E));
+    }, [] (Builder& b) {
+        b.push(WideInstruction(WideOperations::ADDL, Register::A, Value(1 << 30)));
+        b.push(WideInstruction(WideOperations::MULL, Register::C, Register::A));
+        b.push(WideInstruction(WideOperations::MULD, Register::E, Value(float_bits(1.0001f))));
+        b.push(WideInstruction(WideOperations::ADDD, Register::E, Register::E));
+    }));
+
+    return kernels;
+}
+
+}}
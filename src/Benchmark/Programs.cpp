@@ -0,0 +1,451 @@
+#include <vcrate/Benchmark/Programs.hpp>
+
+#include <vcrate/Benchmark/Builder.hpp>
+#include <vcrate/Benchmark/Kernels.hpp>
+
+#include <string>
+
+namespace vcrate { namespace benchmark {
+
+using namespace instruction;
+using Ope = bytecode::Operations;
+
+namespace {
+
+void print_line(Builder& b, Argument const& arg) {
+    b.push(Instruction(Ope::DBGU, arg));
+    b.push(Instruction(Ope::OUT, Value('\n')));
+}
+
+// Naive recursive fibonacci
+Kernel fib(ui32 n) {
+    Builder b;
+    auto entry = b.label();
+    auto fib = b.label();
+    auto recurse = b.label();
+
+    b.bind(entry, "main");
+    b.push(Instruction(Ope::MOV, Register::A, Value(n)));
+    b.call(fib);
+    print_line(b, Register::A);
+    b.push(Instruction(Ope::HLT));
+
+    // A = fib(A)
+    b.bind(fib, "fib");
+    b.push(Instruction(Ope::CMPU, Register::A, Value(2)));
+    b.jump(Ope::JMPGE, recurse);
+    b.push(Instruction(Ope::RET));
+    b.bind(recurse);
+    b.push(Instruction(Ope::ETR));
+    b.push(Instruction(Ope::PUSH, Register::A));
+    b.push(Instruction(Ope::DEC, Register::A));
+    b.call(fib);
+    b.push(Instruction(Ope::POP, Register::B));
+    b.push(Instruction(Ope::PUSH, Register::A));
+    b.push(Instruction(Ope::MOV, Register::A, Register::B));
+    b.push(Instruction(Ope::SUB, Register::A, Value(2)));
+    b.call(fib);
+    b.push(Instruction(Ope::POP, Register::B));
+    b.push(Instruction(Ope::ADD, Register::A, Register::B));
+    b.push(Instruction(Ope::LVE));
+    b.push(Instruction(Ope::RET));
+
+    return { "fib", b.build(entry) };
+}
+
+// Sieve of Eratosthenes over one word per number, prints the count of primes below n
+Kernel sieve(ui32 n) {
+    Builder b;
+    auto entry = b.label();
+    auto init = b.label();
+    auto outer = b.label();
+    auto inner = b.label();
+    auto next = b.label();
+    auto count = b.label();
+    auto count_loop = b.label();
+
+    b.bind(entry, "main");
+    b.push(Instruction(Ope::NEW, Register::C, Value(n * 4)));
+    b.push(Instruction(Ope::MOV, Register::E, Register::C));
+    b.push(Instruction(Ope::ADD, Register::E, Value(n * 4)));
+
+    b.push(Instruction(Ope::MOV, Register::D, Register::C));
+    b.bind(init, "init");
+    b.push(Instruction(Ope::MOV, Deferred(Register::D), Value(1)));
+    b.push(Instruction(Ope::ADD, Register::D, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::D, Register::E));
+    b.jump(Ope::JMPNE, init);
+
+    b.push(Instruction(Ope::MOV, Register::A, Value(2)));
+    b.bind(outer, "sieve");
+    b.push(Instruction(Ope::MOV, Register::F, Register::A));
+    b.push(Instruction(Ope::MULU, Register::F, Register::A));
+    b.push(Instruction(Ope::CMPU, Register::F, Value(n)));
+    b.jump(Ope::JMPGE, count);
+    b.push(Instruction(Ope::MOV, Register::G, Register::A));
+    b.push(Instruction(Ope::SHL, Register::G, Value(2)));
+    b.push(Instruction(Ope::ADD, Register::G, Register::C));
+    b.push(Instruction(Ope::CMPU, Deferred(Register::G), Value(0)));
+    b.jump(Ope::JMPE, next);
+    b.bind(inner);
+    b.push(Instruction(Ope::CMPU, Register::F, Value(n)));
+    b.jump(Ope::JMPGE, next);
+    b.push(Instruction(Ope::MOV, Register::H, Register::F));
+    b.push(Instruction(Ope::SHL, Register::H, Value(2)));
+    b.push(Instruction(Ope::ADD, Register::H, Register::C));
+    b.push(Instruction(Ope::MOV, Deferred(Register::H), Value(0)));
+    b.push(Instruction(Ope::ADD, Register::F, Register::A));
+    b.jump(Ope::JMP, inner);
+    b.bind(next);
+    b.push(Instruction(Ope::INC, Register::A));
+    b.jump(Ope::JMP, outer);
+
+    b.bind(count, "count");
+    b.push(Instruction(Ope::MOV, Register::A, Value(0)));
+    b.push(Instruction(Ope::MOV, Register::D, Register::C));
+    b.push(Instruction(Ope::ADD, Register::D, Value(8)));
+    b.bind(count_loop);
+    b.push(Instruction(Ope::ADD, Register::A, Deferred(Register::D)));
+    b.push(Instruction(Ope::ADD, Register::D, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::D, Register::E));
+    b.jump(Ope::JMPNE, count_loop);
+
+    print_line(b, Register::A);
+    b.push(Instruction(Ope::DEL, Register::C));
+    b.push(Instruction(Ope::HLT));
+
+    return { "sieve", b.build(entry) };
+}
+
+// C = A * B with n x n f32 matrices, prints the sum of C truncated to an integer
+Kernel matmul(ui32 n) {
+    ui32 bytes = n * n * 4;
+    ui32 stride = n * 4;
+
+    Builder b;
+    auto entry = b.label();
+    auto fill = b.label();
+    auto rows = b.label();
+    auto columns = b.label();
+    auto dot = b.label();
+    auto sum = b.label();
+
+    b.bind(entry, "main");
+    b.push(Instruction(Ope::NEW, Register::D, Value(bytes)));
+    b.push(Instruction(Ope::NEW, Register::E, Value(bytes)));
+    b.push(Instruction(Ope::NEW, Register::F, Value(bytes)));
+
+    // A[i] = i % 7, B[i] = i % 5
+    b.push(Instruction(Ope::MOV, Register::A, Value(0)));
+    b.bind(fill, "fill");
+    b.push(Instruction(Ope::MOV, Register::H, Register::A));
+    b.push(Instruction(Ope::SHL, Register::H, Value(2)));
+    b.push(Instruction(Ope::MOV, Register::L, Register::A));
+    b.push(Instruction(Ope::MOD, Register::L, Value(7)));
+    b.push(Instruction(Ope::ITF, Register::L));
+    b.push(Instruction(Ope::MOV, Register::I, Register::H));
+    b.push(Instruction(Ope::ADD, Register::I, Register::D));
+    b.push(Instruction(Ope::MOV, Deferred(Register::I), Register::L));
+    b.push(Instruction(Ope::MOV, Register::L, Register::A));
+    b.push(Instruction(Ope::MOD, Register::L, Value(5)));
+    b.push(Instruction(Ope::ITF, Register::L));
+    b.push(Instruction(Ope::MOV, Register::I, Register::H));
+    b.push(Instruction(Ope::ADD, Register::I, Register::E));
+    b.push(Instruction(Ope::MOV, Deferred(Register::I), Register::L));
+    b.push(Instruction(Ope::INC, Register::A));
+    b.push(Instruction(Ope::CMPU, Register::A, Value(n * n)));
+    b.jump(Ope::JMPNE, fill);
+
+    // K walks the rows of C
+    b.push(Instruction(Ope::MOV, Register::K, Register::F));
+    b.push(Instruction(Ope::MOV, Register::A, Value(0)));
+    b.bind(rows, "multiply");
+    b.push(Instruction(Ope::MOV, Register::B, Value(0)));
+    b.bind(columns);
+    b.push(Instruction(Ope::MOV, Register::G, Value(float_bits(0.f))));
+    // H walks row A of the first matrix, I walks column B of the second one
+    b.push(Instruction(Ope::MOV, Register::H, Register::A));
+    b.push(Instruction(Ope::MULU, Register::H, Value(stride)));
+    b.push(Instruction(Ope::ADD, Register::H, Register::D));
+    b.push(Instruction(Ope::MOV, Register::I, Register::B));
+    b.push(Instruction(Ope::SHL, Register::I, Value(2)));
+    b.push(Instruction(Ope::ADD, Register::I, Register::E));
+    b.push(Instruction(Ope::MOV, Register::C, Value(0)));
+    b.bind(dot);
+    b.push(Instruction(Ope::MOV, Register::L, Deferred(Register::H)));
+    b.push(Instruction(Ope::MULF, Register::L, Deferred(Register::I)));
+    b.push(Instruction(Ope::ADDF, Register::G, Register::L));
+    b.push(Instruction(Ope::ADD, Register::H, Value(4)));
+    b.push(Instruction(Ope::ADD, Register::I, Value(stride)));
+    b.push(Instruction(Ope::INC, Register::C));
+    b.push(Instruction(Ope::CMPU, Register::C, Value(n)));
+    b.jump(Ope::JMPNE, dot);
+    b.push(Instruction(Ope::MOV, Deferred(Register::K), Register::G));
+    b.push(Instruction(Ope::ADD, Register::K, Value(4)));
+    b.push(Instruction(Ope::INC, Register::B));
+    b.push(Instruction(Ope::CMPU, Register::B, Value(n)));
+    b.jump(Ope::JMPNE, columns);
+    b.push(Instruction(Ope::INC, Register::A));
+    b.push(Instruction(Ope::CMPU, Register::A, Value(n)));
+    b.jump(Ope::JMPNE, rows);
+
+    b.push(Instruction(Ope::MOV, Register::G, Value(float_bits(0.f))));
+    b.push(Instruction(Ope::MOV, Register::H, Register::F));
+    b.push(Instruction(Ope::MOV, Register::A, Value(0)));
+    b.bind(sum, "sum");
+    b.push(Instruction(Ope::ADDF, Register::G, Deferred(Register::H)));
+    b.push(Instruction(Ope::ADD, Register::H, Value(4)));
+    b.push(Instruction(Ope::INC, Register::A));
+    b.push(Instruction(Ope::CMPU, Register::A, Value(n * n)));
+    b.jump(Ope::JMPNE, sum);
+    b.push(Instruction(Ope::FTU, Register::G));
+    print_line(b, Register::G);
+
+    b.push(Instruction(Ope::DEL, Register::F));
+    b.push(Instruction(Ope::DEL, Register::E));
+    b.push(Instruction(Ope::DEL, Register::D));
+    b.push(Instruction(Ope::HLT));
+
+    return { "matmul-f32", b.build(entry) };
+}
+
+// Applies rot13 in place to a text stored one character per word and streams it with OUT, `rounds` times
+Kernel strings(ui32 rounds) {
+    std::string const text = "The quick brown fox jumps over the lazy dog, while Pack my box with five dozen liquor jugs.\n";
+
+    Builder b;
+    auto entry = b.label();
+    auto round = b.label();
+    auto character = b.label();
+    auto lower = b.label();
+    auto rotate = b.label();
+    auto emit = b.label();
+
+    b.bind(entry, "main");
+    b.push(Instruction(Ope::NEW, Register::D, Value(text.size() * 4)));
+    for(ui32 i = 0; i < text.size(); ++i)
+        b.push(Instruction(Ope::MOV, Displacement(Register::D, i * 4), Value(text[i])));
+    b.push(Instruction(Ope::MOV, Register::E, Register::D));
+    b.push(Instruction(Ope::ADD, Register::E, Value(text.size() * 4)));
+
+    b.push(Instruction(Ope::MOV, Register::L, Value(rounds)));
+    b.bind(round, "round");
+    b.push(Instruction(Ope::MOV, Register::H, Register::D));
+    b.bind(character);
+    b.push(Instruction(Ope::MOV, Register::A, Deferred(Register::H)));
+    // B = A | 0x20 folds the case, so only one range has to be checked
+    b.push(Instruction(Ope::MOV, Register::B, Register::A));
+    b.push(Instruction(Ope::OR, Register::B, Value(0x20)));
+    b.push(Instruction(Ope::SUB, Register::B, Value('a')));
+    b.push(Instruction(Ope::CMPU, Register::B, Value(26)));
+    b.jump(Ope::JMPGE, emit);
+    b.push(Instruction(Ope::MOV, Register::C, Register::A));
+    b.push(Instruction(Ope::AND, Register::C, Value(0x20)));
+    b.push(Instruction(Ope::ADD, Register::C, Value('A')));
+    b.push(Instruction(Ope::ADD, Register::B, Value(13)));
+    b.push(Instruction(Ope::CMPU, Register::B, Value(26)));
+    b.jump(Ope::JMPGE, lower);
+    b.jump(Ope::JMP, rotate);
+    b.bind(lower);
+    b.push(Instruction(Ope::SUB, Register::B, Value(26)));
+    b.bind(rotate);
+    b.push(Instruction(Ope::ADD, Register::B, Register::C));
+    b.push(Instruction(Ope::MOV, Register::A, Register::B));
+    b.push(Instruction(Ope::MOV, Deferred(Register::H), Register::A));
+    b.bind(emit);
+    b.push(Instruction(Ope::OUT, Register::A));
+    b.push(Instruction(Ope::ADD, Register::H, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::H, Register::E));
+    b.jump(Ope::JMPNE, character);
+    b.push(Instruction(Ope::DEC, Register::L));
+    b.push(Instruction(Ope::CMPU, Register::L, Value(0)));
+    b.jump(Ope::JMPNE, round);
+
+    b.push(Instruction(Ope::DEL, Register::D));
+    b.push(Instruction(Ope::HLT));
+
+    return { "strings", b.build(entry) };
+}
+
+// Chained hash table of `keys` nodes allocated with NEW, then every key is looked up and the table freed
+// A node is { key, value, next }, the sum of the values found is printed
+Kernel hash_table(ui32 keys) {
+    constexpr ui32 buckets = 256;
+    constexpr ui32 multiplier = 2654435761u;
+
+    Builder b;
+    auto entry = b.label();
+    auto clear = b.label();
+    auto insert = b.label();
+    auto lookup = b.label();
+    auto search = b.label();
+    auto found = b.label();
+    auto next_key = b.label();
+    auto release = b.label();
+    auto chain = b.label();
+    auto next_bucket = b.label();
+
+    auto hash = [&b] {
+        // B = key, C = address of its bucket
+        b.push(Instruction(Ope::MOV, Register::B, Register::A));
+        b.push(Instruction(Ope::MULU, Register::B, Value(static_cast<i32>(multiplier))));
+        b.push(Instruction(Ope::MOV, Register::C, Register::B));
+        b.push(Instruction(Ope::SHR, Register::C, Value(24)));
+        b.push(Instruction(Ope::SHL, Register::C, Value(2)));
+        b.push(Instruction(Ope::ADD, Register::C, Register::D));
+    };
+
+    b.bind(entry, "main");
+    b.push(Instruction(Ope::NEW, Register::D, Value(buckets * 4)));
+    b.push(Instruction(Ope::MOV, Register::K, Register::D));
+    b.push(Instruction(Ope::ADD, Register::K, Value(buckets * 4)));
+    b.push(Instruction(Ope::MOV, Register::C, Register::D));
+    b.bind(clear);
+    b.push(Instruction(Ope::MOV, Deferred(Register::C), Value(0)));
+    b.push(Instruction(Ope::ADD, Register::C, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::C, Register::K));
+    b.jump(Ope::JMPNE, clear);
+
+    b.push(Instruction(Ope::MOV, Register::A, Value(0)));
+    b.bind(insert, "insert");
+    hash();
+    b.push(Instruction(Ope::NEW, Register::E, Value(12)));
+    b.push(Instruction(Ope::MOV, Deferred(Register::E), Register::B));
+    b.push(Instruction(Ope::MOV, Displacement(Register::E, 4), Register::A));
+    b.push(Instruction(Ope::MOV, Register::F, Deferred(Register::C)));
+    b.push(Instruction(Ope::MOV, Displacement(Register::E, 8), Register::F));
+    b.push(Instruction(Ope::MOV, Deferred(Register::C), Register::E));
+    b.push(Instruction(Ope::INC, Register::A));
+    b.push(Instruction(Ope::CMPU, Register::A, Value(keys)));
+    b.jump(Ope::JMPNE, insert);
+
+    b.push(Instruction(Ope::MOV, Register::G, Value(0)));
+    b.push(Instruction(Ope::MOV, Register::A, Value(0)));
+    b.bind(lookup, "lookup");
+    hash();
+    b.push(Instruction(Ope::MOV, Register::E, Deferred(Register::C)));
+    b.bind(search);
+    b.push(Instruction(Ope::CMPU, Register::E, Value(0)));
+    b.jump(Ope::JMPE, next_key);
+    b.push(Instruction(Ope::CMPU, Deferred(Register::E), Register::B));
+    b.jump(Ope::JMPE, found);
+    b.push(Instruction(Ope::MOV, Register::E, Displacement(Register::E, 8)));
+    b.jump(Ope::JMP, search);
+    b.bind(found);
+    b.push(Instruction(Ope::ADD, Register::G, Displacement(Register::E, 4)));
+    b.bind(next_key);
+    b.push(Instruction(Ope::INC, Register::A));
+    b.push(Instruction(Ope::CMPU, Register::A, Value(keys)));
+    b.jump(Ope::JMPNE, lookup);
+
+    b.push(Instruction(Ope::MOV, Register::C, Register::D));
+    b.bind(release, "release");
+    b.push(Instruction(Ope::MOV, Register::E, Deferred(Register::C)));
+    b.bind(chain);
+    b.push(Instruction(Ope::CMPU, Register::E, Value(0)));
+    b.jump(Ope::JMPE, next_bucket);
+    b.push(Instruction(Ope::MOV, Register::F, Displacement(Register::E, 8)));
+    b.push(Instruction(Ope::DEL, Register::E));
+    b.push(Instruction(Ope::MOV, Register::E, Register::F));
+    b.jump(Ope::JMP, chain);
+    b.bind(next_bucket);
+    b.push(Instruction(Ope::ADD, Register::C, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::C, Register::K));
+    b.jump(Ope::JMPNE, release);
+    b.push(Instruction(Ope::DEL, Register::D));
+
+    print_line(b, Register::G);
+    b.push(Instruction(Ope::HLT));
+
+    return { "hash-table", b.build(entry) };
+}
+
+// Insertion sort of `n` pseudo random words, prints 1 if the result is sorted
+Kernel sort(ui32 n) {
+    Builder b;
+    auto entry = b.label();
+    auto fill = b.label();
+    auto outer = b.label();
+    auto inner = b.label();
+    auto place = b.label();
+    auto check = b.label();
+    auto unsorted = b.label();
+    auto wrong = b.label();
+    auto done = b.label();
+
+    b.bind(entry, "main");
+    b.push(Instruction(Ope::NEW, Register::D, Value(n * 4)));
+    b.push(Instruction(Ope::MOV, Register::E, Register::D));
+    b.push(Instruction(Ope::ADD, Register::E, Value(n * 4)));
+
+    // Linear congruential generator, the high half is kept
+    b.push(Instruction(Ope::MOV, Register::A, Value(12345)));
+    b.push(Instruction(Ope::MOV, Register::H, Register::D));
+    b.bind(fill, "fill");
+    b.push(Instruction(Ope::MULU, Register::A, Value(1103515245)));
+    b.push(Instruction(Ope::ADD, Register::A, Value(12345)));
+    b.push(Instruction(Ope::MOV, Register::B, Register::A));
+    b.push(Instruction(Ope::SHR, Register::B, Value(16)));
+    b.push(Instruction(Ope::MOV, Deferred(Register::H), Register::B));
+    b.push(Instruction(Ope::ADD, Register::H, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::H, Register::E));
+    b.jump(Ope::JMPNE, fill);
+
+    // H points to the element to insert, I walks back over the sorted prefix
+    b.push(Instruction(Ope::MOV, Register::H, Register::D));
+    b.bind(outer, "sort");
+    b.push(Instruction(Ope::ADD, Register::H, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::H, Register::E));
+    b.jump(Ope::JMPE, check);
+    b.push(Instruction(Ope::MOV, Register::A, Deferred(Register::H)));
+    b.push(Instruction(Ope::MOV, Register::I, Register::H));
+    b.push(Instruction(Ope::SUB, Register::I, Value(4)));
+    b.bind(inner);
+    b.push(Instruction(Ope::CMPU, Register::D, Register::I));
+    b.jump(Ope::JMPG, place);
+    b.push(Instruction(Ope::MOV, Register::B, Deferred(Register::I)));
+    b.push(Instruction(Ope::CMPU, Register::A, Register::B));
+    b.jump(Ope::JMPGE, place);
+    b.push(Instruction(Ope::MOV, Displacement(Register::I, 4), Register::B));
+    b.push(Instruction(Ope::SUB, Register::I, Value(4)));
+    b.jump(Ope::JMP, inner);
+    b.bind(place);
+    b.push(Instruction(Ope::MOV, Displacement(Register::I, 4), Register::A));
+    b.jump(Ope::JMP, outer);
+
+    b.bind(check, "check");
+    b.push(Instruction(Ope::MOV, Register::G, Value(1)));
+    b.push(Instruction(Ope::MOV, Register::H, Register::D));
+    b.push(Instruction(Ope::SUB, Register::E, Value(4)));
+    b.bind(unsorted);
+    b.push(Instruction(Ope::CMPU, Register::H, Register::E));
+    b.jump(Ope::JMPE, done);
+    b.push(Instruction(Ope::MOV, Register::A, Deferred(Register::H)));
+    b.push(Instruction(Ope::ADD, Register::H, Value(4)));
+    b.push(Instruction(Ope::CMPU, Register::A, Deferred(Register::H)));
+    b.jump(Ope::JMPG, wrong);
+    b.jump(Ope::JMP, unsorted);
+    b.bind(wrong);
+    b.push(Instruction(Ope::MOV, Register::G, Value(0)));
+    b.bind(done);
+    print_line(b, Register::G);
+    b.push(Instruction(Ope::DEL, Register::D));
+    b.push(Instruction(Ope::HLT));
+
+    return { "sort", b.build(entry) };
+}
+
+}
+
+std::vector<Kernel> macro_programs() {
+    return {
+        fib(25),
+        sieve(200'000),
+        matmul(48),
+        strings(2'000),
+        hash_table(20'000),
+        sort(2'000)
+    };
+}
+
+}}
@@ -0,0 +1,262 @@
+#include <vcrate/Cache/DiskCache.hpp>
+
+#include <vcrate/Program/Compact.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+namespace vcrate { namespace cache {
+
+namespace {
+
+constexpr char magic[4] = { 'V', 'C', 'P', 'D' };
+
+static_assert(std::is_trivially_copyable<program::DecodedInstruction>::value, "Decoded instructions are copied as bytes");
+
+struct Header {
+    char magic[4];
+    ui32 version;
+    ui64 key;
+    ui64 source_size;
+    // Of the bytes after the header
+    ui64 checksum;
+    ui32 entry_point;
+    ui32 verified;
+    ui32 jmp_table_words;
+    ui32 data_words;
+    ui32 code_words;
+    ui32 instructions;
+    // Each one is its address, the size of its name and its name, after the instructions
+    ui32 symbols;
+};
+
+constexpr ui64 fnv_offset = 0xcbf29ce484222325;
+constexpr ui64 fnv_prime = 0x100000001b3;
+
+void hash_bytes(ui64& hash, void const* data, std::size_t size) {
+    auto bytes = static_cast<unsigned char const*>(data);
+    for(std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= fnv_prime;
+    }
+}
+
+void write_bytes(std::ostream& os, ui64& checksum, void const* data, std::size_t size) {
+    hash_bytes(checksum, data, size);
+    os.write(static_cast<char const*>(data), size);
+}
+
+// A read only mapping of a whole file, unmapped when destroyed
+class Mapping {
+public:
+
+    explicit Mapping(std::string const& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat status;
+        if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+            void* mapped = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<char const*>(mapped);
+                size = status.st_size;
+            }
+        }
+        ::close(fd);
+    }
+
+    ~Mapping() {
+        if (data)
+            ::munmap(const_cast<char*>(data), size);
+    }
+
+    Mapping(Mapping const&) = delete;
+    Mapping& operator=(Mapping const&) = delete;
+
+    char const* data = nullptr;
+    std::size_t size = 0;
+
+};
+
+class Cursor {
+public:
+
+    Cursor(char const* data, std::size_t size) : data(data), size(size) {}
+
+    bool copy(void* destination, std::size_t bytes) {
+        if (size - position < bytes)
+            return false;
+        std::memcpy(destination, data + position, bytes);
+        position += bytes;
+        return true;
+    }
+
+    template<typename T>
+    bool copy(std::vector<T>& destination, std::size_t count) {
+        if ((size - position) / sizeof(T) < count)
+            return false;
+        destination.resize(count);
+        return copy(destination.data(), count * sizeof(T));
+    }
+
+    bool at_end() const {
+        return position == size;
+    }
+
+private:
+
+    char const* data;
+    std::size_t size;
+    std::size_t position = 0;
+
+};
+
+}
+
+DiskCache::DiskCache(std::string directory) : directory(std::move(directory)) {}
+
+ui64 DiskCache::key_of(std::string const& contents) {
+    ui64 hash = fnv_offset;
+    ui32 v = version;
+    hash_bytes(hash, &v, sizeof(v));
+    ui32 instruction_size = sizeof(program::DecodedInstruction);
+    hash_bytes(hash, &instruction_size, sizeof(instruction_size));
+    hash_bytes(hash, contents.data(), contents.size());
+    return hash;
+}
+
+std::string DiskCache::path_of(ui64 key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 ".vcp", static_cast<std::uint64_t>(key));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+std::optional<Prepared> DiskCache::load(ui64 key, ui64 source_size) const {
+    Mapping mapping(path_of(key));
+    if (!mapping.data)
+        return std::nullopt;
+
+    Cursor cursor(mapping.data, mapping.size);
+    Header header;
+    if (!cursor.copy(&header, sizeof(header)) || std::memcmp(header.magic, magic, sizeof(magic)) != 0
+     || header.version != version || header.key != key || header.source_size != source_size)
+        return std::nullopt;
+    ui64 checksum = fnv_offset;
+    hash_bytes(checksum, mapping.data + sizeof(header), mapping.size - sizeof(header));
+    if (checksum != header.checksum)
+        return std::nullopt;
+
+    Prepared prepared;
+    std::vector<program::DecodedInstruction> instructions;
+    prepared.exe.entry_point = header.entry_point;
+    prepared.verified = header.verified != 0;
+    if (!cursor.copy(prepared.exe.jmp_table, header.jmp_table_words) || !cursor.copy(prepared.exe.data, header.data_words)
+     || !cursor.copy(prepared.exe.code, header.code_words) || !cursor.copy(instructions, header.instructions))
+        return std::nullopt;
+
+    for(ui32 s = 0; s < header.symbols; ++s) {
+        ui32 address, length;
+        std::string name;
+        if (!cursor.copy(&address, sizeof(address)) || !cursor.copy(&length, sizeof(length)))
+            return std::nullopt;
+        name.resize(length);
+        if (!cursor.copy(name.data(), length))
+            return std::nullopt;
+        prepared.exe.symbols[name] = address;
+    }
+    if (!cursor.at_end())
+        return std::nullopt;
+
+    prepared.program = program::Program(std::move(instructions), header.code_words);
+    return prepared;
+}
+
+bool DiskCache::store(ui64 key, ui64 source_size, Prepared const& prepared) const {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+        return false;
+
+    auto const& exe = prepared.exe;
+    auto const& instructions = prepared.program.get_instructions();
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.key = key;
+    header.source_size = source_size;
+    header.checksum = fnv_offset;
+    header.entry_point = exe.entry_point;
+    header.verified = prepared.verified;
+    header.jmp_table_words = exe.jmp_table.size();
+    header.data_words = exe.data.size();
+    header.code_words = exe.code.size();
+    header.instructions = instructions.size();
+    header.symbols = exe.symbols.size();
+
+    auto path = path_of(key);
+    // Unique to the writer, the threads of a server may store the same entry at once
+    auto temporary = path + "." + std::to_string(::getpid()) + "-" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream os(temporary, std::ios::binary);
+        auto& checksum = header.checksum;
+        // Written again once the checksum is known
+        os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        write_bytes(os, checksum, exe.jmp_table.data(), exe.jmp_table.size() * sizeof(ui32));
+        write_bytes(os, checksum, exe.data.data(), exe.data.size() * sizeof(ui32));
+        write_bytes(os, checksum, exe.code.data(), exe.code.size() * sizeof(ui32));
+        write_bytes(os, checksum, instructions.data(), instructions.size() * sizeof(program::DecodedInstruction));
+        for(auto const& p : exe.symbols) {
+            ui32 length = p.first.size();
+            write_bytes(os, checksum, &p.second, sizeof(p.second));
+            write_bytes(os, checksum, &length, sizeof(length));
+            write_bytes(os, checksum, p.first.data(), length);
+        }
+        os.seekp(0);
+        os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        if (!os) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+std::optional<Prepared> DiskCache::prepare(std::string const& contents) const {
+    auto key = key_of(contents);
+    if (auto cached = load(key, contents.size()))
+        return cached;
+
+    std::istringstream is(contents);
+    auto exe = program::read_executable(is);
+    if (!exe)
+        return std::nullopt;
+
+    Prepared prepared;
+    prepared.exe = std::move(*exe);
+    prepared.program = program::Program(prepared.exe);
+    prepared.verified = !verifier::has_errors(verifier::verify(prepared.exe, prepared.program));
+    // A cache that can't be written only costs the next run its time
+    store(key, contents.size(), prepared);
+    return prepared;
+}
+
+}}
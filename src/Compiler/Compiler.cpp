@@ -0,0 +1,356 @@
+#include <vcrate/Compiler/Compiler.hpp>
+
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Replay/Replay.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+
+#include <iomanip>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace vcrate { namespace compiler {
+
+using program::DecodedInstruction;
+using program::Operand;
+using program::OperandKind;
+using Operations = bytecode::Operations;
+
+namespace {
+
+std::string constant(ui32 value) {
+    std::stringstream ss;
+    ss << "0x" << std::hex << value << "u";
+    return ss.str();
+}
+
+// C++ for one instruction, with what it needs to know about the rest of the program
+class Translator {
+public:
+
+    Translator(std::set<ui32> const& labels, DecodedInstruction const& d)
+    : labels(labels), d(d), next(d.pc + d.size) {}
+
+    std::string translate() {
+        if (d.wide) {
+            body << "if (!s.interpret(" << constant(d.pc) << ", " << constant(next) << ", counters)) {\n";
+            leave();
+            body << "}\n";
+            return body.str();
+        }
+
+        body << "++counters.instructions;\n";
+        auto const& a0 = d.args[0];
+        auto const& a1 = d.args[1];
+        auto ope = static_cast<Operations>(d.op);
+
+        if (auto e = binary_expression(ope)) {
+            body << "ui32 a = " << read(a0) << ";\n";
+            body << "ui32 b = " << read(a1) << ";\n";
+            if (ope == Operations::DIV || ope == Operations::DIVU || ope == Operations::MOD) {
+                body << "if (b == 0) {\n";
+                trap("DivisionByZero");
+                body << "}\n";
+            }
+            write(a0, e);
+        } else if (auto e = unary_expression(ope)) {
+            body << "ui32 a = " << read(a0) << ";\n";
+            write(a0, e);
+        } else {
+            translate_other(ope, a0, a1);
+        }
+
+        if (writes_pc)
+            body << "continue;\n";
+        return body.str();
+    }
+
+    bool falls_through() const {
+        auto ope = static_cast<Operations>(d.op);
+        return d.wide || !(writes_pc || ope == Operations::JMP || ope == Operations::CALL
+            || ope == Operations::RET || ope == Operations::HLT);
+    }
+
+private:
+
+    static char const* binary_expression(Operations ope) {
+        switch(ope) {
+            case Operations::ADD:   return "a + b";
+            case Operations::ADDF:  return "bits_of(float_of(a) + float_of(b))";
+            case Operations::SUB:   return "a - b";
+            case Operations::SUBF:  return "bits_of(float_of(a) - float_of(b))";
+            case Operations::MOD:   return "a % b";
+            case Operations::MODF:  return "bits_of(std::fmod(float_of(a), float_of(b)))";
+            case Operations::MUL:   return "static_cast<ui32>(int_of(a) * int_of(b))";
+            case Operations::MULU:  return "a * b";
+            case Operations::MULF:  return "bits_of(float_of(a) * float_of(b))";
+            // Divided by -1 it's a negation, which wraps for the lowest value where the host division faults
+            case Operations::DIV:   return "b == 0xFFFFFFFFu ? 0u - a : static_cast<ui32>(int_of(a) / int_of(b))";
+            case Operations::DIVU:  return "a / b";
+            case Operations::DIVF:  return "bits_of(float_of(a) / float_of(b))";
+            case Operations::AND:   return "a & b";
+            case Operations::OR:    return "a | b";
+            case Operations::XOR:   return "a ^ b";
+            case Operations::SHL:   return "a << b";
+            case Operations::SHR:   return "a >> b";
+            case Operations::RTL:   return "(a << (b & 31)) | (a >> (32 - (b & 31)))";
+            case Operations::RTR:   return "(a >> (b & 31)) | (a << (32 - (b & 31)))";
+            default:                return nullptr;
+        }
+    }
+
+    static char const* unary_expression(Operations ope) {
+        switch(ope) {
+            case Operations::NOT:   return "~a";
+            case Operations::INC:   return "a + 1";
+            case Operations::INCF:  return "bits_of(float_of(a) + 1.f)";
+            case Operations::DEC:   return "a - 1";
+            case Operations::DECF:  return "bits_of(float_of(a) - 1.f)";
+            case Operations::ITU:   return "static_cast<ui32>(int_of(a))";
+            case Operations::ITF:   return "bits_of(static_cast<f32>(int_of(a)))";
+            case Operations::UTI:   return "static_cast<ui32>(static_cast<i32>(a))";
+            case Operations::UTF:   return "bits_of(static_cast<f32>(a))";
+            case Operations::FTI:   return "static_cast<ui32>(static_cast<i32>(float_of(a)))";
+            case Operations::FTU:   return "static_cast<ui32>(float_of(a))";
+            default:                return nullptr;
+        }
+    }
+
+    void translate_other(Operations ope, Operand const& a0, Operand const& a1) {
+        switch(ope) {
+            case Operations::MOV:   return write(a0, read(a1));
+            case Operations::LEA:   return write(a0, address(a1));
+            case Operations::POP:   return write(a0, "sandbox.pop_32()");
+            case Operations::PUSH:
+                body << "sandbox.push_32(" << read(a0) << ");\n";
+                body << "counters.on_stack(sandbox.get_sp());\n";
+                return;
+            case Operations::SWP:
+                body << "ui32 a = " << read(a0) << ";\n";
+                body << "ui32 b = " << read(a1) << ";\n";
+                write(a0, "b");
+                return write(a1, "a");
+            case Operations::CMP:
+                // Same comparison as Interpreter::instruction_CMP, which compares the unsigned values
+            case Operations::CMPU:
+                body << "ui32 a = " << read(a0) << ";\n";
+                body << "ui32 b = " << read(a1) << ";\n";
+                body << "s.zero = a == b;\n";
+                body << "s.greater = a > b;\n";
+                return;
+            case Operations::JMP:   return jump(a0, "");
+            case Operations::JMPE:  return jump(a0, "s.zero");
+            case Operations::JMPNE: return jump(a0, "!s.zero");
+            case Operations::JMPG:  return jump(a0, "s.greater");
+            case Operations::JMPGE: return jump(a0, "s.greater || s.zero");
+            case Operations::NEW:
+                body << "ui32 size = " << read(a1) << ";\n";
+                body << "ui32 address = sandbox.allocate(size);\n";
+                body << "counters.on_allocate(address, size);\n";
+                return write(a0, "address");
+            case Operations::DEL:
+                body << "ui32 address = " << read(a0) << ";\n";
+                body << "sandbox.deallocate(address);\n";
+                body << "counters.on_deallocate(address);\n";
+                return;
+            case Operations::CALL: {
+                // Calls are relative to the next instruction when given a Value or an Address
+                std::optional<ui32> target;
+                if (a0.kind == OperandKind::Value)
+                    target = next + a0.value;
+                else
+                    body << "ui32 target = " << read(a0) << (a0.kind == OperandKind::Address ? " + " + constant(next) : "") << ";\n";
+                body << "sandbox.push_32(" << constant(next) << ");\n";
+                body << "++counters.calls;\n";
+                body << "counters.on_stack(sandbox.get_sp());\n";
+                return go_to(target, "target");
+            }
+            case Operations::RET:
+                body << "sandbox.set_pc(sandbox.pop_32());\n";
+                body << "continue;\n";
+                return;
+            case Operations::ETR:
+                body << "sandbox.push_32(sandbox.get_bp());\n";
+                body << "sandbox.set_bp(sandbox.get_sp());\n";
+                body << "counters.on_stack(sandbox.get_sp());\n";
+                return;
+            case Operations::LVE:
+                body << "sandbox.set_sp(sandbox.get_bp());\n";
+                body << "sandbox.set_bp(sandbox.pop_32());\n";
+                return;
+            case Operations::HLT:
+                body << "sandbox.set_pc(" << constant(next) << ");\n";
+                body << "sandbox.halt();\n";
+                body << "return;\n";
+                return;
+            case Operations::OUT:
+                body << "sandbox.output(static_cast<ui8>(" << read(a0) << "));\n";
+                body << "++counters.output_bytes;\n";
+                return;
+            case Operations::DBG:   body << "std::cout << int_of(" << read(a0) << ");\n"; return;
+            case Operations::DBGU:  body << "std::cout << " << read(a0) << ";\n"; return;
+            case Operations::DBGF:  body << "std::cout << float_of(" << read(a0) << ");\n"; return;
+            default:
+                throw std::runtime_error("Operation unknown at " + std::to_string(d.pc));
+        }
+    }
+
+    // The sandbox is halted, or the pc moved to the trap handler
+    void leave() {
+        body << "if (sandbox.is_halted())\n";
+        body << "    return;\n";
+        body << "continue;\n";
+    }
+
+    void trap(std::string const& code) {
+        body << "s.trap(interpreter::TrapCode::" << code << ", " << constant(d.pc) << ", " << constant(next) << ", counters);\n";
+        leave();
+    }
+
+    // Jumps are relative to their own address when given a Value or an Address, like in the Interpreter
+    void jump(Operand const& a0, std::string const& condition) {
+        std::optional<ui32> target;
+        std::string dynamic;
+        if (a0.kind == OperandKind::Value)
+            target = d.pc + a0.value;
+        else if (a0.kind == OperandKind::Address)
+            dynamic = read(a0) + " + " + constant(d.pc);
+        else
+            dynamic = read(a0);
+
+        if (condition.empty())
+            return go_to(target, dynamic);
+
+        body << "if (" << condition << ") {\n";
+        go_to(target, dynamic);
+        body << "}\n";
+    }
+
+    void go_to(std::optional<ui32> target, std::string const& dynamic) {
+        if (target && labels.count(*target)) {
+            body << "goto pc_" << *target << ";\n";
+            return;
+        }
+        body << "sandbox.set_pc(" << (target ? constant(*target) : dynamic) << ");\n";
+        body << "continue;\n";
+    }
+
+    std::string read_register(ui32 id) {
+        if (id < runtime_registers)
+            return "s.r[" + std::to_string(id) + "]";
+        // The Interpreter moves the pc before running the instruction
+        if (id == instruction::Register::PC.id)
+            return constant(next);
+        if (id == instruction::Register::FG.id)
+            throw std::runtime_error("The flags register is used at " + std::to_string(d.pc));
+        return "sandbox.get_register(" + std::to_string(id) + ")";
+    }
+
+    std::string read(Operand const& o) {
+        switch(o.kind) {
+            case OperandKind::Register:     return read_register(o.reg);
+            case OperandKind::Value:        return constant(o.value);
+            default:                        return "sandbox.get_memory_at(" + address(o) + ")";
+        }
+    }
+
+    std::string address(Operand const& o) {
+        switch(o.kind) {
+            case OperandKind::Address:      return constant(o.value);
+            case OperandKind::Deferred:     return read_register(o.reg);
+            case OperandKind::Displacement: return read_register(o.reg) + " + " + constant(o.value);
+            default:
+                throw std::runtime_error("The argument has no address at " + std::to_string(d.pc));
+        }
+    }
+
+    void write(Operand const& o, std::string const& value) {
+        if (o.kind != OperandKind::Register) {
+            body << "if (!s.write_memory(" << address(o) << ", " << value << ")) {\n";
+            trap("WriteToCode");
+            body << "}\n";
+        } else if (o.reg < runtime_registers) {
+            body << "s.r[" << static_cast<ui32>(o.reg) << "] = " << value << ";\n";
+        } else if (o.reg == instruction::Register::PC.id) {
+            body << "sandbox.set_pc(" << value << ");\n";
+            writes_pc = true;
+        } else if (o.reg == instruction::Register::FG.id) {
+            throw std::runtime_error("The flags register is used at " + std::to_string(d.pc));
+        } else {
+            body << "sandbox.set_register(" << static_cast<ui32>(o.reg) << ", " << value << ");\n";
+        }
+    }
+
+    // Registers A to L, kept in runtime::State
+    static constexpr ui32 runtime_registers = 12;
+
+    std::set<ui32> const& labels;
+    DecodedInstruction const& d;
+    ui32 next;
+    std::stringstream body;
+    bool writes_pc = false;
+
+};
+
+std::string indent(std::string const& code, std::string const& prefix) {
+    std::stringstream in(code);
+    std::string out, line;
+    while(std::getline(in, line))
+        out += prefix + line + '\n';
+    return out;
+}
+
+}
+
+void compile(std::ostream& os, vcx::Executable const& exe) {
+    program::Program program(exe);
+    auto issues = verifier::verify(exe, program);
+    if (verifier::has_errors(issues))
+        throw std::runtime_error("The executable doesn't pass the verifier");
+
+    // Only the targets of static jumps and calls need a label, everything else goes through the switch
+    std::set<ui32> labels;
+    for(auto const& d : program.get_instructions())
+        if (program::has_static_target(d) && program.at(program::static_target_of(d)))
+            labels.insert(program::static_target_of(d));
+
+    os << "// Generated by vcrate::compiler::compile from an executable of " << program.get_code_size() << " bytes of code\n";
+    os << "// Build it as a shared object and run it with `main --native <shared object> <executable>`\n\n";
+    os << "#include <vcrate/Compiler/Runtime.hpp>\n\n";
+    os << "using namespace vcrate;\n";
+    os << "using namespace vcrate::compiler::runtime;\n\n";
+    os << "extern \"C\" ui64 const " << hash_symbol << " = 0x" << std::hex << replay::hash_of(exe) << std::dec << "ull;\n\n";
+    os << "extern \"C\" void " << run_symbol << "(SandBox& sandbox, interpreter::Counters& counters) {\n";
+    os << "    State s(sandbox, " << constant(program.get_code_size()) << ");\n\n";
+    os << "    for(;;) switch(sandbox.get_pc()) {\n";
+
+    bool falls_through = false;
+    for(auto const& d : program.get_instructions()) {
+        Translator translator(labels, d);
+        auto code = translator.translate();
+
+        if (falls_through)
+            os << "    [[fallthrough]];\n";
+        os << "    case " << constant(d.pc) << ":\n";
+        if (labels.count(d.pc))
+            os << "    pc_" << d.pc << ":\n";
+        os << "    { // " << interpreter::instruction_to_string(exe.code[d.pc / 4], d.pc / 4 + 1 < exe.code.size() ? exe.code[d.pc / 4 + 1] : 0,
+                                                                  d.pc / 4 + 2 < exe.code.size() ? exe.code[d.pc / 4 + 2] : 0) << '\n';
+        os << indent(code, "        ");
+        os << "    }\n";
+        falls_through = translator.falls_through();
+    }
+
+    if (falls_through)
+        os << "    [[fallthrough]];\n";
+    os << "    default:\n";
+    os << "        s.trap(interpreter::TrapCode::InvalidPc, sandbox.get_pc(), sandbox.get_pc(), counters);\n";
+    os << "        if (sandbox.is_halted())\n";
+    os << "            return;\n";
+    os << "    }\n";
+    os << "}\n";
+}
+
+}}
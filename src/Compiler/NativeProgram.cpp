@@ -0,0 +1,49 @@
+#include <vcrate/Compiler/NativeProgram.hpp>
+
+#include <vcrate/Compiler/Compiler.hpp>
+#include <vcrate/Replay/Replay.hpp>
+
+#include <dlfcn.h>
+
+namespace vcrate { namespace compiler {
+
+NativeProgram::NativeProgram(std::string const& path) {
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        error = dlerror();
+        return;
+    }
+
+    entry = reinterpret_cast<void (*)(SandBox&, interpreter::Counters&)>(dlsym(handle, run_symbol));
+    hash = static_cast<ui64 const*>(dlsym(handle, hash_symbol));
+    if (!entry || !hash) {
+        error = "The shared object wasn't generated by the compiler";
+        dlclose(handle);
+        handle = nullptr;
+        entry = nullptr;
+        hash = nullptr;
+    }
+}
+
+NativeProgram::~NativeProgram() {
+    if (handle)
+        dlclose(handle);
+}
+
+bool NativeProgram::is_loaded() const {
+    return handle != nullptr;
+}
+
+std::string const& NativeProgram::get_error() const {
+    return error;
+}
+
+bool NativeProgram::is_compiled_from(vcx::Executable const& exe) const {
+    return hash && *hash == replay::hash_of(exe);
+}
+
+void NativeProgram::run(SandBox& sandbox, interpreter::Counters& counters) const {
+    entry(sandbox, counters);
+}
+
+}}
@@ -0,0 +1,121 @@
+#include <vcrate/Coverage/Coverage.hpp>
+
+#include <vcrate/Replay/Replay.hpp>
+
+namespace vcrate { namespace coverage {
+
+namespace {
+
+template<typename T>
+void write(std::ostream& os, T const& value) {
+    os.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+template<typename T>
+void read(std::istream& is, T& value) {
+    is.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+}
+
+Coverage::Coverage(vcx::Executable const& exe)
+    : executable_hash(replay::hash_of(exe)), code_words(exe.code.size()),
+      executed((code_words + 63) / 64, 0), taken(executed.size(), 0), not_taken(executed.size(), 0), branch_sizes(code_words, 0) {
+    for(auto const& d : program::Program(exe).get_instructions()) {
+        if (program::is_conditional_jump(d) && d.pc / 4 < code_words)
+            branch_sizes[d.pc / 4] = d.size;
+    }
+}
+
+bool Coverage::merge(Coverage const& other) {
+    if (other.is_empty())
+        return true;
+    if (is_empty()) {
+        executable_hash = other.executable_hash;
+        code_words = other.code_words;
+        executed = other.executed;
+        taken = other.taken;
+        not_taken = other.not_taken;
+        branch_sizes = other.branch_sizes;
+        return true;
+    }
+    if (other.executable_hash != executable_hash || other.code_words != code_words)
+        return false;
+
+    for(ui32 i = 0; i < executed.size(); ++i) {
+        executed[i] |= other.executed[i];
+        taken[i] |= other.taken[i];
+        not_taken[i] |= other.not_taken[i];
+    }
+    return true;
+}
+
+bool Coverage::is_empty() const {
+    return executable_hash == 0 && code_words == 0;
+}
+
+ui64 Coverage::get_executable_hash() const {
+    return executable_hash;
+}
+
+bool Coverage::test(std::vector<ui64> const& bitmap, ui32 pc) {
+    ui32 word = pc / 4;
+    return pc % 4 == 0 && word / 64 < bitmap.size() && (bitmap[word / 64] >> (word % 64)) & 1;
+}
+
+bool Coverage::is_executed(ui32 pc) const {
+    return test(executed, pc);
+}
+
+bool Coverage::is_taken(ui32 pc) const {
+    return test(taken, pc);
+}
+
+bool Coverage::is_not_taken(ui32 pc) const {
+    return test(not_taken, pc);
+}
+
+Summary Coverage::summarize(program::Program const& program) const {
+    Summary summary;
+    for(auto const& d : program.get_instructions()) {
+        ++summary.instructions;
+        summary.executed += is_executed(d.pc);
+        if (program::is_conditional_jump(d)) {
+            summary.directions += 2;
+            summary.directions_covered += is_taken(d.pc) + is_not_taken(d.pc);
+        }
+    }
+    return summary;
+}
+
+void Coverage::save(std::ostream& os) const {
+    write(os, magic);
+    write(os, version);
+    write(os, executable_hash);
+    write(os, code_words);
+    for(auto const* bitmap : { &executed, &taken, &not_taken })
+        os.write(reinterpret_cast<char const*>(bitmap->data()), bitmap->size() * sizeof(ui64));
+}
+
+std::optional<Coverage> Coverage::load(std::istream& is) {
+    ui32 m = 0, v = 0;
+    read(is, m);
+    read(is, v);
+    if (!is || m != magic || v != version)
+        return std::nullopt;
+
+    Coverage coverage;
+    read(is, coverage.executable_hash);
+    read(is, coverage.code_words);
+    if (!is)
+        return std::nullopt;
+    for(auto* bitmap : { &coverage.executed, &coverage.taken, &coverage.not_taken }) {
+        bitmap->resize((coverage.code_words + 63) / 64);
+        is.read(reinterpret_cast<char*>(bitmap->data()), bitmap->size() * sizeof(ui64));
+    }
+    if (!is)
+        return std::nullopt;
+    return coverage;
+}
+
+}}
@@ -0,0 +1,377 @@
+#include <vcrate/Debugger/Debugger.hpp>
+
+#include <vcrate/Disassembler/Disassembler.hpp>
+#include <vcrate/Interpreter/Interpreter.hpp>
+#include <vcrate/Interpreter/VerifiedInterpreter.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace vcrate { namespace debugger {
+
+namespace {
+
+std::string hex(ui32 word) {
+    char s[11];
+    std::snprintf(s, sizeof(s), "0x%08X", word);
+    return s;
+}
+
+std::optional<ui32> number_of(std::string const& s) {
+    if (s.empty())
+        return std::nullopt;
+    char* end = nullptr;
+    auto n = std::strtoul(s.c_str(), &end, 0);
+    if (*end != '\0')
+        return std::nullopt;
+    return static_cast<ui32>(n);
+}
+
+program::DecodedInstruction breakpoint() {
+    program::DecodedInstruction d;
+    d.op = program::breakpoint_operation;
+    d.valid = true;
+    return d;
+}
+
+bool is_enter(program::DecodedInstruction const& d) {
+    return d.valid && !d.wide && static_cast<bytecode::Operations>(d.op) == bytecode::Operations::ETR;
+}
+
+char const* const help =
+    "break <location>      Stops before the instruction at the location (b)\n"
+    "delete <location>     Removes the breakpoint at the location (d)\n"
+    "watch <address>       Stops once the word at the address changes (w)\n"
+    "unwatch <address>     Removes the watchpoint at the address (u)\n"
+    "continue              Runs until a breakpoint, a watchpoint or the halt (c)\n"
+    "step                  Runs one instruction (s)\n"
+    "next                  Runs one instruction, a whole call for a call (n)\n"
+    "finish                Runs until the function returns (f)\n"
+    "registers             Prints the registers and the flags (r)\n"
+    "x <address> [count]   Prints words of memory\n"
+    "list [location] [count]  Prints instructions, from the pc by default (l)\n"
+    "info                  Lists the breakpoints and the watchpoints (i)\n"
+    "quit                  Halts the program (q)\n"
+    "A location is a symbol, symbol+offset or an address, in decimal or in hexadecimal with 0x.\n"
+    "An empty line runs the last command again.\n";
+
+}
+
+char const* to_string(Stop stop) {
+    switch(stop) {
+        case Stop::Breakpoint:  return "breakpoint";
+        case Stop::Watchpoint:  return "watchpoint";
+        case Stop::Step:        return "step";
+        case Stop::Halted:      return "halted";
+    }
+    return "unknown";
+}
+
+Debugger::Debugger(vcx::Executable const& exe, SandBox& sandbox, interpreter::Counters& counters)
+    : exe(exe), sandbox(sandbox), counters(counters), symbols(exe), program(exe), cache(exe) {
+    verified = !verifier::has_errors(verifier::verify(exe, program));
+    for(auto const& d : program.get_instructions()) {
+        if (program::is_call(d))
+            return_sites.insert(d.pc + d.size);
+    }
+}
+
+bool Debugger::is_verified() const {
+    return verified;
+}
+
+std::optional<ui32> Debugger::address_of(std::string const& location) const {
+    if (auto n = number_of(location))
+        return n;
+    auto plus = location.find('+');
+    auto it = exe.symbols.find(location.substr(0, plus));
+    if (it == exe.symbols.end())
+        return std::nullopt;
+    if (plus == std::string::npos)
+        return it->second;
+    auto offset = number_of(location.substr(plus + 1));
+    if (!offset)
+        return std::nullopt;
+    return it->second + *offset;
+}
+
+bool Debugger::add_breakpoint(ui32 pc) {
+    if (!original_at(pc))
+        return false;
+    breakpoints.insert(pc);
+    patch(pc);
+    return true;
+}
+
+bool Debugger::remove_breakpoint(ui32 pc) {
+    if (breakpoints.erase(pc) == 0)
+        return false;
+    unpatch(pc);
+    return true;
+}
+
+std::set<ui32> const& Debugger::get_breakpoints() const {
+    return breakpoints;
+}
+
+void Debugger::add_watchpoint(ui32 address) {
+    address &= ~3u;
+    auto it = std::find_if(watchpoints.begin(), watchpoints.end(), [address] (Watchpoint const& w) { return w.address == address; });
+    if (it == watchpoints.end())
+        watchpoints.push_back({ address, sandbox.get_memory_at(address) });
+}
+
+bool Debugger::remove_watchpoint(ui32 address) {
+    address &= ~3u;
+    auto it = std::find_if(watchpoints.begin(), watchpoints.end(), [address] (Watchpoint const& w) { return w.address == address; });
+    if (it == watchpoints.end())
+        return false;
+    watchpoints.erase(it);
+    triggered.reset();
+    return true;
+}
+
+std::vector<Debugger::Watchpoint> const& Debugger::get_watchpoints() const {
+    return watchpoints;
+}
+
+template<typename F>
+Stop Debugger::run(std::set<ui32> const& temporaries, F const& done) {
+    triggered.reset();
+    for(auto pc : temporaries)
+        patch(pc);
+
+    Stop stop = Stop::Halted;
+    bool first = true;
+    while(!sandbox.is_halted()) {
+        auto pc = sandbox.get_pc();
+        if (!first && breakpoints.count(pc) > 0) {
+            stop = Stop::Breakpoint;
+            break;
+        }
+        if (!first && temporaries.count(pc) > 0 && done()) {
+            stop = Stop::Step;
+            break;
+        }
+        first = false;
+
+        run_one();
+        if (check_watchpoints()) {
+            stop = Stop::Watchpoint;
+            break;
+        }
+        // Nothing to look at after each instruction, the rest runs until a patched one
+        if (verified && watchpoints.empty() && !sandbox.is_halted() && originals.count(sandbox.get_pc()) == 0)
+            interpreter::VerifiedInterpreter::run_until_breakpoint(program, sandbox, counters);
+    }
+
+    for(auto pc : temporaries) {
+        if (breakpoints.count(pc) == 0)
+            unpatch(pc);
+    }
+    return stop;
+}
+
+Stop Debugger::resume() {
+    return run({}, [] { return false; });
+}
+
+Stop Debugger::step() {
+    triggered.reset();
+    if (sandbox.is_halted())
+        return Stop::Halted;
+    run_one();
+    if (check_watchpoints())
+        return Stop::Watchpoint;
+    return sandbox.is_halted() ? Stop::Halted : Stop::Step;
+}
+
+Stop Debugger::next() {
+    auto d = original_at(sandbox.get_pc());
+    if (sandbox.is_halted() || !d || !program::is_call(*d))
+        return step();
+    // A recursive call comes back to the same instruction deeper in the stack
+    ui32 sp = sandbox.get_sp();
+    return run({ d->pc + d->size }, [this, sp] { return sandbox.get_sp() >= sp; });
+}
+
+Stop Debugger::finish() {
+    auto d = original_at(sandbox.get_pc());
+    // The return address is right above the frame, so the stack is above it once the function returned,
+    // and below it when a deeper call does. Before any ETR, the bp isn't a frame yet.
+    ui32 frame = d && is_enter(*d) ? sandbox.get_sp() : std::max(sandbox.get_bp(), sandbox.get_sp());
+    return run(return_sites, [this, frame] { return sandbox.get_sp() > frame; });
+}
+
+Debugger::Watchpoint const* Debugger::get_triggered() const {
+    return triggered ? &watchpoints[*triggered] : nullptr;
+}
+
+void Debugger::run_one() {
+    auto pc = sandbox.get_pc();
+    auto it = originals.find(pc);
+    if (it != originals.end())
+        program.patch(pc, it->second);
+    if (verified)
+        interpreter::VerifiedInterpreter::run_next_instruction(program, sandbox, counters);
+    else
+        interpreter::Interpreter::run_next_instruction(sandbox, counters, cache);
+    if (it != originals.end())
+        program.patch(pc, breakpoint());
+}
+
+program::DecodedInstruction const* Debugger::original_at(ui32 pc) const {
+    auto it = originals.find(pc);
+    return it != originals.end() ? &it->second : program.at(pc);
+}
+
+bool Debugger::check_watchpoints() {
+    for(ui32 i = 0; i < watchpoints.size(); ++i) {
+        auto value = sandbox.get_memory_at(watchpoints[i].address);
+        if (value != watchpoints[i].value) {
+            watchpoints[i].value = value;
+            triggered = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Debugger::patch(ui32 pc) {
+    if (!verified || originals.count(pc) > 0 || !program.at(pc))
+        return;
+    originals.emplace(pc, *program.at(pc));
+    program.patch(pc, breakpoint());
+}
+
+void Debugger::unpatch(ui32 pc) {
+    auto it = originals.find(pc);
+    if (it == originals.end())
+        return;
+    program.patch(pc, it->second);
+    originals.erase(it);
+}
+
+std::string Debugger::describe(ui32 pc) const {
+    std::string text = "<outside of the code>";
+    if (pc % 4 == 0 && pc / 4 < exe.code.size())
+        text = disassembler::line_at(exe, pc / 4).text;
+    return std::to_string(pc) + " in " + symbols.location_of(pc) + " : " + text;
+}
+
+void Debugger::report(Stop stop, std::ostream& os) const {
+    switch(stop) {
+        case Stop::Breakpoint:
+            os << "Breakpoint at " << describe(sandbox.get_pc()) << '\n';
+            break;
+        case Stop::Watchpoint:
+            os << "Watchpoint at " << get_triggered()->address << " changed to " << hex(get_triggered()->value)
+               << ", stopped at " << describe(sandbox.get_pc()) << '\n';
+            break;
+        case Stop::Step:
+            os << describe(sandbox.get_pc()) << '\n';
+            break;
+        case Stop::Halted:
+            os << "Halted with " << sandbox.get_register(0) << " after " << counters.instructions << " instructions\n";
+            break;
+    }
+}
+
+bool Debugger::execute(std::string const& line, std::ostream& os) {
+    std::istringstream ss(line);
+    std::string command, first, second;
+    ss >> command >> first >> second;
+
+    auto location = [&] (std::string const& s) {
+        auto address = address_of(s);
+        if (!address)
+            os << "Location (" << s << ") not found\n";
+        return address;
+    };
+
+    if (command == "break" || command == "b") {
+        if (auto pc = location(first)) {
+            if (add_breakpoint(*pc))
+                os << "Breakpoint at " << describe(*pc) << '\n';
+            else
+                os << "No instruction starts at " << *pc << '\n';
+        }
+    } else if (command == "delete" || command == "d") {
+        if (auto pc = location(first); pc && !remove_breakpoint(*pc))
+            os << "No breakpoint at " << *pc << '\n';
+    } else if (command == "watch" || command == "w") {
+        if (auto address = location(first)) {
+            add_watchpoint(*address);
+            os << "Watchpoint at " << (*address & ~3u) << " : " << hex(sandbox.get_memory_at(*address & ~3u)) << '\n';
+        }
+    } else if (command == "unwatch" || command == "u") {
+        if (auto address = location(first); address && !remove_watchpoint(*address))
+            os << "No watchpoint at " << *address << '\n';
+    } else if (command == "continue" || command == "c") {
+        report(resume(), os);
+    } else if (command == "step" || command == "s") {
+        report(step(), os);
+    } else if (command == "next" || command == "n") {
+        report(next(), os);
+    } else if (command == "finish" || command == "f") {
+        report(finish(), os);
+    } else if (command == "registers" || command == "r") {
+        for(ui32 r = 0; r < 12; ++r)
+            os << static_cast<char>('A' + r) << " = " << hex(sandbox.get_register(r)) << " (" << static_cast<i32>(sandbox.get_register(r)) << ")\n";
+        os << "PC = " << sandbox.get_pc() << ", SP = " << sandbox.get_sp() << ", BP = " << sandbox.get_bp()
+           << ", Z = " << sandbox.get_flag_zero() << ", G = " << sandbox.get_flag_greater() << '\n';
+    } else if (command == "x") {
+        auto address = location(first);
+        auto count = second.empty() ? std::optional<ui32>(1) : number_of(second);
+        if (address && count) {
+            for(ui32 i = 0; i < *count; ++i) {
+                ui32 a = (*address & ~3u) + 4 * i;
+                os << a << " : " << hex(sandbox.get_memory_at(a)) << '\n';
+            }
+        }
+    } else if (command == "list" || command == "l") {
+        auto pc = first.empty() ? std::optional<ui32>(sandbox.get_pc()) : location(first);
+        auto count = second.empty() ? std::optional<ui32>(5) : number_of(second);
+        for(ui32 i = 0; pc && count && i < *count && *pc % 4 == 0 && *pc / 4 < exe.code.size(); ++i) {
+            auto l = disassembler::line_at(exe, *pc / 4);
+            os << (breakpoints.count(l.pc) > 0 ? "* " : "  ") << (l.pc == sandbox.get_pc() ? "> " : "  ") << describe(l.pc) << '\n';
+            *pc += l.size;
+        }
+    } else if (command == "info" || command == "i") {
+        for(auto pc : breakpoints)
+            os << "Breakpoint at " << describe(pc) << '\n';
+        for(auto const& w : watchpoints)
+            os << "Watchpoint at " << w.address << " : " << hex(w.value) << '\n';
+    } else if (command == "quit" || command == "q") {
+        sandbox.halt();
+        return false;
+    } else if (command == "help" || command == "h") {
+        os << help;
+    } else {
+        os << "Unknown command (" << command << "), see help\n";
+    }
+    return !sandbox.is_halted();
+}
+
+void Debugger::repl(std::istream& is, std::ostream& os) {
+    os << "Debugging " << (verified ? "a verified program" : "a program not passing the verifier") << ", see help\n";
+    os << describe(sandbox.get_pc()) << '\n';
+    std::string line, last;
+    while(!sandbox.is_halted()) {
+        os << "(vcrate) " << std::flush;
+        if (!std::getline(is, line))
+            return;
+        if (line.find_first_not_of(" \t") == std::string::npos)
+            line = last;
+        if (line.empty())
+            continue;
+        last = line;
+        if (!execute(line, os))
+            return;
+    }
+}
+
+}}
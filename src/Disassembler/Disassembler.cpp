@@ -0,0 +1,164 @@
+#include <vcrate/Disassembler/Disassembler.hpp>
+
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace vcrate { namespace disassembler {
+
+namespace {
+
+std::string hex(ui32 word) {
+    char s[9];
+    std::snprintf(s, sizeof(s), "%08X", word);
+    return s;
+}
+
+}
+
+Line line_at(vcx::Executable const& exe, ui32 word) {
+    ui32 extra0 = word + 1 < exe.code.size() ? exe.code[word + 1] : 0;
+    ui32 extra1 = word + 2 < exe.code.size() ? exe.code[word + 2] : 0;
+    // As the Program decodes them, a word that isn't an operation is one on its own, kept raw
+    if (!interpreter::WideInstruction::is_wide(exe.code[word])
+     && !program::is_known_operation(instruction::Instruction(exe.code[word], extra0, extra1).get_operation()))
+        return { word * 4, 4, "<unknown " + hex(exe.code[word]) + ">" };
+    ui32 size = interpreter::instruction_byte_size(exe.code[word], extra0, extra1);
+    bool conditional_jump = false;
+    if (!interpreter::WideInstruction::is_wide(exe.code[word])) {
+        switch(instruction::Instruction(exe.code[word], extra0, extra1).get_operation()) {
+            case bytecode::Operations::JMPE: case bytecode::Operations::JMPNE:
+            case bytecode::Operations::JMPG: case bytecode::Operations::JMPGE:
+                conditional_jump = true;
+                break;
+            default:
+                break;
+        }
+    }
+    return { word * 4, size, interpreter::instruction_to_string(exe.code[word], extra0, extra1), conditional_jump };
+}
+
+std::vector<Line> decode_chunk(vcx::Executable const& exe, ui32 begin, ui32 end) {
+    std::vector<Line> lines;
+    for(ui32 word = begin; word < end && word < exe.code.size();) {
+        lines.push_back(line_at(exe, word));
+        word += lines.back().size / 4;
+    }
+    return lines;
+}
+
+void disassemble(vcx::Executable const& exe, std::function<void(Line const&)> const& emit, ui32 workers, ui32 chunk_words) {
+    workers = std::max(workers, 1u);
+    chunk_words = std::max(chunk_words, 1u);
+    ui32 code_words = exe.code.size();
+    ui32 chunks = (code_words + chunk_words - 1) / chunk_words;
+    // Chunks decoded ahead of the one emitted, so a large executable isn't held in memory as text
+    ui32 const window = 2 * workers;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<ui32, std::vector<Line>> decoded;
+    ui32 next = 0;
+    ui32 emitted = 0;
+
+    std::vector<std::thread> threads;
+    for(ui32 w = 0; w < std::min(workers, chunks); ++w) {
+        threads.emplace_back([&] {
+            for(;;) {
+                ui32 chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&] { return next >= chunks || next < emitted + window; });
+                    if (next >= chunks)
+                        return;
+                    chunk = next++;
+                }
+                auto lines = decode_chunk(exe, chunk * chunk_words, std::min(code_words, (chunk + 1) * chunk_words));
+                std::lock_guard<std::mutex> lock(mutex);
+                decoded.emplace(chunk, std::move(lines));
+                changed.notify_all();
+            }
+        });
+    }
+
+    // Word of the next instruction of the code
+    ui32 position = 0;
+    for(ui32 chunk = 0; chunk < chunks; ++chunk) {
+        std::vector<Line> lines;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return decoded.count(chunk) > 0; });
+            lines = std::move(decoded[chunk]);
+            decoded.erase(chunk);
+        }
+
+        ui32 end = std::min(code_words, (chunk + 1) * chunk_words);
+        auto first = [&] {
+            return std::lower_bound(lines.begin(), lines.end(), position * 4, [] (Line const& l, ui32 pc) { return l.pc < pc; });
+        };
+        // Resynchronizes with the decoding of the chunk
+        auto it = first();
+        while(position < end && (it == lines.end() || it->pc != position * 4)) {
+            auto line = line_at(exe, position);
+            position += line.size / 4;
+            emit(line);
+            it = first();
+        }
+        if (position < end) {
+            for(; it != lines.end(); ++it)
+                emit(*it);
+            position = lines.back().pc / 4 + lines.back().size / 4;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++emitted;
+        changed.notify_all();
+    }
+
+    for(auto& thread : threads)
+        thread.join();
+}
+
+char const* coverage_of(coverage::Coverage const& coverage, Line const& line) {
+    if (!coverage.is_executed(line.pc))
+        return "missed";
+    if (!line.conditional_jump)
+        return "executed";
+    bool taken = coverage.is_taken(line.pc);
+    bool not_taken = coverage.is_not_taken(line.pc);
+    if (taken && not_taken)
+        return "both";
+    return taken ? "taken" : not_taken ? "not-taken" : "executed";
+}
+
+void write_plain(std::ostream& os, vcx::Executable const& exe, ui32 workers, coverage::Coverage const* coverage) {
+    os << "entry\t" << exe.entry_point << '\n';
+    for(auto const& p : exe.symbols)
+        os << "symbol\t" << p.first << '\t' << p.second << '\n';
+    for(ui32 i = 0; i < exe.jmp_table.size(); ++i)
+        os << "jump\t" << i << '\t' << exe.jmp_table[i] << '\n';
+    for(ui32 i = 0; i < exe.data.size(); ++i)
+        os << "data\t" << i * 4 << '\t' << hex(exe.data[i]) << '\n';
+
+    program::SymbolIndex symbols(exe);
+    disassemble(exe, [&] (Line const& line) {
+        os << "code\t" << line.pc << '\t';
+        for(ui32 w = 0; w < line.size / 4; ++w) {
+            ui32 word = line.pc / 4 + w;
+            os << (w > 0 ? " " : "") << hex(word < exe.code.size() ? exe.code[word] : 0);
+        }
+        os << '\t' << line.text << '\t' << symbols.location_of(line.pc);
+        if (coverage)
+            os << '\t' << coverage_of(*coverage, line);
+        os << '\n';
+    }, workers);
+}
+
+}}
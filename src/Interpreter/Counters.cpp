@@ -0,0 +1,52 @@
+#include <vcrate/Interpreter/Counters.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace vcrate { namespace interpreter {
+
+Counters::Counters(SandBox const& sandbox) : stack_base(sandbox.get_sp()) {}
+
+void Counters::track_heap() {
+    if (!block_sizes)
+        block_sizes.emplace();
+}
+
+bool Counters::is_tracking_heap() const {
+    return block_sizes.has_value();
+}
+
+void Counters::track_allocate(ui32 address, ui32 size) {
+    heap_in_use += size;
+    peak_heap = std::max(peak_heap, heap_in_use);
+    (*block_sizes)[address] = size;
+}
+
+void Counters::track_deallocate(ui32 address) {
+    auto it = block_sizes->find(address);
+    if (it != block_sizes->end()) {
+        heap_in_use -= it->second;
+        block_sizes->erase(it);
+    }
+}
+
+std::string Counters::to_json() const {
+    std::stringstream ss;
+    ss << "{"
+       << "\"instructions\": " << instructions << ", "
+       << "\"calls\": " << calls << ", "
+       << "\"allocations\": " << allocations << ", "
+       << "\"deallocations\": " << deallocations << ", "
+       << "\"allocated_bytes\": " << allocated_bytes << ", "
+       << "\"output_bytes\": " << output_bytes << ", "
+       << "\"peak_stack_depth\": " << peak_stack_depth << ", ";
+    if (block_sizes) {
+        ss << "\"heap_in_use\": " << heap_in_use << ", "
+           << "\"peak_heap\": " << peak_heap << ", ";
+    }
+    ss << "\"traps\": " << traps
+       << "}";
+    return ss.str();
+}
+
+}}
@@ -0,0 +1,82 @@
+#include <vcrate/Interpreter/DecodeCache.hpp>
+
+#include <vcrate/Program/Program.hpp>
+
+namespace vcrate { namespace interpreter {
+
+namespace {
+
+template<typename I>
+void decode_arguments(CachedInstruction& c, I const& i, ui32 count) {
+    if (count == 1) {
+        c.args[0] = i.get_complete_argument();
+    } else if (count == 2) {
+        c.args[0] = i.get_first_argument();
+        c.args[1] = i.get_second_argument();
+    }
+}
+
+}
+
+CachedInstruction CachedInstruction::decode(ui32 main_instruction, ui32 extra0, ui32 extra1) {
+    CachedInstruction c;
+    if (WideInstruction::is_wide(main_instruction)) {
+        WideInstruction i(main_instruction, extra0, extra1);
+        c.wide = true;
+        c.operation = static_cast<ui8>(i.get_operation());
+        c.size = i.get_byte_size();
+        decode_arguments(c, i, WideInstruction::arg_count_of(i.get_operation()));
+    } else {
+        instruction::Instruction i(main_instruction, extra0, extra1);
+        c.operation = static_cast<ui8>(i.get_operation());
+        c.size = i.get_byte_size();
+        if (program::is_known_operation(i.get_operation()))
+            decode_arguments(c, i, bytecode::OpDefinition::get(i.get_operation()).arg_count());
+    }
+
+    c.words[0] = main_instruction;
+    if (c.size > 4)
+        c.words[1] = extra0;
+    if (c.size > 8)
+        c.words[2] = extra1;
+    return c;
+}
+
+bool CachedInstruction::decoded_from(SandBox const& sandbox, ui32 pc) const {
+    for(ui32 w = 0; w < size / 4; ++w)
+        if (sandbox.get_memory_at(pc + 4 * w) != words[w])
+            return false;
+    return true;
+}
+
+DecodeCache::DecodeCache(ui32 begin, ui32 end) : begin(begin), slots(end > begin ? (end - begin) / 4 : 0), filled(slots.size(), false) {}
+
+DecodeCache::DecodeCache(vcx::Executable const& exe) : DecodeCache(0, exe.code.size() * 4) {}
+
+CachedInstruction const& DecodeCache::fetch(SandBox const& sandbox, ui32 pc) {
+    ui32 slot = (pc - begin) / 4;
+    if (pc < begin || pc % 4 != 0 || slot >= slots.size()) {
+        outside = CachedInstruction::decode(sandbox.get_memory_at(pc), sandbox.get_memory_at(pc + 4), sandbox.get_memory_at(pc + 8));
+        return outside;
+    }
+
+    if (filled[slot] && slots[slot].decoded_from(sandbox, pc)) {
+        ++hits;
+        return slots[slot];
+    }
+
+    ++misses;
+    slots[slot] = CachedInstruction::decode(sandbox.get_memory_at(pc), sandbox.get_memory_at(pc + 4), sandbox.get_memory_at(pc + 8));
+    filled[slot] = true;
+    return slots[slot];
+}
+
+ui64 DecodeCache::get_hits() const {
+    return hits;
+}
+
+ui64 DecodeCache::get_misses() const {
+    return misses;
+}
+
+}}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <bitset>
 #include <cmath>
+#include <limits>
 
 namespace vcrate { namespace interpreter {
 
@@ -39,8 +40,93 @@ unsigned has_unsigned(int f) {
     return convert<int, unsigned>(f);
 }
 
-void Interpreter::run_next_instruction(SandBox& sandbox) {
-    auto instruction = fetch_instruction_and_move(sandbox);
+f64 has_double(ui64 i) {
+    return convert<ui64, f64>(i);
+}
+
+i64 has_long(ui64 i) {
+    return convert<ui64, i64>(i);
+}
+
+ui64 has_unsigned_long(f64 f) {
+    return convert<f64, ui64>(f);
+}
+
+ui64 has_unsigned_long(i64 i) {
+    return convert<i64, ui64>(i);
+}
+
+ui64 make_wide(ui32 low, ui32 high) {
+    return static_cast<ui64>(low) | (static_cast<ui64>(high) << 32);
+}
+
+ui32 low_of(ui64 value) {
+    return static_cast<ui32>(value);
+}
+
+ui32 high_of(ui64 value) {
+    return static_cast<ui32>(value >> 32);
+}
+
+ui32 high_register_of(instruction::Register reg) {
+    if (reg.id >= instruction::Register::L.id) {
+        raise_trap(TrapCode::InvalidRegisterPair);
+        return reg.id;
+    }
+    return reg.id + 1;
+}
+
+// 1 instead of 0, the division goes on but its result isn't written once the trap is raised
+template<typename T>
+T divisor_of(T value) {
+    if (value == 0) {
+        raise_trap(TrapCode::DivisionByZero);
+        return 1;
+    }
+    return value;
+}
+
+// Wraps like the other operations: the lowest value divided by -1 is itself, where the host would fault
+template<typename T>
+T quotient_of(T dividend, T divisor) {
+    divisor = divisor_of(divisor);
+    if (divisor == -1 && dividend == std::numeric_limits<T>::min())
+        return dividend;
+    return dividend / divisor;
+}
+
+ui64 get_memory64_at(SandBox& sandbox, ui32 address) {
+    return make_wide(sandbox.get_memory_at(address), sandbox.get_memory_at(address + 4));
+}
+
+void set_memory64_at(SandBox& sandbox, ui32 address, ui64 value) {
+    sandbox.set_memory_at(address, low_of(value));
+    sandbox.set_memory_at(address + 4, high_of(value));
+}
+
+void Interpreter::run_next_instruction(SandBox& sandbox, Counters& counters) {
+    auto pc = sandbox.get_pc();
+    auto instruction = CachedInstruction::decode(sandbox.get_memory_at(pc), sandbox.get_memory_at(pc + 4), sandbox.get_memory_at(pc + 8));
+    Interpreter::execute(sandbox, counters, instruction);
+}
+
+void Interpreter::run_next_instruction(SandBox& sandbox, Counters& counters, DecodeCache& cache) {
+    Interpreter::execute(sandbox, counters, cache.fetch(sandbox, sandbox.get_pc()));
+}
+
+void Interpreter::execute(SandBox& sandbox, Counters& counters, CachedInstruction const& instruction) {
+    auto pc = sandbox.get_pc();
+    Interpreter::execute_operation(sandbox, counters, instruction);
+    if (pending_trap != TrapCode::None)
+        handle_trap(sandbox, counters, pc);
+}
+
+void Interpreter::execute_operation(SandBox& sandbox, Counters& counters, CachedInstruction const& instruction) {
+    ++counters.instructions;
+    sandbox.set_pc(sandbox.get_pc() + instruction.get_byte_size());
+    if (instruction.wide)
+        return Interpreter::execute_wide(sandbox, instruction);
+
     using Operations = bytecode::Operations;
     switch(instruction.get_operation()) {
         case Operations::ADD:   return Interpreter::instruction_ADD(sandbox, instruction);
@@ -58,7 +144,7 @@ void Interpreter::run_next_instruction(SandBox& sandbox) {
         case Operations::MOV:   return Interpreter::instruction_MOV(sandbox, instruction);
         case Operations::LEA:   return Interpreter::instruction_LEA(sandbox, instruction);
         case Operations::POP:   return Interpreter::instruction_POP(sandbox, instruction);
-        case Operations::PUSH:  return Interpreter::instruction_PUSH(sandbox, instruction);
+        case Operations::PUSH:  return Interpreter::instruction_PUSH(sandbox, instruction, counters);
         case Operations::JMP:   return Interpreter::instruction_JMP(sandbox, instruction);
         case Operations::JMPE:  return Interpreter::instruction_JMPE(sandbox, instruction);
         case Operations::JMPNE: return Interpreter::instruction_JMPNE(sandbox, instruction);
@@ -79,14 +165,14 @@ void Interpreter::run_next_instruction(SandBox& sandbox) {
         case Operations::INCF:  return Interpreter::instruction_INCF(sandbox, instruction);
         case Operations::DEC:   return Interpreter::instruction_DEC(sandbox, instruction);
         case Operations::DECF:  return Interpreter::instruction_DECF(sandbox, instruction);
-        case Operations::NEW:   return Interpreter::instruction_NEW(sandbox, instruction);
-        case Operations::DEL:   return Interpreter::instruction_DEL(sandbox, instruction);
-        case Operations::CALL:  return Interpreter::instruction_CALL(sandbox, instruction);
+        case Operations::NEW:   return Interpreter::instruction_NEW(sandbox, instruction, counters);
+        case Operations::DEL:   return Interpreter::instruction_DEL(sandbox, instruction, counters);
+        case Operations::CALL:  return Interpreter::instruction_CALL(sandbox, instruction, counters);
         case Operations::RET:   return Interpreter::instruction_RET(sandbox, instruction);
-        case Operations::ETR:   return Interpreter::instruction_ETR(sandbox, instruction);
+        case Operations::ETR:   return Interpreter::instruction_ETR(sandbox, instruction, counters);
         case Operations::LVE:   return Interpreter::instruction_LVE(sandbox, instruction);
         case Operations::HLT:   return Interpreter::instruction_HLT(sandbox, instruction);
-        case Operations::OUT:   return Interpreter::instruction_OUT(sandbox, instruction);
+        case Operations::OUT:   return Interpreter::instruction_OUT(sandbox, instruction, counters);
         case Operations::DBG:   return Interpreter::instruction_DBG(sandbox, instruction);
         case Operations::DBGU:  return Interpreter::instruction_DBGU(sandbox, instruction);
         case Operations::DBGF:  return Interpreter::instruction_DBGF(sandbox, instruction);
@@ -97,10 +183,20 @@ void Interpreter::run_next_instruction(SandBox& sandbox) {
         case Operations::FTI:   return Interpreter::instruction_FTI(sandbox, instruction);
         case Operations::FTU:   return Interpreter::instruction_FTU(sandbox, instruction);
         default:
-            throw std::runtime_error("Operations Unknown");
+            return raise_trap(TrapCode::UnknownOperation);
     }
 }
 
+void Interpreter::run(SandBox& sandbox, Counters& counters) {
+    while(!sandbox.is_halted())
+        Interpreter::run_next_instruction(sandbox, counters);
+}
+
+void Interpreter::run(SandBox& sandbox, Counters& counters, DecodeCache& cache) {
+    while(!sandbox.is_halted())
+        Interpreter::run_next_instruction(sandbox, counters, cache);
+}
+
 instruction::Instruction Interpreter::fetch_instruction(SandBox const& sandbox) {
     auto pc = sandbox.get_pc(); 
     return instruction::Instruction(sandbox.get_memory_at(pc), sandbox.get_memory_at(pc + 4), sandbox.get_memory_at(pc + 8)); 
@@ -112,9 +208,50 @@ instruction::Instruction Interpreter::fetch_instruction_and_move(SandBox& sandbo
     return inst; 
 }
 
+void Interpreter::execute_wide(SandBox& sandbox, CachedInstruction const& instruction) {
+    switch(instruction.get_wide_operation()) {
+        case WideOperations::ADDL:  return Interpreter::instruction_ADDL(sandbox, instruction);
+        case WideOperations::SUBL:  return Interpreter::instruction_SUBL(sandbox, instruction);
+        case WideOperations::MULL:  return Interpreter::instruction_MULL(sandbox, instruction);
+        case WideOperations::DIVL:  return Interpreter::instruction_DIVL(sandbox, instruction);
+        case WideOperations::DIVLU: return Interpreter::instruction_DIVLU(sandbox, instruction);
+        case WideOperations::MODL:  return Interpreter::instruction_MODL(sandbox, instruction);
+        case WideOperations::SHLL:  return Interpreter::instruction_SHLL(sandbox, instruction);
+        case WideOperations::SHRL:  return Interpreter::instruction_SHRL(sandbox, instruction);
+        case WideOperations::CMPL:  return Interpreter::instruction_CMPL(sandbox, instruction);
+        case WideOperations::CMPLU: return Interpreter::instruction_CMPLU(sandbox, instruction);
+        case WideOperations::MOVL:  return Interpreter::instruction_MOVL(sandbox, instruction);
+        case WideOperations::INCL:  return Interpreter::instruction_INCL(sandbox, instruction);
+        case WideOperations::DECL:  return Interpreter::instruction_DECL(sandbox, instruction);
+        case WideOperations::ADDD:  return Interpreter::instruction_ADDD(sandbox, instruction);
+        case WideOperations::SUBD:  return Interpreter::instruction_SUBD(sandbox, instruction);
+        case WideOperations::MULD:  return Interpreter::instruction_MULD(sandbox, instruction);
+        case WideOperations::DIVD:  return Interpreter::instruction_DIVD(sandbox, instruction);
+        case WideOperations::MODD:  return Interpreter::instruction_MODD(sandbox, instruction);
+        case WideOperations::CMPD:  return Interpreter::instruction_CMPD(sandbox, instruction);
+        case WideOperations::ITL:   return Interpreter::instruction_ITL(sandbox, instruction);
+        case WideOperations::UTL:   return Interpreter::instruction_UTL(sandbox, instruction);
+        case WideOperations::LTI:   return Interpreter::instruction_LTI(sandbox, instruction);
+        case WideOperations::LTD:   return Interpreter::instruction_LTD(sandbox, instruction);
+        case WideOperations::DTL:   return Interpreter::instruction_DTL(sandbox, instruction);
+        case WideOperations::ITD:   return Interpreter::instruction_ITD(sandbox, instruction);
+        case WideOperations::DTI:   return Interpreter::instruction_DTI(sandbox, instruction);
+        case WideOperations::FTD:   return Interpreter::instruction_FTD(sandbox, instruction);
+        case WideOperations::DTF:   return Interpreter::instruction_DTF(sandbox, instruction);
+        case WideOperations::DBGL:  return Interpreter::instruction_DBGL(sandbox, instruction);
+        case WideOperations::DBGLU: return Interpreter::instruction_DBGLU(sandbox, instruction);
+        case WideOperations::DBGD:  return Interpreter::instruction_DBGD(sandbox, instruction);
+        default:
+            return raise_trap(TrapCode::UnknownOperation);
+    }
+}
+
 void Interpreter::write_to(SandBox& sandbox, instruction::Argument const& arg, ui32 value) {
+    // A faulting instruction leaves its destination as it was, for a handler returning to the next one
+    if (pending_trap != TrapCode::None)
+        return;
     std::visit(instruction::Visitor {
-        [               ] (instruction::Value) -> void       { throw std::runtime_error("Cannot write to that argument"); },
+        [               ] (instruction::Value) -> void       { raise_trap(TrapCode::InvalidWrite); },
         [&sandbox, value] (instruction::Register arg)        { sandbox.set_register(arg.id, value); },
         [&sandbox, value] (instruction::Displacement arg)    { sandbox.set_memory_at(sandbox.get_register(arg.reg.id) + arg.displacement, value); },
         [&sandbox, value] (instruction::Address arg)         { sandbox.set_memory_at(arg.address, value); },
@@ -134,15 +271,50 @@ ui32 Interpreter::value_of(SandBox& sandbox, instruction::Argument const& arg) {
 
 ui32 Interpreter::address_of(SandBox& sandbox, instruction::Argument const& arg) {
     return std::visit(instruction::Visitor {
-        [        ] (instruction::Value) -> ui32      { throw std::runtime_error("This argument has no address"); },
-        [&sandbox] (instruction::Register) -> ui32   { throw std::runtime_error("This argument has no address"); },
+        [        ] (instruction::Value) -> ui32      { raise_trap(TrapCode::NoAddress); return 0; },
+        [        ] (instruction::Register) -> ui32   { raise_trap(TrapCode::NoAddress); return 0; },
         [&sandbox] (instruction::Displacement arg)   { return sandbox.get_register(arg.reg.id) + arg.displacement; },
         [&sandbox] (instruction::Address arg)        { return static_cast<ui32>(arg.address); },
         [&sandbox] (instruction::Deferred arg)       { return sandbox.get_register(arg.reg.id); }
     }, arg);
 }
 
-void Interpreter::instruction_ADD(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::write64_to(SandBox& sandbox, instruction::Argument const& arg, ui64 value) {
+    if (pending_trap != TrapCode::None)
+        return;
+    std::visit(instruction::Visitor {
+        [               ] (instruction::Value) -> void       { raise_trap(TrapCode::InvalidWrite); },
+        [&sandbox, value] (instruction::Register arg)        { 
+            auto high = high_register_of(arg);
+            if (pending_trap != TrapCode::None)
+                return;
+            sandbox.set_register(arg.id, low_of(value)); 
+            sandbox.set_register(high, high_of(value)); 
+        },
+        [&sandbox, value] (instruction::Displacement arg)    { set_memory64_at(sandbox, sandbox.get_register(arg.reg.id) + arg.displacement, value); },
+        [&sandbox, value] (instruction::Address arg)         { set_memory64_at(sandbox, arg.address, value); },
+        [&sandbox, value] (instruction::Deferred arg)        { set_memory64_at(sandbox, sandbox.get_register(arg.reg.id), value); }
+    }, arg);
+}
+
+ui64 Interpreter::value64_of(SandBox& sandbox, instruction::Argument const& arg) {
+    return std::visit(instruction::Visitor {
+        [        ] (instruction::Value arg)          { return has_unsigned_long(static_cast<i64>(arg.value)); },
+        [&sandbox] (instruction::Register arg)       { return make_wide(sandbox.get_register(arg.id), sandbox.get_register(high_register_of(arg))); },
+        [&sandbox] (instruction::Displacement arg)   { return get_memory64_at(sandbox, sandbox.get_register(arg.reg.id) + arg.displacement); },
+        [&sandbox] (instruction::Address arg)        { return get_memory64_at(sandbox, arg.address); },
+        [&sandbox] (instruction::Deferred arg)       { return get_memory64_at(sandbox, sandbox.get_register(arg.reg.id)); }
+    }, arg);
+}
+
+f64 Interpreter::double_of(SandBox& sandbox, instruction::Argument const& arg) {
+    // Immediates can only hold 32 bits, so they are read as a float and widened
+    if (auto value = std::get_if<instruction::Value>(&arg))
+        return static_cast<f64>(has_float(static_cast<ui32>(value->value)));
+    return has_double(Interpreter::value64_of(sandbox, arg));
+}
+
+void Interpreter::instruction_ADD(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -151,7 +323,7 @@ void Interpreter::instruction_ADD(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_ADDF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_ADDF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -160,7 +332,7 @@ void Interpreter::instruction_ADDF(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_SUB(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_SUB(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -169,7 +341,7 @@ void Interpreter::instruction_SUB(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_SUBF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_SUBF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -178,16 +350,16 @@ void Interpreter::instruction_SUBF(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_MOD(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_MOD(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
         a0,
-        Interpreter::value_of(sandbox, a0) % Interpreter::value_of(sandbox, a1)
+        Interpreter::value_of(sandbox, a0) % divisor_of(Interpreter::value_of(sandbox, a1))
     );
 }
 
-void Interpreter::instruction_MODF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_MODF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -196,7 +368,7 @@ void Interpreter::instruction_MODF(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_MUL(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_MUL(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -205,7 +377,7 @@ void Interpreter::instruction_MUL(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_MULU(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_MULU(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -214,7 +386,7 @@ void Interpreter::instruction_MULU(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_MULF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_MULF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -223,26 +395,25 @@ void Interpreter::instruction_MULF(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_DIV(SandBox& sandbox, instruction::Instruction const& instruction) {
-    // TODO : exception if a1 is 0
+void Interpreter::instruction_DIV(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
         a0,
-        has_unsigned(has_int(Interpreter::value_of(sandbox, a0)) / has_int(Interpreter::value_of(sandbox, a1)))
+        has_unsigned(quotient_of(has_int(Interpreter::value_of(sandbox, a0)), has_int(Interpreter::value_of(sandbox, a1))))
     );
 }
 
-void Interpreter::instruction_DIVU(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DIVU(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
         a0,
-        Interpreter::value_of(sandbox, a0) / Interpreter::value_of(sandbox, a1)
+        Interpreter::value_of(sandbox, a0) / divisor_of(Interpreter::value_of(sandbox, a1))
     );
 }
 
-void Interpreter::instruction_DIVF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DIVF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -251,7 +422,7 @@ void Interpreter::instruction_DIVF(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_MOV(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_MOV(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -259,7 +430,7 @@ void Interpreter::instruction_MOV(SandBox& sandbox, instruction::Instruction con
         Interpreter::value_of(sandbox, a1)
     );
 }
-void Interpreter::instruction_LEA(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_LEA(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -268,15 +439,16 @@ void Interpreter::instruction_LEA(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_POP(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_POP(SandBox& sandbox, CachedInstruction const& instruction) {
     Interpreter::write_to(sandbox, instruction.get_complete_argument(), sandbox.pop_32());
 }
 
-void Interpreter::instruction_PUSH(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_PUSH(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters) {
     sandbox.push_32(Interpreter::value_of(sandbox, instruction.get_complete_argument()));
+    counters.on_stack(sandbox.get_sp());
 }
 
-void Interpreter::instruction_JMP(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_JMP(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     auto pc = Interpreter::value_of(sandbox, arg);
     auto arg_type = get_argument_type(arg);
@@ -285,27 +457,27 @@ void Interpreter::instruction_JMP(SandBox& sandbox, instruction::Instruction con
     sandbox.set_pc(pc);
 }
 
-void Interpreter::instruction_JMPE(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_JMPE(SandBox& sandbox, CachedInstruction const& instruction) {
     if (sandbox.get_flag_zero())
         Interpreter::instruction_JMP(sandbox, instruction);
 }
 
-void Interpreter::instruction_JMPNE(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_JMPNE(SandBox& sandbox, CachedInstruction const& instruction) {
     if (!sandbox.get_flag_zero())
         Interpreter::instruction_JMP(sandbox, instruction);
 }
 
-void Interpreter::instruction_JMPG(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_JMPG(SandBox& sandbox, CachedInstruction const& instruction) {
     if (sandbox.get_flag_greater())
         Interpreter::instruction_JMP(sandbox, instruction);
 }
 
-void Interpreter::instruction_JMPGE(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_JMPGE(SandBox& sandbox, CachedInstruction const& instruction) {
     if (sandbox.get_flag_greater() || sandbox.get_flag_zero())
         Interpreter::instruction_JMP(sandbox, instruction);
 }
 
-void Interpreter::instruction_AND(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_AND(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -314,7 +486,7 @@ void Interpreter::instruction_AND(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_OR(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_OR(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -323,7 +495,7 @@ void Interpreter::instruction_OR(SandBox& sandbox, instruction::Instruction cons
     );
 }
 
-void Interpreter::instruction_XOR(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_XOR(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -332,7 +504,7 @@ void Interpreter::instruction_XOR(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_NOT(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_NOT(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -340,7 +512,7 @@ void Interpreter::instruction_NOT(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_SHL(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_SHL(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -349,7 +521,7 @@ void Interpreter::instruction_SHL(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_RTL(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_RTL(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     ui32 v0 = Interpreter::value_of(sandbox, a0);
@@ -360,7 +532,7 @@ void Interpreter::instruction_RTL(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_SHR(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_SHR(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     Interpreter::write_to(sandbox, 
@@ -369,7 +541,7 @@ void Interpreter::instruction_SHR(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_RTR(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_RTR(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     ui32 v0 = Interpreter::value_of(sandbox, a0);
@@ -380,7 +552,7 @@ void Interpreter::instruction_RTR(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_SWP(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_SWP(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     ui32 v0 = Interpreter::value_of(sandbox, a0);
@@ -389,7 +561,7 @@ void Interpreter::instruction_SWP(SandBox& sandbox, instruction::Instruction con
     Interpreter::write_to(sandbox, a1, v0);
 }
 
-void Interpreter::instruction_CMP(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_CMP(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     ui32 v0 = static_cast<i32>(Interpreter::value_of(sandbox, a0));
@@ -398,7 +570,7 @@ void Interpreter::instruction_CMP(SandBox& sandbox, instruction::Instruction con
     sandbox.set_flag_greater(v0 > v1);
 }
 
-void Interpreter::instruction_CMPU(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_CMPU(SandBox& sandbox, CachedInstruction const& instruction) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
     ui32 v0 = Interpreter::value_of(sandbox, a0);
@@ -407,7 +579,7 @@ void Interpreter::instruction_CMPU(SandBox& sandbox, instruction::Instruction co
     sandbox.set_flag_greater(v0 > v1);
 }
 
-void Interpreter::instruction_INC(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_INC(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -415,7 +587,7 @@ void Interpreter::instruction_INC(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_INCF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_INCF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -423,7 +595,7 @@ void Interpreter::instruction_INCF(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_DEC(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DEC(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -431,7 +603,7 @@ void Interpreter::instruction_DEC(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_DECF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DECF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -439,21 +611,26 @@ void Interpreter::instruction_DECF(SandBox& sandbox, instruction::Instruction co
     );
 }
 
-void Interpreter::instruction_NEW(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_NEW(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters) {
     auto a0 = instruction.get_first_argument();
     auto a1 = instruction.get_second_argument();
+    auto size = Interpreter::value_of(sandbox, a1);
+    auto address = sandbox.allocate(size);
+    counters.on_allocate(address, size);
     Interpreter::write_to(sandbox, 
         a0, 
-        sandbox.allocate(Interpreter::value_of(sandbox, a1))
+        address
     );
 }
 
-void Interpreter::instruction_DEL(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DEL(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters) {
     auto arg = instruction.get_complete_argument();
-    sandbox.deallocate(Interpreter::value_of(sandbox, arg));
+    auto address = Interpreter::value_of(sandbox, arg);
+    sandbox.deallocate(address);
+    counters.on_deallocate(address);
 }
 
-void Interpreter::instruction_CALL(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_CALL(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters) {
     auto arg = instruction.get_complete_argument();
     auto pc = Interpreter::value_of(sandbox, arg);
     auto arg_type = get_argument_type(arg);
@@ -461,48 +638,52 @@ void Interpreter::instruction_CALL(SandBox& sandbox, instruction::Instruction co
         pc += sandbox.get_pc();
     sandbox.push_32(sandbox.get_pc());
     sandbox.set_pc(pc);
+    ++counters.calls;
+    counters.on_stack(sandbox.get_sp());
 }
 
-void Interpreter::instruction_RET(SandBox& sandbox, instruction::Instruction const&) {
+void Interpreter::instruction_RET(SandBox& sandbox, CachedInstruction const&) {
     sandbox.set_pc(sandbox.pop_32());
 }
 
-void Interpreter::instruction_ETR(SandBox& sandbox, instruction::Instruction const&) {
+void Interpreter::instruction_ETR(SandBox& sandbox, CachedInstruction const&, Counters& counters) {
     sandbox.push_32(sandbox.get_bp());
     sandbox.set_bp(sandbox.get_sp());
+    counters.on_stack(sandbox.get_sp());
 }
 
-void Interpreter::instruction_LVE(SandBox& sandbox, instruction::Instruction const&) {
+void Interpreter::instruction_LVE(SandBox& sandbox, CachedInstruction const&) {
     sandbox.set_sp(sandbox.get_bp());
     sandbox.set_bp(sandbox.pop_32());
 }
 
-void Interpreter::instruction_HLT(SandBox& sandbox, instruction::Instruction const&) {
+void Interpreter::instruction_HLT(SandBox& sandbox, CachedInstruction const&) {
     sandbox.halt();
 }
 
-void Interpreter::instruction_OUT(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_OUT(SandBox& sandbox, CachedInstruction const& instruction, Counters& counters) {
     auto arg = instruction.get_complete_argument();
     //std::cout << Interpreter::value_of(sandbox, arg) << std::endl;
     sandbox.output(static_cast<ui8>(Interpreter::value_of(sandbox, arg)));
+    ++counters.output_bytes;
 }
 
-void Interpreter::instruction_DBG(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DBG(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     std::cout << has_int(Interpreter::value_of(sandbox, arg));
 }
 
-void Interpreter::instruction_DBGU(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DBGU(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     std::cout << Interpreter::value_of(sandbox, arg);
 }
 
-void Interpreter::instruction_DBGF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_DBGF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     std::cout << has_float(Interpreter::value_of(sandbox, arg));
 }
 
-void Interpreter::instruction_ITU(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_ITU(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -510,7 +691,7 @@ void Interpreter::instruction_ITU(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_ITF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_ITF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -518,7 +699,7 @@ void Interpreter::instruction_ITF(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_UTF(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_UTF(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -526,7 +707,7 @@ void Interpreter::instruction_UTF(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_UTI(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_UTI(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -534,7 +715,7 @@ void Interpreter::instruction_UTI(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_FTI(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_FTI(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -542,7 +723,7 @@ void Interpreter::instruction_FTI(SandBox& sandbox, instruction::Instruction con
     );
 }
 
-void Interpreter::instruction_FTU(SandBox& sandbox, instruction::Instruction const& instruction) {
+void Interpreter::instruction_FTU(SandBox& sandbox, CachedInstruction const& instruction) {
     auto arg = instruction.get_complete_argument();
     Interpreter::write_to(sandbox, 
         arg,
@@ -550,4 +731,260 @@ void Interpreter::instruction_FTU(SandBox& sandbox, instruction::Instruction con
     );
 }
 
+void Interpreter::instruction_ADDL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a0) + Interpreter::value64_of(sandbox, a1)
+    );
+}
+
+void Interpreter::instruction_SUBL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a0) - Interpreter::value64_of(sandbox, a1)
+    );
+}
+
+void Interpreter::instruction_MULL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a0) * Interpreter::value64_of(sandbox, a1)
+    );
+}
+
+void Interpreter::instruction_DIVL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        has_unsigned_long(quotient_of(has_long(Interpreter::value64_of(sandbox, a0)), has_long(Interpreter::value64_of(sandbox, a1))))
+    );
+}
+
+void Interpreter::instruction_DIVLU(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a0) / divisor_of(Interpreter::value64_of(sandbox, a1))
+    );
+}
+
+void Interpreter::instruction_MODL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a0) % divisor_of(Interpreter::value64_of(sandbox, a1))
+    );
+}
+
+void Interpreter::instruction_SHLL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a0) << (Interpreter::value64_of(sandbox, a1) & 63)
+    );
+}
+
+void Interpreter::instruction_SHRL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a0) >> (Interpreter::value64_of(sandbox, a1) & 63)
+    );
+}
+
+void Interpreter::instruction_CMPL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    i64 v0 = has_long(Interpreter::value64_of(sandbox, a0));
+    i64 v1 = has_long(Interpreter::value64_of(sandbox, a1));
+    sandbox.set_flag_zero(v0 == v1);
+    sandbox.set_flag_greater(v0 > v1);
+}
+
+void Interpreter::instruction_CMPLU(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    ui64 v0 = Interpreter::value64_of(sandbox, a0);
+    ui64 v1 = Interpreter::value64_of(sandbox, a1);
+    sandbox.set_flag_zero(v0 == v1);
+    sandbox.set_flag_greater(v0 > v1);
+}
+
+void Interpreter::instruction_MOVL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        Interpreter::value64_of(sandbox, a1)
+    );
+}
+
+void Interpreter::instruction_INCL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        Interpreter::value64_of(sandbox, arg) + 1
+    );
+}
+
+void Interpreter::instruction_DECL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        Interpreter::value64_of(sandbox, arg) - 1
+    );
+}
+
+void Interpreter::instruction_ADDD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        has_unsigned_long(Interpreter::double_of(sandbox, a0) + Interpreter::double_of(sandbox, a1))
+    );
+}
+
+void Interpreter::instruction_SUBD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        has_unsigned_long(Interpreter::double_of(sandbox, a0) - Interpreter::double_of(sandbox, a1))
+    );
+}
+
+void Interpreter::instruction_MULD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        has_unsigned_long(Interpreter::double_of(sandbox, a0) * Interpreter::double_of(sandbox, a1))
+    );
+}
+
+void Interpreter::instruction_DIVD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        has_unsigned_long(Interpreter::double_of(sandbox, a0) / Interpreter::double_of(sandbox, a1))
+    );
+}
+
+void Interpreter::instruction_MODD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    Interpreter::write64_to(sandbox, 
+        a0,
+        has_unsigned_long(std::fmod(Interpreter::double_of(sandbox, a0), Interpreter::double_of(sandbox, a1)))
+    );
+}
+
+void Interpreter::instruction_CMPD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto a0 = instruction.get_first_argument();
+    auto a1 = instruction.get_second_argument();
+    f64 v0 = Interpreter::double_of(sandbox, a0);
+    f64 v1 = Interpreter::double_of(sandbox, a1);
+    sandbox.set_flag_zero(v0 == v1);
+    sandbox.set_flag_greater(v0 > v1);
+}
+
+void Interpreter::instruction_ITL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        has_unsigned_long(static_cast<i64>(has_int(Interpreter::value_of(sandbox, arg))))
+    );
+}
+
+void Interpreter::instruction_UTL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        static_cast<ui64>(Interpreter::value_of(sandbox, arg))
+    );
+}
+
+void Interpreter::instruction_LTI(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write_to(sandbox, 
+        arg,
+        low_of(Interpreter::value64_of(sandbox, arg))
+    );
+}
+
+void Interpreter::instruction_LTD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        has_unsigned_long(static_cast<f64>(has_long(Interpreter::value64_of(sandbox, arg))))
+    );
+}
+
+void Interpreter::instruction_DTL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        has_unsigned_long(static_cast<i64>(Interpreter::double_of(sandbox, arg)))
+    );
+}
+
+void Interpreter::instruction_ITD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        has_unsigned_long(static_cast<f64>(has_int(Interpreter::value_of(sandbox, arg))))
+    );
+}
+
+void Interpreter::instruction_DTI(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write_to(sandbox, 
+        arg,
+        has_unsigned(static_cast<int>(Interpreter::double_of(sandbox, arg)))
+    );
+}
+
+void Interpreter::instruction_FTD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write64_to(sandbox, 
+        arg,
+        has_unsigned_long(static_cast<f64>(has_float(Interpreter::value_of(sandbox, arg))))
+    );
+}
+
+void Interpreter::instruction_DTF(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    Interpreter::write_to(sandbox, 
+        arg,
+        has_unsigned(static_cast<float>(Interpreter::double_of(sandbox, arg)))
+    );
+}
+
+void Interpreter::instruction_DBGL(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    std::cout << has_long(Interpreter::value64_of(sandbox, arg));
+}
+
+void Interpreter::instruction_DBGLU(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    std::cout << Interpreter::value64_of(sandbox, arg);
+}
+
+void Interpreter::instruction_DBGD(SandBox& sandbox, CachedInstruction const& instruction) {
+    auto arg = instruction.get_complete_argument();
+    std::cout << Interpreter::double_of(sandbox, arg);
+}
+
 }}
\ No newline at end of file
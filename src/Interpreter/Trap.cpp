@@ -0,0 +1,41 @@
+#include <vcrate/Interpreter/Trap.hpp>
+
+#include <vcrate/Interpreter/Counters.hpp>
+
+namespace vcrate { namespace interpreter {
+
+char const* to_string(TrapCode code) {
+    switch(code) {
+        case TrapCode::None:                return "none";
+        case TrapCode::UnknownOperation:    return "unknown operation";
+        case TrapCode::InvalidWrite:        return "write to a value";
+        case TrapCode::NoAddress:           return "argument without an address";
+        case TrapCode::InvalidRegisterPair: return "invalid register pair";
+        case TrapCode::DivisionByZero:      return "division by zero";
+        case TrapCode::WriteToCode:         return "write to the code";
+        case TrapCode::InvalidPc:           return "pc outside of the code";
+        case TrapCode::Breakpoint:          return "breakpoint";
+        default:                            return "unknown trap";
+    }
+}
+
+void handle_trap(SandBox& sandbox, Counters& counters, ui32 pc) {
+    // Left pending for VerifiedInterpreter::run_until_breakpoint
+    if (pending_trap == TrapCode::Breakpoint)
+        return;
+
+    counters.trap = { pending_trap, pc };
+    ++counters.traps;
+    pending_trap = TrapCode::None;
+
+    // Returning from the handler would land on the invalid pc again
+    if (!counters.trap_handler || counters.trap.code == TrapCode::InvalidPc)
+        return sandbox.halt();
+
+    sandbox.push_32(sandbox.get_pc());
+    sandbox.push_32(static_cast<ui32>(counters.trap.code));
+    sandbox.set_pc(*counters.trap_handler);
+    counters.on_stack(sandbox.get_sp());
+}
+
+}}
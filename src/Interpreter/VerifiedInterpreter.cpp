@@ -0,0 +1,326 @@
+#include <vcrate/Interpreter/VerifiedInterpreter.hpp>
+
+#include <vcrate/Interpreter/Interpreter.hpp>
+
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <iostream>
+
+namespace vcrate { namespace interpreter {
+
+using program::DecodedInstruction;
+using program::Operand;
+using program::OperandKind;
+
+namespace {
+
+inline f32 float_of(ui32 u) {
+    f32 f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+inline ui32 bits_of(f32 f) {
+    ui32 u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline i32 int_of(ui32 u) {
+    return static_cast<i32>(u);
+}
+
+inline ui32 value_of(SandBox& sandbox, Operand const& arg) {
+    switch(arg.kind) {
+        case OperandKind::Register:     return sandbox.get_register(arg.reg);
+        case OperandKind::Value:        return arg.value;
+        case OperandKind::Address:      return sandbox.get_memory_at(arg.value);
+        case OperandKind::Deferred:     return sandbox.get_memory_at(sandbox.get_register(arg.reg));
+        case OperandKind::Displacement: return sandbox.get_memory_at(sandbox.get_register(arg.reg) + arg.value);
+        default:                        return 0;
+    }
+}
+
+inline ui32 address_of(SandBox& sandbox, Operand const& arg) {
+    switch(arg.kind) {
+        case OperandKind::Address:      return arg.value;
+        case OperandKind::Deferred:     return sandbox.get_register(arg.reg);
+        case OperandKind::Displacement: return sandbox.get_register(arg.reg) + arg.value;
+        default:                        return 0;
+    }
+}
+
+inline void write_memory(program::Program const& program, SandBox& sandbox, ui32 address, ui32 value) {
+    // The decoded instructions would silently go stale
+    if (address < program.get_code_size())
+        return raise_trap(TrapCode::WriteToCode);
+    sandbox.set_memory_at(address, value);
+}
+
+// 1 instead of 0, the division goes on but its result isn't written once the trap is raised
+template<typename T>
+inline T divisor_of(T value) {
+    if (value == 0) {
+        raise_trap(TrapCode::DivisionByZero);
+        return 1;
+    }
+    return value;
+}
+
+// Wraps like the other operations: the lowest value divided by -1 is itself, where the host would fault
+template<typename T>
+inline T quotient_of(T dividend, T divisor) {
+    divisor = divisor_of(divisor);
+    if (divisor == -1 && dividend == std::numeric_limits<T>::min())
+        return dividend;
+    return dividend / divisor;
+}
+
+// The Interpreter runs wide operations without knowing the code is decoded, their two words are checked here
+inline bool writes_to_code(program::Program const& program, SandBox& sandbox, DecodedInstruction const& d) {
+    auto access = program::access_of(d, 0);
+    if ((access != program::Access::Write && access != program::Access::ReadWrite)
+     || d.args[0].kind == OperandKind::Register || d.args[0].kind == OperandKind::Value)
+        return false;
+    ui32 address = address_of(sandbox, d.args[0]);
+    return address < program.get_code_size() || address + 4 < program.get_code_size();
+}
+
+inline void write_to(program::Program const& program, SandBox& sandbox, Operand const& arg, ui32 value) {
+    // A faulting instruction leaves its destination as it was, for a handler returning to the next one
+    if (pending_trap != TrapCode::None)
+        return;
+    if (arg.kind == OperandKind::Register)
+        sandbox.set_register(arg.reg, value);
+    else
+        write_memory(program, sandbox, address_of(sandbox, arg), value);
+}
+
+inline bool is_relative(Operand const& arg) {
+    return arg.kind == OperandKind::Value || arg.kind == OperandKind::Address;
+}
+
+inline void jump(SandBox& sandbox, DecodedInstruction const& d) {
+    auto pc = value_of(sandbox, d.args[0]);
+    if (is_relative(d.args[0]))
+        pc += d.pc;
+    sandbox.set_pc(pc);
+}
+
+inline bool is(DecodedInstruction const& d, bytecode::Operations ope) {
+    return !d.wide && d.op == static_cast<ui8>(ope);
+}
+
+inline void enter(SandBox& sandbox, Counters& counters) {
+    sandbox.push_32(sandbox.get_bp());
+    sandbox.set_bp(sandbox.get_sp());
+    counters.on_stack(sandbox.get_sp());
+}
+
+inline void leave(SandBox& sandbox) {
+    sandbox.set_sp(sandbox.get_bp());
+    sandbox.set_bp(sandbox.pop_32());
+}
+
+inline void ret(SandBox& sandbox) {
+    sandbox.set_pc(sandbox.pop_32());
+}
+
+// With `fuse`, a call to an ETR and a LVE followed by a RET run as one step, counted as two instructions
+inline void execute(program::Program const& program, DecodedInstruction const& d, SandBox& sandbox, Counters& counters, bool fuse) {
+    if (d.wide) {
+        if (!writes_to_code(program, sandbox, d))
+            return Interpreter::run_next_instruction(sandbox, counters);
+        ++counters.instructions;
+        sandbox.set_pc(d.pc + d.size);
+        return raise_trap(TrapCode::WriteToCode);
+    }
+
+    ++counters.instructions;
+    sandbox.set_pc(d.pc + d.size);
+
+    auto const& a0 = d.args[0];
+    auto const& a1 = d.args[1];
+    auto read = [&sandbox] (Operand const& arg) { return value_of(sandbox, arg); };
+    auto write = [&program, &sandbox] (Operand const& arg, ui32 value) { write_to(program, sandbox, arg, value); };
+
+    using Operations = bytecode::Operations;
+    switch(static_cast<Operations>(d.op)) {
+        case Operations::ADD:   return write(a0, read(a0) + read(a1));
+        case Operations::ADDF:  return write(a0, bits_of(float_of(read(a0)) + float_of(read(a1))));
+        case Operations::SUB:   return write(a0, read(a0) - read(a1));
+        case Operations::SUBF:  return write(a0, bits_of(float_of(read(a0)) - float_of(read(a1))));
+        case Operations::MOD:   return write(a0, read(a0) % divisor_of(read(a1)));
+        case Operations::MODF:  return write(a0, bits_of(std::fmod(float_of(read(a0)), float_of(read(a1)))));
+        case Operations::MUL:   return write(a0, static_cast<ui32>(int_of(read(a0)) * int_of(read(a1))));
+        case Operations::MULU:  return write(a0, read(a0) * read(a1));
+        case Operations::MULF:  return write(a0, bits_of(float_of(read(a0)) * float_of(read(a1))));
+        case Operations::DIV:   return write(a0, static_cast<ui32>(quotient_of(int_of(read(a0)), int_of(read(a1)))));
+        case Operations::DIVU:  return write(a0, read(a0) / divisor_of(read(a1)));
+        case Operations::DIVF:  return write(a0, bits_of(float_of(read(a0)) / float_of(read(a1))));
+        case Operations::MOV:   return write(a0, read(a1));
+        case Operations::LEA:   return write(a0, address_of(sandbox, a1));
+        case Operations::POP:   return write(a0, sandbox.pop_32());
+        case Operations::PUSH:
+            sandbox.push_32(read(a0));
+            return counters.on_stack(sandbox.get_sp());
+        case Operations::JMP:   return jump(sandbox, d);
+        case Operations::JMPE:
+            if (sandbox.get_flag_zero())
+                jump(sandbox, d);
+            return;
+        case Operations::JMPNE:
+            if (!sandbox.get_flag_zero())
+                jump(sandbox, d);
+            return;
+        case Operations::JMPG:
+            if (sandbox.get_flag_greater())
+                jump(sandbox, d);
+            return;
+        case Operations::JMPGE:
+            if (sandbox.get_flag_greater() || sandbox.get_flag_zero())
+                jump(sandbox, d);
+            return;
+        case Operations::AND:   return write(a0, read(a0) & read(a1));
+        case Operations::OR:    return write(a0, read(a0) | read(a1));
+        case Operations::XOR:   return write(a0, read(a0) ^ read(a1));
+        case Operations::NOT:   return write(a0, ~read(a0));
+        case Operations::SHL:   return write(a0, read(a0) << read(a1));
+        case Operations::RTL: {
+            ui32 v0 = read(a0);
+            ui32 v1 = read(a1) & 31;
+            return write(a0, (v0 << v1) | (v0 >> (32 - v1)));
+        }
+        case Operations::SHR:   return write(a0, read(a0) >> read(a1));
+        case Operations::RTR: {
+            ui32 v0 = read(a0);
+            ui32 v1 = read(a1) & 31;
+            return write(a0, (v0 >> v1) | (v0 << (32 - v1)));
+        }
+        case Operations::SWP: {
+            ui32 v0 = read(a0);
+            ui32 v1 = read(a1);
+            write(a0, v1);
+            return write(a1, v0);
+        }
+        case Operations::CMP: {
+            // Same comparison as Interpreter::instruction_CMP
+            ui32 v0 = int_of(read(a0));
+            ui32 v1 = int_of(read(a1));
+            sandbox.set_flag_zero(v0 == v1);
+            return sandbox.set_flag_greater(v0 > v1);
+        }
+        case Operations::CMPU: {
+            ui32 v0 = read(a0);
+            ui32 v1 = read(a1);
+            sandbox.set_flag_zero(v0 == v1);
+            return sandbox.set_flag_greater(v0 > v1);
+        }
+        case Operations::INC:   return write(a0, read(a0) + 1);
+        case Operations::INCF:  return write(a0, bits_of(float_of(read(a0)) + 1.f));
+        case Operations::DEC:   return write(a0, read(a0) - 1);
+        case Operations::DECF:  return write(a0, bits_of(float_of(read(a0)) - 1.f));
+        case Operations::NEW: {
+            auto size = read(a1);
+            auto address = sandbox.allocate(size);
+            counters.on_allocate(address, size);
+            return write(a0, address);
+        }
+        case Operations::DEL: {
+            auto address = read(a0);
+            sandbox.deallocate(address);
+            return counters.on_deallocate(address);
+        }
+        case Operations::CALL: {
+            auto pc = read(a0);
+            if (is_relative(a0))
+                pc += sandbox.get_pc();
+            sandbox.push_32(sandbox.get_pc());
+            sandbox.set_pc(pc);
+            ++counters.calls;
+            counters.on_stack(sandbox.get_sp());
+
+            // The prologue of the function runs with the call
+            auto target = program.at(pc);
+            if (fuse && target && is(*target, Operations::ETR)) {
+                ++counters.instructions;
+                enter(sandbox, counters);
+                sandbox.set_pc(pc + target->size);
+            }
+            return;
+        }
+        case Operations::RET:   return ret(sandbox);
+        case Operations::ETR:   return enter(sandbox, counters);
+        case Operations::LVE: {
+            leave(sandbox);
+
+            // And so does the return following the epilogue
+            auto following = program.at(d.pc + d.size);
+            if (fuse && following && is(*following, Operations::RET)) {
+                ++counters.instructions;
+                ret(sandbox);
+            }
+            return;
+        }
+        case Operations::HLT:   return sandbox.halt();
+        case Operations::OUT:
+            sandbox.output(static_cast<ui8>(read(a0)));
+            ++counters.output_bytes;
+            return;
+        case Operations::DBG:   std::cout << int_of(read(a0)); return;
+        case Operations::DBGU:  std::cout << read(a0); return;
+        case Operations::DBGF:  std::cout << float_of(read(a0)); return;
+        case Operations::ITU:   return write(a0, static_cast<ui32>(int_of(read(a0))));
+        case Operations::ITF:   return write(a0, bits_of(static_cast<f32>(int_of(read(a0)))));
+        case Operations::UTI:   return write(a0, static_cast<ui32>(static_cast<i32>(read(a0))));
+        case Operations::UTF:   return write(a0, bits_of(static_cast<f32>(read(a0))));
+        case Operations::FTI:   return write(a0, static_cast<ui32>(static_cast<i32>(float_of(read(a0)))));
+        case Operations::FTU:   return write(a0, static_cast<ui32>(float_of(read(a0))));
+        default:
+            // Not run, the debugger runs the instruction it replaced once it resumes
+            if (d.op == program::breakpoint_operation) {
+                --counters.instructions;
+                sandbox.set_pc(d.pc);
+                return raise_trap(TrapCode::Breakpoint);
+            }
+            // Unreachable on verified programs
+            return raise_trap(TrapCode::UnknownOperation);
+    }
+}
+
+// Runs the instruction at the pc, and handles the trap it may raise
+inline void step(program::Program const& program, SandBox& sandbox, Counters& counters, bool fuse) {
+    auto pc = sandbox.get_pc();
+    auto d = program.at(pc);
+    if (!d)
+        raise_trap(TrapCode::InvalidPc);
+    else
+        execute(program, *d, sandbox, counters, fuse);
+    if (pending_trap != TrapCode::None)
+        handle_trap(sandbox, counters, pc);
+}
+
+}
+
+void VerifiedInterpreter::run_next_instruction(program::Program const& program, SandBox& sandbox, Counters& counters) {
+    step(program, sandbox, counters, false);
+}
+
+void VerifiedInterpreter::run(program::Program const& program, SandBox& sandbox, Counters& counters) {
+    while(!sandbox.is_halted())
+        step(program, sandbox, counters, true);
+}
+
+bool VerifiedInterpreter::run_until_breakpoint(program::Program const& program, SandBox& sandbox, Counters& counters) {
+    while(!sandbox.is_halted()) {
+        step(program, sandbox, counters, true);
+        if (pending_trap == TrapCode::Breakpoint) {
+            pending_trap = TrapCode::None;
+            return true;
+        }
+    }
+    return false;
+}
+
+}}
@@ -0,0 +1,177 @@
+#include <vcrate/Interpreter/WideInstruction.hpp>
+
+#include <vcrate/bytecode/Operations.hpp>
+
+#include <stdexcept>
+
+namespace vcrate { namespace interpreter {
+
+namespace {
+
+constexpr ui32 operation_mask = 0xFF000000;
+constexpr ui32 operation_shift = 24;
+
+ui32 with_operation(ui32 main_instruction, ui32 ope) {
+    return (main_instruction & ~operation_mask) | (ope << operation_shift);
+}
+
+bytecode::Operations carrier_of(ui32 arg_count) {
+    return arg_count == 2 ? bytecode::Operations::MOV : bytecode::Operations::INC;
+}
+
+instruction::Instruction carrier_of(WideOperations ope, ui32 main_instruction, ui32 extra0, ui32 extra1) {
+    return instruction::Instruction(
+        with_operation(main_instruction, static_cast<ui32>(carrier_of(WideInstruction::arg_count_of(ope)))),
+        extra0,
+        extra1
+    );
+}
+
+instruction::Instruction carrier_of(WideOperations ope, instruction::Argument const& arg) {
+    if (WideInstruction::arg_count_of(ope) != 1)
+        throw std::runtime_error("Wrong arguments count for " + WideInstruction::name_of(ope));
+    return instruction::Instruction(carrier_of(1), arg);
+}
+
+instruction::Instruction carrier_of(WideOperations ope, instruction::Argument const& arg0, instruction::Argument const& arg1) {
+    if (WideInstruction::arg_count_of(ope) != 2)
+        throw std::runtime_error("Wrong arguments count for " + WideInstruction::name_of(ope));
+    return instruction::Instruction(carrier_of(2), arg0, arg1);
+}
+
+}
+
+bool WideInstruction::is_wide(ui32 main_instruction) {
+    ui32 ope = main_instruction >> operation_shift;
+    return ope >= first_operation && ope < first_operation + operation_count;
+}
+
+WideInstruction::WideInstruction(ui32 main_instruction, ui32 extra0, ui32 extra1)
+    : ope(static_cast<WideOperations>(main_instruction >> operation_shift))
+    , carrier(carrier_of(ope, main_instruction, extra0, extra1)) {
+    if (!is_wide(main_instruction))
+        throw std::runtime_error("Not a wide operation");
+}
+
+WideInstruction::WideInstruction(WideOperations ope, instruction::Argument const& arg)
+    : ope(ope)
+    , carrier(carrier_of(ope, arg)) {}
+
+WideInstruction::WideInstruction(WideOperations ope, instruction::Argument const& arg0, instruction::Argument const& arg1)
+    : ope(ope)
+    , carrier(carrier_of(ope, arg0, arg1)) {}
+
+WideOperations WideInstruction::get_operation() const {
+    return ope;
+}
+
+instruction::Argument WideInstruction::get_first_argument() const {
+    return carrier.get_first_argument();
+}
+
+instruction::Argument WideInstruction::get_second_argument() const {
+    return carrier.get_second_argument();
+}
+
+instruction::Argument WideInstruction::get_complete_argument() const {
+    return carrier.get_complete_argument();
+}
+
+ui32 WideInstruction::get_byte_size() const {
+    return carrier.get_byte_size();
+}
+
+ui32 WideInstruction::get_main_instruction() const {
+    return with_operation(carrier.get_main_instruction(), static_cast<ui32>(ope));
+}
+
+ui32 WideInstruction::get_first_extra() const {
+    return carrier.get_first_extra();
+}
+
+ui32 WideInstruction::get_second_extra() const {
+    return carrier.get_second_extra();
+}
+
+std::string WideInstruction::to_string() const {
+    if (arg_count_of(ope) == 2)
+        return name_of(ope) + " " + argument_to_string(get_first_argument()) + ", " + argument_to_string(get_second_argument());
+    return name_of(ope) + " " + argument_to_string(get_complete_argument());
+}
+
+std::string WideInstruction::name_of(WideOperations ope) {
+    switch(ope) {
+        case WideOperations::ADDL:  return "ADDL";
+        case WideOperations::SUBL:  return "SUBL";
+        case WideOperations::MULL:  return "MULL";
+        case WideOperations::DIVL:  return "DIVL";
+        case WideOperations::DIVLU: return "DIVLU";
+        case WideOperations::MODL:  return "MODL";
+        case WideOperations::SHLL:  return "SHLL";
+        case WideOperations::SHRL:  return "SHRL";
+        case WideOperations::CMPL:  return "CMPL";
+        case WideOperations::CMPLU: return "CMPLU";
+        case WideOperations::MOVL:  return "MOVL";
+        case WideOperations::INCL:  return "INCL";
+        case WideOperations::DECL:  return "DECL";
+        case WideOperations::ADDD:  return "ADDD";
+        case WideOperations::SUBD:  return "SUBD";
+        case WideOperations::MULD:  return "MULD";
+        case WideOperations::DIVD:  return "DIVD";
+        case WideOperations::MODD:  return "MODD";
+        case WideOperations::CMPD:  return "CMPD";
+        case WideOperations::ITL:   return "ITL";
+        case WideOperations::UTL:   return "UTL";
+        case WideOperations::LTI:   return "LTI";
+        case WideOperations::LTD:   return "LTD";
+        case WideOperations::DTL:   return "DTL";
+        case WideOperations::ITD:   return "ITD";
+        case WideOperations::DTI:   return "DTI";
+        case WideOperations::FTD:   return "FTD";
+        case WideOperations::DTF:   return "DTF";
+        case WideOperations::DBGL:  return "DBGL";
+        case WideOperations::DBGLU: return "DBGLU";
+        case WideOperations::DBGD:  return "DBGD";
+        default:
+            throw std::runtime_error("Operations Unknown");
+    }
+}
+
+ui32 WideInstruction::arg_count_of(WideOperations ope) {
+    switch(ope) {
+        case WideOperations::ADDL:
+        case WideOperations::SUBL:
+        case WideOperations::MULL:
+        case WideOperations::DIVL:
+        case WideOperations::DIVLU:
+        case WideOperations::MODL:
+        case WideOperations::SHLL:
+        case WideOperations::SHRL:
+        case WideOperations::CMPL:
+        case WideOperations::CMPLU:
+        case WideOperations::MOVL:
+        case WideOperations::ADDD:
+        case WideOperations::SUBD:
+        case WideOperations::MULD:
+        case WideOperations::DIVD:
+        case WideOperations::MODD:
+        case WideOperations::CMPD:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+ui32 instruction_byte_size(ui32 main_instruction, ui32 extra0, ui32 extra1) {
+    if (WideInstruction::is_wide(main_instruction))
+        return WideInstruction(main_instruction, extra0, extra1).get_byte_size();
+    return instruction::Instruction(main_instruction, extra0, extra1).get_byte_size();
+}
+
+std::string instruction_to_string(ui32 main_instruction, ui32 extra0, ui32 extra1) {
+    if (WideInstruction::is_wide(main_instruction))
+        return WideInstruction(main_instruction, extra0, extra1).to_string();
+    return instruction::Instruction(main_instruction, extra0, extra1).to_string();
+}
+
+}}
@@ -0,0 +1,565 @@
+#include <vcrate/Optimizer/Optimizer.hpp>
+
+#include <vcrate/Program/Program.hpp>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdexcept>
+
+namespace vcrate { namespace optimizer {
+
+using program::Access;
+using program::DecodedInstruction;
+using program::Operand;
+using program::OperandKind;
+using Operations = bytecode::Operations;
+
+void Statistics::print(std::ostream& os) const {
+    os << "Constants folded       : " << folded << '\n';
+    os << "Dead instructions      : " << dead << '\n';
+    os << "Jumps threaded         : " << threaded << '\n';
+    os << "Redundant moves        : " << moves << '\n';
+    os << "Strength reductions    : " << reduced << '\n';
+    os << "Code size              : " << code_bytes_before << " -> " << code_bytes_after << " bytes\n";
+}
+
+namespace {
+
+constexpr ui32 none = ~0u;
+// Registers A to L hold values, the others are PC, SP and the like
+constexpr ui32 tracked_registers = 12;
+
+struct Item {
+    DecodedInstruction d;
+    // Index of the item a static jump or call lands on, none otherwise
+    ui32 target = none;
+    // Entry point, symbol or jump table entry, it can be reached from outside of the code
+    bool pinned = false;
+    // Addresses in the original code resolving to this item
+    std::vector<ui32> origins;
+    bool removed = false;
+};
+
+using Known = std::array<std::optional<ui32>, tracked_registers>;
+
+bool is(Item const& i, Operations ope) {
+    return !i.d.wide && static_cast<Operations>(i.d.op) == ope;
+}
+
+bool is_register(Operand const& o, ui32 id) {
+    return o.kind == OperandKind::Register && o.reg == id;
+}
+
+bool is_value(Operand const& o) {
+    return o.kind == OperandKind::Value;
+}
+
+Operand value(ui32 v) {
+    return Operand { OperandKind::Value, 0, v };
+}
+
+DecodedInstruction make(Operations ope, Operand const& a0, Operand const& a1 = {}) {
+    DecodedInstruction d;
+    d.op = static_cast<ui8>(ope);
+    d.valid = true;
+    d.args[0] = a0;
+    d.args[1] = a1;
+    d.size = program::encode(d).size() * sizeof(ui32);
+    return d;
+}
+
+bool is_unconditional_jump(Item const& i) {
+    return is(i, Operations::JMP);
+}
+
+bool falls_through(Item const& i) {
+    return !is_unconditional_jump(i) && !program::is_return(i.d) && !program::is_halt(i.d)
+        && !program::writes_register(i.d, instruction::Register::PC.id);
+}
+
+bool ends_block(Item const& i) {
+    return program::is_jump(i.d) || program::is_call(i.d) || !falls_through(i);
+}
+
+bool reads_register(Item const& i, ui32 id) {
+    for(ui32 a = 0; a < program::arg_count_of(i.d); ++a) {
+        auto const& o = i.d.args[a];
+        auto access = program::access_of(i.d, a);
+        if ((o.kind == OperandKind::Deferred || o.kind == OperandKind::Displacement) && o.reg == id)
+            return true;
+        if (o.kind == OperandKind::Register && (access == Access::Read || access == Access::ReadWrite)
+            && (o.reg == id || (i.d.wide && o.reg + 1u == id)))
+            return true;
+    }
+    return false;
+}
+
+// Registers written through a Register argument, a call may write any of them
+std::vector<ui32> written_registers(Item const& i) {
+    if (program::is_call(i.d)) {
+        std::vector<ui32> all(tracked_registers);
+        for(ui32 r = 0; r < tracked_registers; ++r)
+            all[r] = r;
+        return all;
+    }
+
+    std::vector<ui32> written;
+    for(ui32 a = 0; a < program::arg_count_of(i.d); ++a) {
+        auto const& o = i.d.args[a];
+        auto access = program::access_of(i.d, a);
+        if (o.kind == OperandKind::Register && (access == Access::Write || access == Access::ReadWrite)) {
+            written.push_back(o.reg);
+            if (i.d.wide)
+                written.push_back(o.reg + 1);
+        }
+    }
+    return written;
+}
+
+std::optional<ui32> known_value(Known const& known, Operand const& o) {
+    if (is_value(o))
+        return o.value;
+    if (o.kind == OperandKind::Register && o.reg < tracked_registers)
+        return known[o.reg];
+    return {};
+}
+
+// What the registers hold after the item
+void track(Known& known, Item const& i) {
+    if (is(i, Operations::MOV) && i.d.args[0].kind == OperandKind::Register && i.d.args[0].reg < tracked_registers) {
+        known[i.d.args[0].reg] = known_value(known, i.d.args[1]);
+        return;
+    }
+    for(auto r : written_registers(i))
+        if (r < tracked_registers)
+            known[r].reset();
+}
+
+std::vector<bool> leaders_of(std::vector<Item> const& items) {
+    std::vector<bool> leaders(items.size(), false);
+    if (!items.empty())
+        leaders[0] = true;
+    for(ui32 i = 0; i < items.size(); ++i) {
+        if (items[i].pinned)
+            leaders[i] = true;
+        if (items[i].target < items.size())
+            leaders[items[i].target] = true;
+        if (ends_block(items[i]) && i + 1 < items.size())
+            leaders[i + 1] = true;
+    }
+    return leaders;
+}
+
+// Drops the removed items, whatever pointed to one of them now points to the next item kept
+void compact(std::vector<Item>& items) {
+    std::vector<ui32> new_index(items.size() + 1);
+    ui32 kept = 0;
+    for(ui32 i = 0; i < items.size(); ++i) {
+        new_index[i] = kept;
+        if (!items[i].removed)
+            ++kept;
+    }
+    new_index[items.size()] = kept;
+
+    std::vector<Item> result;
+    std::vector<ui32> origins;
+    bool pinned = false;
+    for(auto& item : items) {
+        if (item.removed) {
+            origins.insert(origins.end(), item.origins.begin(), item.origins.end());
+            pinned = pinned || item.pinned;
+            continue;
+        }
+        item.origins.insert(item.origins.end(), origins.begin(), origins.end());
+        item.pinned = item.pinned || pinned;
+        origins.clear();
+        pinned = false;
+        result.push_back(std::move(item));
+    }
+
+    for(auto& item : result)
+        if (item.target != none)
+            item.target = new_index[item.target];
+
+    // Whatever pointed past the last item stays at the end of the code
+    if (!origins.empty() || pinned) {
+        Item end;
+        end.d = make(Operations::HLT, {});
+        end.origins = origins;
+        end.pinned = true;
+        result.push_back(end);
+    }
+
+    items = std::move(result);
+}
+
+std::optional<ui32> fold(Operations ope, ui32 v0, ui32 v1) {
+    switch(ope) {
+        case Operations::ADD:   return v0 + v1;
+        case Operations::SUB:   return v0 - v1;
+        case Operations::MULU:  return v0 * v1;
+        case Operations::MUL:   return v0 * v1;
+        case Operations::AND:   return v0 & v1;
+        case Operations::OR:    return v0 | v1;
+        case Operations::XOR:   return v0 ^ v1;
+        case Operations::SHL:   if (v1 < 32) return v0 << v1; return {};
+        case Operations::SHR:   if (v1 < 32) return v0 >> v1; return {};
+        case Operations::DIVU:  if (v1 != 0) return v0 / v1; return {};
+        case Operations::MOD:   if (v1 != 0) return v0 % v1; return {};
+        case Operations::NOT:   return ~v0;
+        case Operations::INC:   return v0 + 1;
+        case Operations::DEC:   return v0 - 1;
+        default:                return {};
+    }
+}
+
+bool is_identity(Item const& i) {
+    if (i.d.wide || i.d.args[0].kind != OperandKind::Register || !is_value(i.d.args[1]))
+        return false;
+    auto v = i.d.args[1].value;
+    switch(static_cast<Operations>(i.d.op)) {
+        case Operations::ADD: case Operations::SUB: case Operations::OR: case Operations::XOR:
+        case Operations::SHL: case Operations::SHR:
+            return v == 0;
+        case Operations::MUL: case Operations::MULU: case Operations::DIVU:
+            return v == 1;
+        default:
+            return false;
+    }
+}
+
+bool fold_constants(std::vector<Item>& items, bool may_grow, Statistics& statistics) {
+    bool changed = false;
+    auto leaders = leaders_of(items);
+    Known known;
+
+    for(ui32 i = 0; i < items.size(); ++i) {
+        if (leaders[i])
+            known = Known{};
+        auto& item = items[i];
+
+        if (is_identity(item)) {
+            item.removed = true;
+            ++statistics.folded;
+            changed = true;
+            continue;
+        }
+
+        auto const& a0 = item.d.args[0];
+        if (!item.d.wide && !is(item, Operations::MOV) && a0.kind == OperandKind::Register && a0.reg < tracked_registers) {
+            auto ope = static_cast<Operations>(item.d.op);
+            auto v0 = known[a0.reg];
+            auto count = program::arg_count_of(item.d);
+            auto v1 = count == 2 ? known_value(known, item.d.args[1]) : std::optional<ui32>(0);
+            std::optional<ui32> result;
+            if (v0 && v1 && count > 0 && program::access_of(item.d, 0) == Access::ReadWrite)
+                result = fold(ope, *v0, *v1);
+
+            if (result) {
+                auto folded = make(Operations::MOV, a0, value(*result));
+                if (may_grow || folded.size <= item.d.size) {
+                    folded.pc = item.d.pc;
+                    item.d = folded;
+                    ++statistics.folded;
+                    changed = true;
+                }
+            }
+        }
+
+        track(known, item);
+    }
+
+    compact(items);
+    return changed;
+}
+
+std::optional<ui32> log2_of(ui32 v) {
+    if (v < 2 || (v & (v - 1)) != 0)
+        return {};
+    ui32 n = 0;
+    while((v >>= 1) != 0)
+        ++n;
+    return n;
+}
+
+bool reduce_strength(std::vector<Item>& items, bool may_grow, Statistics& statistics) {
+    bool changed = false;
+    for(auto& item : items) {
+        if (item.d.wide || !is_value(item.d.args[1]))
+            continue;
+        auto n = log2_of(item.d.args[1].value);
+        if (!n)
+            continue;
+
+        // MOD and DIVU are unsigned in the Interpreter, DIV rounds toward zero so it can't become a shift
+        std::optional<DecodedInstruction> reduced;
+        switch(static_cast<Operations>(item.d.op)) {
+            case Operations::MUL:
+            case Operations::MULU:  reduced = make(Operations::SHL, item.d.args[0], value(*n)); break;
+            case Operations::DIVU:  reduced = make(Operations::SHR, item.d.args[0], value(*n)); break;
+            case Operations::MOD:   reduced = make(Operations::AND, item.d.args[0], value(item.d.args[1].value - 1)); break;
+            default: break;
+        }
+        if (reduced && (may_grow || reduced->size <= item.d.size)) {
+            reduced->pc = item.d.pc;
+            item.d = *reduced;
+            ++statistics.reduced;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool remove_redundant_moves(std::vector<Item>& items, Statistics& statistics) {
+    bool changed = false;
+    auto leaders = leaders_of(items);
+    Known known;
+
+    for(ui32 i = 0; i < items.size(); ++i) {
+        if (leaders[i])
+            known = Known{};
+        auto& item = items[i];
+
+        if (is(item, Operations::MOV) && item.d.args[0].kind == OperandKind::Register) {
+            auto r = item.d.args[0].reg;
+            bool redundant = is_register(item.d.args[1], r);
+            if (!redundant && r < tracked_registers && known[r] && known_value(known, item.d.args[1]) == known[r])
+                redundant = true;
+
+            // Overwritten before being read in the same block
+            if (!redundant && r < tracked_registers && (is_value(item.d.args[1]) || item.d.args[1].kind == OperandKind::Register)) {
+                for(ui32 j = i + 1; j < items.size() && !leaders[j]; ++j) {
+                    if (reads_register(items[j], r))
+                        break;
+                    auto written = written_registers(items[j]);
+                    if (std::find(written.begin(), written.end(), r) != written.end()) {
+                        redundant = !program::is_call(items[j].d) && program::access_of(items[j].d, 0) == Access::Write;
+                        break;
+                    }
+                    if (ends_block(items[j]))
+                        break;
+                }
+            }
+
+            if (redundant) {
+                item.removed = true;
+                ++statistics.moves;
+                changed = true;
+                continue;
+            }
+        }
+
+        track(known, item);
+    }
+
+    compact(items);
+    return changed;
+}
+
+bool thread_jumps(std::vector<Item>& items, Statistics& statistics) {
+    bool changed = false;
+    for(ui32 i = 0; i < items.size(); ++i) {
+        auto& item = items[i];
+        if (item.target == none)
+            continue;
+
+        auto target = item.target;
+        for(ui32 hops = 0; hops < 16 && target < items.size() && is_unconditional_jump(items[target])
+            && items[target].target != none && items[target].target != target; ++hops)
+            target = items[target].target;
+        if (target != item.target) {
+            item.target = target;
+            ++statistics.threaded;
+            changed = true;
+        }
+
+        if (program::is_jump(item.d) && item.target == i + 1) {
+            item.removed = true;
+            ++statistics.threaded;
+            changed = true;
+        }
+    }
+
+    compact(items);
+    return changed;
+}
+
+bool eliminate_dead_code(std::vector<Item>& items, Statistics& statistics) {
+    std::vector<bool> reachable(items.size(), false);
+    std::vector<ui32> pending;
+    auto visit = [&] (ui32 i) {
+        if (i < items.size() && !reachable[i]) {
+            reachable[i] = true;
+            pending.push_back(i);
+        }
+    };
+
+    for(ui32 i = 0; i < items.size(); ++i)
+        if (items[i].pinned)
+            visit(i);
+
+    while(!pending.empty()) {
+        auto i = pending.back();
+        pending.pop_back();
+        if (falls_through(items[i]))
+            visit(i + 1);
+        if (items[i].target != none)
+            visit(items[i].target);
+    }
+
+    bool changed = false;
+    for(ui32 i = 0; i < items.size(); ++i) {
+        if (!reachable[i]) {
+            items[i].removed = true;
+            ++statistics.dead;
+            changed = true;
+        }
+    }
+
+    compact(items);
+    return changed;
+}
+
+std::vector<Item> lift(vcx::Executable const& exe, program::Program const& program) {
+    auto const& instructions = program.get_instructions();
+    std::vector<Item> items;
+
+    auto is_pinned = [&exe] (ui32 pc) {
+        if (pc == exe.entry_point)
+            return true;
+        if (std::find(exe.jmp_table.begin(), exe.jmp_table.end(), pc) != exe.jmp_table.end())
+            return true;
+        return std::any_of(exe.symbols.begin(), exe.symbols.end(), [pc] (auto const& s) { return s.second == pc; });
+    };
+
+    for(auto const& d : instructions) {
+        if (!d.valid)
+            throw std::runtime_error("Unknown operation or truncated instruction at " + std::to_string(d.pc));
+
+        for(ui32 a = 0; a < program::arg_count_of(d); ++a) {
+            auto const& o = d.args[a];
+            bool uses_pc = o.reg == instruction::Register::PC.id
+                && (o.kind == OperandKind::Deferred || o.kind == OperandKind::Displacement
+                    || (o.kind == OperandKind::Register && program::access_of(d, a) != Access::Write));
+            if (uses_pc)
+                throw std::runtime_error("The instruction at " + std::to_string(d.pc) + " depends on the program counter");
+            if (o.kind == OperandKind::Address && o.value < program.get_code_size())
+                throw std::runtime_error("The instruction at " + std::to_string(d.pc) + " uses an address inside the code");
+        }
+
+        // The target may be an address of the code held as a value, which wouldn't move with it
+        if ((program::is_jump(d) || program::is_call(d)) && !program::has_static_target(d))
+            throw std::runtime_error("The instruction at " + std::to_string(d.pc) + " jumps or calls through a register or memory");
+
+        Item item;
+        item.d = d;
+        item.pinned = is_pinned(d.pc);
+        item.origins.push_back(d.pc);
+        if (program::has_static_target(d)) {
+            item.target = program.index_of(program::static_target_of(d));
+            if (item.target == program::Program::invalid_index)
+                throw std::runtime_error("The instruction at " + std::to_string(d.pc) + " jumps inside an instruction");
+        }
+        items.push_back(item);
+    }
+
+    return items;
+}
+
+// Lays the items out, the relative offsets of jumps and calls can change their size so it goes until it's stable
+std::vector<ui32> lay_out(std::vector<Item>& items) {
+    std::vector<ui32> pcs(items.size() + 1, 0);
+    for(ui32 round = 0; round < 16; ++round) {
+        ui32 pc = 0;
+        for(ui32 i = 0; i < items.size(); ++i) {
+            pcs[i] = pc;
+            pc += items[i].d.size;
+        }
+        pcs[items.size()] = pc;
+
+        bool stable = true;
+        for(ui32 i = 0; i < items.size(); ++i) {
+            auto& d = items[i].d;
+            d.pc = pcs[i];
+            if (items[i].target == none)
+                continue;
+            ui32 from = program::is_call(d) ? pcs[i] + d.size : pcs[i];
+            d.args[0] = value(pcs[items[i].target] - from);
+            ui32 size = program::encode(d).size() * sizeof(ui32);
+            if (size != d.size) {
+                d.size = size;
+                stable = false;
+            }
+        }
+        if (stable)
+            return pcs;
+    }
+    throw std::runtime_error("The layout of the code doesn't settle");
+}
+
+}
+
+vcx::Executable optimize(vcx::Executable const& exe, Options const& options, Statistics& statistics) {
+    program::Program program(exe);
+    auto items = lift(exe, program);
+    statistics.code_bytes_before = exe.code.size() * sizeof(ui32);
+
+    // The data follows the code, so the code can't grow past its original size when there is some
+    // Instructions never get bigger than the ones they replace in that case, and neither do the offsets between them
+    bool may_grow = exe.data.empty();
+
+    for(ui32 round = 0; round < 8; ++round) {
+        bool changed = false;
+        if (options.reduce_strength)
+            changed = reduce_strength(items, may_grow, statistics) || changed;
+        if (options.fold_constants)
+            changed = fold_constants(items, may_grow, statistics) || changed;
+        if (options.remove_redundant_moves)
+            changed = remove_redundant_moves(items, statistics) || changed;
+        if (options.thread_jumps)
+            changed = thread_jumps(items, statistics) || changed;
+        if (options.eliminate_dead_code)
+            changed = eliminate_dead_code(items, statistics) || changed;
+        if (!changed)
+            break;
+    }
+
+    auto pcs = lay_out(items);
+
+    vcx::Executable result = exe;
+    result.code.clear();
+    for(auto const& item : items) {
+        auto words = program::encode(item.d);
+        result.code.insert(result.code.end(), words.begin(), words.end());
+    }
+
+    ui32 old_size = exe.code.size() * sizeof(ui32);
+    ui32 new_size = result.code.size() * sizeof(ui32);
+    auto move = [&] (ui32 pc) {
+        if (pc == old_size)
+            return new_size;
+        for(ui32 i = 0; i < items.size(); ++i)
+            if (std::find(items[i].origins.begin(), items[i].origins.end(), pc) != items[i].origins.end())
+                return pcs[i];
+        return pc;
+    };
+
+    result.entry_point = move(exe.entry_point);
+    for(auto& s : result.symbols)
+        s.second = move(s.second);
+    for(auto& pc : result.jmp_table)
+        pc = move(pc);
+
+    if (!exe.data.empty()) {
+        if (new_size > old_size)
+            throw std::runtime_error("The optimized code is bigger and would move the data");
+        auto halt = instruction::Instruction(Operations::HLT).get_main_instruction();
+        result.code.resize(exe.code.size(), halt);
+    }
+
+    statistics.code_bytes_after = result.code.size() * sizeof(ui32);
+    return result;
+}
+
+}}
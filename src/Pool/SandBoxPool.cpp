@@ -0,0 +1,78 @@
+#include <vcrate/Pool/SandBoxPool.hpp>
+
+#include <vcrate/Replay/Replay.hpp>
+
+namespace vcrate { namespace pool {
+
+namespace {
+
+SandBox loaded(vcx::Executable const& exe, ui32 memory_size) {
+    SandBox sandbox(memory_size);
+    sandbox.load_executable(exe);
+    return sandbox;
+}
+
+}
+
+SandBoxPool::Lease::Lease(SandBoxPool& pool, std::unique_ptr<SandBox> sandbox) : pool(&pool), sandbox(std::move(sandbox)) {}
+
+SandBoxPool::Lease::~Lease() {
+    // Moved from
+    if (sandbox)
+        pool->give_back(std::move(sandbox));
+}
+
+SandBoxPool::SandBoxPool(vcx::Executable const& exe, ui32 memory_size, ui32 capacity)
+: pristine(loaded(exe, memory_size)), capacity(capacity) {}
+
+SandBoxPool::Lease SandBoxPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            auto sandbox = std::move(idle.back());
+            idle.pop_back();
+            ++reused;
+            return Lease(*this, std::move(sandbox));
+        }
+        ++created;
+    }
+    return Lease(*this, std::make_unique<SandBox>(pristine));
+}
+
+void SandBoxPool::give_back(std::unique_ptr<SandBox> sandbox) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.size() >= capacity)
+            return;
+    }
+
+    // Outside of the lock, this is the expensive part
+    *sandbox = pristine;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < capacity)
+        idle.push_back(std::move(sandbox));
+}
+
+ui64 SandBoxPool::get_created() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return created;
+}
+
+ui64 SandBoxPool::get_reused() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reused;
+}
+
+SandBoxPools::SandBoxPools(ui32 memory_size, ui32 capacity) : memory_size(memory_size), capacity(capacity) {}
+
+SandBoxPool& SandBoxPools::of(vcx::Executable const& exe) {
+    auto hash = replay::hash_of(exe);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& pool = pools[hash];
+    if (!pool)
+        pool = std::make_unique<SandBoxPool>(exe, memory_size, capacity);
+    return *pool;
+}
+
+}}
@@ -0,0 +1,250 @@
+#include <vcrate/Profiler/Profiler.hpp>
+
+#include <vcrate/bytecode/Operations.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace vcrate { namespace profiler {
+
+using interpreter::WideInstruction;
+using interpreter::WideOperations;
+
+std::string to_string(OperationClass c) {
+    switch(c) {
+        case OperationClass::Integer:       return "integer";
+        case OperationClass::Float:         return "float";
+        case OperationClass::Wide:          return "wide";
+        case OperationClass::Logic:         return "logic";
+        case OperationClass::Memory:        return "memory";
+        case OperationClass::Jump:          return "jump";
+        case OperationClass::Call:          return "call";
+        case OperationClass::Conversion:    return "conversion";
+        case OperationClass::IO:            return "io";
+        default:                            return "unknown";
+    }
+}
+
+OperationClass class_of(ui32 operation) {
+    if (WideInstruction::is_wide(operation << 24)) {
+        switch(static_cast<WideOperations>(operation)) {
+            case WideOperations::ITL:
+            case WideOperations::UTL:
+            case WideOperations::LTI:
+            case WideOperations::LTD:
+            case WideOperations::DTL:
+            case WideOperations::ITD:
+            case WideOperations::DTI:
+            case WideOperations::FTD:
+            case WideOperations::DTF:
+                return OperationClass::Conversion;
+            case WideOperations::DBGL:
+            case WideOperations::DBGLU:
+            case WideOperations::DBGD:
+                return OperationClass::IO;
+            default:
+                return OperationClass::Wide;
+        }
+    }
+
+    using Operations = bytecode::Operations;
+    switch(static_cast<Operations>(operation)) {
+        case Operations::ADDF:
+        case Operations::SUBF:
+        case Operations::MODF:
+        case Operations::MULF:
+        case Operations::DIVF:
+        case Operations::INCF:
+        case Operations::DECF:
+            return OperationClass::Float;
+        case Operations::AND:
+        case Operations::OR:
+        case Operations::XOR:
+        case Operations::NOT:
+        case Operations::SHL:
+        case Operations::RTL:
+        case Operations::SHR:
+        case Operations::RTR:
+            return OperationClass::Logic;
+        case Operations::MOV:
+        case Operations::LEA:
+        case Operations::POP:
+        case Operations::PUSH:
+        case Operations::SWP:
+        case Operations::NEW:
+        case Operations::DEL:
+            return OperationClass::Memory;
+        case Operations::JMP:
+        case Operations::JMPE:
+        case Operations::JMPNE:
+        case Operations::JMPG:
+        case Operations::JMPGE:
+        case Operations::HLT:
+            return OperationClass::Jump;
+        case Operations::CALL:
+        case Operations::RET:
+        case Operations::ETR:
+        case Operations::LVE:
+            return OperationClass::Call;
+        case Operations::ITU:
+        case Operations::ITF:
+        case Operations::UTI:
+        case Operations::UTF:
+        case Operations::FTI:
+        case Operations::FTU:
+            return OperationClass::Conversion;
+        case Operations::OUT:
+        case Operations::DBG:
+        case Operations::DBGU:
+        case Operations::DBGF:
+            return OperationClass::IO;
+        default:
+            return OperationClass::Integer;
+    }
+}
+
+namespace {
+
+std::string operation_name(ui32 operation) {
+    if (WideInstruction::is_wide(operation << 24))
+        return WideInstruction::name_of(static_cast<WideOperations>(operation));
+    return bytecode::OpDefinition::get(static_cast<bytecode::Operations>(operation)).name;
+}
+
+std::string percent(ui64 n, ui64 total) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << (total ? 100. * n / total : 0.) << " %";
+    return ss.str();
+}
+
+}
+
+Profiler::Profiler(vcx::Executable const& exe, ui32 sample_period)
+    : exe(exe), symbols(exe), sample_period(std::max<ui32>(1, sample_period)), hits(exe.code.size(), 0), stack{ exe.entry_point } {}
+
+void Profiler::before(SandBox const& sandbox) {
+    auto pc = sandbox.get_pc();
+    current_operation = sandbox.get_memory_at(pc) >> 24;
+
+    ++instructions;
+    ++operations[current_operation];
+    if (pc / 4 < hits.size())
+        ++hits[pc / 4];
+    else
+        ++out_of_code;
+
+    if (instructions % sample_period == 0)
+        ++samples[stack];
+
+    current_start = clock::now();
+}
+
+void Profiler::after(SandBox const& sandbox) {
+    auto elapsed = clock::now() - current_start;
+    auto c = static_cast<ui32>(class_of(current_operation));
+    ++class_counts[c];
+    class_durations[c] += elapsed;
+
+    if (current_operation == static_cast<ui32>(bytecode::Operations::CALL)) {
+        ++call_edges[{ stack.back(), sandbox.get_pc() }];
+        stack.push_back(sandbox.get_pc());
+    } else if (current_operation == static_cast<ui32>(bytecode::Operations::RET) && stack.size() > 1) {
+        stack.pop_back();
+    }
+}
+
+std::string Profiler::function_name(ui32 address) const {
+    if (auto symbol = symbols.at(address))
+        return symbol->name;
+    return symbols.location_of(address);
+}
+
+void Profiler::report(std::ostream& os) const {
+    constexpr ui32 top = 20;
+
+    os << "# Profile #\n";
+    os << "Instructions : " << instructions << '\n';
+    if (out_of_code > 0)
+        os << "Outside of the code section : " << out_of_code << '\n';
+
+    {
+        std::vector<std::pair<ui64, ui32>> ops;
+        for(ui32 o = 0; o < operations.size(); ++o)
+            if (operations[o] > 0)
+                ops.emplace_back(operations[o], o);
+        std::sort(ops.rbegin(), ops.rend());
+
+        os << "\n## Operations ##\n";
+        for(auto const& p : ops)
+            os << std::left << std::setw(8) << operation_name(p.second)
+               << std::right << std::setw(14) << p.first << std::setw(10) << percent(p.first, instructions) << '\n';
+    }
+
+    {
+        os << "\n## Operation classes ##\n";
+        for(ui32 c = 0; c < class_counts.size(); ++c) {
+            if (class_counts[c] == 0)
+                continue;
+            auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(class_durations[c]).count();
+            os << std::left << std::setw(12) << to_string(static_cast<OperationClass>(c))
+               << std::right << std::setw(14) << class_counts[c] << std::setw(10) << percent(class_counts[c], instructions)
+               << std::setw(14) << nanos / 1'000'000. << " ms"
+               << std::setw(10) << static_cast<f64>(nanos) / class_counts[c] << " ns/instruction\n";
+        }
+    }
+
+    {
+        std::vector<std::pair<ui64, ui32>> pcs;
+        for(ui32 i = 0; i < hits.size(); ++i)
+            if (hits[i] > 0)
+                pcs.emplace_back(hits[i], i * 4);
+        std::sort(pcs.rbegin(), pcs.rend());
+
+        os << "\n## Hot spots ##\n";
+        for(ui32 i = 0; i < std::min<ui32>(top, pcs.size()); ++i) {
+            ui32 word = pcs[i].second / 4;
+            ui32 extra0 = word + 1 < exe.code.size() ? exe.code[word + 1] : 0;
+            ui32 extra1 = word + 2 < exe.code.size() ? exe.code[word + 2] : 0;
+            os << std::setw(10) << pcs[i].second << std::setw(14) << pcs[i].first << std::setw(10) << percent(pcs[i].first, instructions)
+               << "  " << std::left << std::setw(24) << symbols.location_of(pcs[i].second) << std::right
+               << interpreter::instruction_to_string(exe.code[word], extra0, extra1) << '\n';
+        }
+
+        std::map<std::string, ui64> functions;
+        for(auto const& p : pcs) {
+            auto symbol = symbols.enclosing(p.second);
+            functions[symbol ? symbol->name : "[unknown]"] += p.first;
+        }
+        std::vector<std::pair<ui64, std::string>> sorted;
+        for(auto const& p : functions)
+            sorted.emplace_back(p.second, p.first);
+        std::sort(sorted.rbegin(), sorted.rend());
+
+        os << "\n## Functions (self) ##\n";
+        for(auto const& p : sorted)
+            os << std::left << std::setw(24) << p.second << std::right << std::setw(14) << p.first << std::setw(10) << percent(p.first, instructions) << '\n';
+    }
+
+    {
+        os << "\n## Calls ##\n";
+        for(auto const& p : call_edges)
+            os << function_name(p.first.first) << " -> " << function_name(p.first.second) << " : " << p.second << '\n';
+    }
+}
+
+void Profiler::folded_stacks(std::ostream& os) const {
+    for(auto const& p : samples) {
+        bool first = true;
+        for(auto address : p.first) {
+            if (!first)
+                os << ';';
+            os << function_name(address);
+            first = false;
+        }
+        os << ' ' << p.second << '\n';
+    }
+}
+
+}}
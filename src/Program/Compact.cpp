@@ -0,0 +1,260 @@
+#include <vcrate/Program/Compact.hpp>
+
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/Program/Program.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace vcrate { namespace program {
+
+namespace {
+
+// Operations stop before it, see WideOperations
+constexpr ui8 raw_words = 0xFF;
+
+void put_byte(std::ostream& os, ui8 byte) {
+    os.put(static_cast<char>(byte));
+}
+
+void put_varint(std::ostream& os, ui32 value) {
+    while(value >= 0x80) {
+        put_byte(os, static_cast<ui8>(value) | 0x80);
+        value >>= 7;
+    }
+    put_byte(os, static_cast<ui8>(value));
+}
+
+// Small negative numbers stay small
+void put_signed(std::ostream& os, ui32 value) {
+    auto i = static_cast<i32>(value);
+    put_varint(os, (static_cast<ui32>(i) << 1) ^ static_cast<ui32>(i >> 31));
+}
+
+void put_word(std::ostream& os, ui32 word) {
+    for(ui32 b = 0; b < 4; ++b)
+        put_byte(os, static_cast<ui8>(word >> (8 * b)));
+}
+
+bool get_byte(std::istream& is, ui8& byte) {
+    auto c = is.get();
+    if (c == std::istream::traits_type::eof())
+        return false;
+    byte = static_cast<ui8>(c);
+    return true;
+}
+
+bool get_varint(std::istream& is, ui32& value) {
+    value = 0;
+    for(ui32 shift = 0; shift < 35; shift += 7) {
+        ui8 byte;
+        if (!get_byte(is, byte))
+            return false;
+        value |= static_cast<ui32>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool get_signed(std::istream& is, ui32& value) {
+    ui32 zigzag;
+    if (!get_varint(is, zigzag))
+        return false;
+    value = (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+    return true;
+}
+
+bool get_word(std::istream& is, ui32& word) {
+    word = 0;
+    for(ui32 b = 0; b < 4; ++b) {
+        ui8 byte;
+        if (!get_byte(is, byte))
+            return false;
+        word |= static_cast<ui32>(byte) << (8 * b);
+    }
+    return true;
+}
+
+bool has_register(OperandKind kind) {
+    return kind == OperandKind::Register || kind == OperandKind::Deferred || kind == OperandKind::Displacement;
+}
+
+void put_operand(std::ostream& os, Operand const& o) {
+    put_byte(os, static_cast<ui8>(o.kind) | (has_register(o.kind) ? o.reg << 3 : 0));
+    if (o.kind == OperandKind::Value || o.kind == OperandKind::Displacement)
+        put_signed(os, o.value);
+    else if (o.kind == OperandKind::Address)
+        put_varint(os, o.value);
+}
+
+bool get_operand(std::istream& is, Operand& o) {
+    ui8 byte;
+    if (!get_byte(is, byte))
+        return false;
+    o.kind = static_cast<OperandKind>(byte & 0x07);
+    o.reg = byte >> 3;
+    if (o.kind == OperandKind::Value || o.kind == OperandKind::Displacement)
+        return get_signed(is, o.value);
+    if (o.kind == OperandKind::Address)
+        return get_varint(is, o.value);
+    return o.kind == OperandKind::Register || o.kind == OperandKind::Deferred;
+}
+
+void flush_raw(std::ostream& os, std::vector<ui32>& raw) {
+    if (raw.empty())
+        return;
+    put_byte(os, raw_words);
+    put_varint(os, raw.size());
+    for(auto w : raw)
+        put_word(os, w);
+    raw.clear();
+}
+
+bool is_operation(ui8 op) {
+    using interpreter::WideInstruction;
+    if (op >= WideInstruction::first_operation)
+        return op < WideInstruction::first_operation + WideInstruction::operation_count;
+    return is_known_operation(static_cast<bytecode::Operations>(op));
+}
+
+}
+
+void write_compact(std::ostream& os, vcx::Executable const& exe) {
+    os.write(compact_magic, sizeof(compact_magic));
+    put_byte(os, compact_version);
+
+    put_varint(os, exe.entry_point);
+    put_varint(os, exe.symbols.size());
+    for(auto const& s : exe.symbols) {
+        put_varint(os, s.first.size());
+        os.write(s.first.data(), s.first.size());
+        put_varint(os, s.second);
+    }
+    put_varint(os, exe.jmp_table.size());
+    for(auto pc : exe.jmp_table)
+        put_varint(os, pc);
+    put_varint(os, exe.data.size());
+    for(auto w : exe.data)
+        put_word(os, w);
+
+    put_varint(os, exe.code.size());
+    Program program(exe);
+    std::vector<ui32> raw;
+    for(auto const& d : program.get_instructions()) {
+        ui32 first = d.pc / 4;
+        ui32 last = std::min<ui32>(first + d.size / 4, exe.code.size());
+
+        // Non canonical encodings, as an immediate in an extra word that would fit in the instruction, are kept as is
+        bool canonical = false;
+        if (d.valid) {
+            auto words = encode(d);
+            canonical = words.size() == last - first && std::equal(words.begin(), words.end(), exe.code.begin() + first);
+        }
+        if (!canonical) {
+            raw.insert(raw.end(), exe.code.begin() + first, exe.code.begin() + last);
+            continue;
+        }
+
+        flush_raw(os, raw);
+        put_byte(os, d.op);
+        for(ui32 a = 0; a < arg_count_of(d); ++a)
+            put_operand(os, d.args[a]);
+    }
+    flush_raw(os, raw);
+}
+
+std::optional<vcx::Executable> read_compact(std::istream& is) {
+    char magic[sizeof(compact_magic)];
+    ui8 version;
+    if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, compact_magic, sizeof(magic)) != 0)
+        return {};
+    if (!get_byte(is, version) || version != compact_version)
+        return {};
+
+    vcx::Executable exe;
+    ui32 count;
+    if (!get_varint(is, exe.entry_point) || !get_varint(is, count))
+        return {};
+    for(ui32 i = 0; i < count; ++i) {
+        ui32 length, value;
+        if (!get_varint(is, length))
+            return {};
+        std::string name(length, '\0');
+        if (!is.read(name.data(), length) || !get_varint(is, value))
+            return {};
+        exe.symbols[name] = value;
+    }
+
+    if (!get_varint(is, count))
+        return {};
+    exe.jmp_table.resize(count);
+    for(auto& pc : exe.jmp_table)
+        if (!get_varint(is, pc))
+            return {};
+
+    if (!get_varint(is, count))
+        return {};
+    exe.data.resize(count);
+    for(auto& w : exe.data)
+        if (!get_word(is, w))
+            return {};
+
+    if (!get_varint(is, count))
+        return {};
+    exe.code.reserve(count);
+    while(exe.code.size() < count) {
+        ui8 op;
+        if (!get_byte(is, op))
+            return {};
+
+        if (op == raw_words) {
+            ui32 n, w;
+            if (!get_varint(is, n))
+                return {};
+            for(ui32 i = 0; i < n; ++i) {
+                if (!get_word(is, w))
+                    return {};
+                exe.code.push_back(w);
+            }
+            continue;
+        }
+
+        if (!is_operation(op))
+            return {};
+        DecodedInstruction d;
+        d.op = op;
+        d.wide = op >= interpreter::WideInstruction::first_operation;
+        d.valid = true;
+        for(ui32 a = 0; a < arg_count_of(d); ++a)
+            if (!get_operand(is, d.args[a]))
+                return {};
+
+        auto words = encode(d);
+        exe.code.insert(exe.code.end(), words.begin(), words.end());
+    }
+
+    if (exe.code.size() != count)
+        return {};
+    return exe;
+}
+
+bool is_compact(std::istream& is) {
+    auto start = is.tellg();
+    char magic[sizeof(compact_magic)];
+    bool compact = static_cast<bool>(is.read(magic, sizeof(magic))) && std::memcmp(magic, compact_magic, sizeof(magic)) == 0;
+    is.clear();
+    is.seekg(start);
+    return compact;
+}
+
+std::optional<vcx::Executable> read_executable(std::istream& is) {
+    if (is_compact(is))
+        return read_compact(is);
+
+    vcx::Executable exe;
+    is >> exe;
+    return exe;
+}
+
+}}
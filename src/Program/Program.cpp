@@ -0,0 +1,256 @@
+#include <vcrate/Program/Program.hpp>
+
+#include <vcrate/Interpreter/WideInstruction.hpp>
+
+#include <stdexcept>
+#include <utility>
+
+namespace vcrate { namespace program {
+
+using Operations = bytecode::Operations;
+using interpreter::WideInstruction;
+using interpreter::WideOperations;
+
+bool is_known_operation(Operations ope) {
+    switch(ope) {
+        case Operations::ADD:   case Operations::ADDF:  case Operations::SUB:   case Operations::SUBF:
+        case Operations::MOD:   case Operations::MODF:  case Operations::MUL:   case Operations::MULU:
+        case Operations::MULF:  case Operations::DIV:   case Operations::DIVU:  case Operations::DIVF:
+        case Operations::MOV:   case Operations::LEA:   case Operations::POP:   case Operations::PUSH:
+        case Operations::JMP:   case Operations::JMPE:  case Operations::JMPNE: case Operations::JMPG:
+        case Operations::JMPGE: case Operations::AND:   case Operations::OR:    case Operations::XOR:
+        case Operations::NOT:   case Operations::SHL:   case Operations::RTL:   case Operations::SHR:
+        case Operations::RTR:   case Operations::SWP:   case Operations::CMP:   case Operations::CMPU:
+        case Operations::INC:   case Operations::INCF:  case Operations::DEC:   case Operations::DECF:
+        case Operations::NEW:   case Operations::DEL:   case Operations::CALL:  case Operations::RET:
+        case Operations::ETR:   case Operations::LVE:   case Operations::HLT:   case Operations::OUT:
+        case Operations::DBG:   case Operations::DBGU:  case Operations::DBGF:  case Operations::ITU:
+        case Operations::ITF:   case Operations::UTI:   case Operations::UTF:   case Operations::FTI:
+        case Operations::FTU:
+            return true;
+        default:
+            return false;
+    }
+}
+
+ui32 arg_count_of(DecodedInstruction const& d) {
+    if (!d.valid)
+        return 0;
+    if (d.wide)
+        return WideInstruction::arg_count_of(static_cast<WideOperations>(d.op));
+    return bytecode::OpDefinition::get(static_cast<Operations>(d.op)).arg_count();
+}
+
+Access access_of(DecodedInstruction const& d, ui32 index) {
+    if (index >= arg_count_of(d))
+        return Access::None;
+
+    if (d.wide) {
+        switch(static_cast<WideOperations>(d.op)) {
+            case WideOperations::CMPL: case WideOperations::CMPLU: case WideOperations::CMPD:
+            case WideOperations::DBGL: case WideOperations::DBGLU: case WideOperations::DBGD:
+                return Access::Read;
+            case WideOperations::MOVL:
+                return index == 0 ? Access::Write : Access::Read;
+            default:
+                return index == 0 ? Access::ReadWrite : Access::Read;
+        }
+    }
+
+    switch(static_cast<Operations>(d.op)) {
+        case Operations::MOV: case Operations::NEW:
+            return index == 0 ? Access::Write : Access::Read;
+        case Operations::LEA:
+            return index == 0 ? Access::Write : Access::Address;
+        case Operations::POP:
+            return Access::Write;
+        case Operations::SWP:
+            return Access::ReadWrite;
+        case Operations::CMP: case Operations::CMPU:
+        case Operations::PUSH: case Operations::DEL: case Operations::OUT:
+        case Operations::DBG: case Operations::DBGU: case Operations::DBGF:
+        case Operations::JMP: case Operations::JMPE: case Operations::JMPNE:
+        case Operations::JMPG: case Operations::JMPGE: case Operations::CALL:
+            return Access::Read;
+        default:
+            return index == 0 ? Access::ReadWrite : Access::Read;
+    }
+}
+
+bool writes_register(DecodedInstruction const& d, ui32 id) {
+    for(ui32 i = 0; i < 2; ++i) {
+        auto access = access_of(d, i);
+        if ((access == Access::Write || access == Access::ReadWrite) && d.args[i].kind == OperandKind::Register && d.args[i].reg == id)
+            return true;
+    }
+    return false;
+}
+
+bool is_jump(DecodedInstruction const& d) {
+    if (!d.valid || d.wide)
+        return false;
+    switch(static_cast<Operations>(d.op)) {
+        case Operations::JMP: case Operations::JMPE: case Operations::JMPNE:
+        case Operations::JMPG: case Operations::JMPGE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool is_conditional_jump(DecodedInstruction const& d) {
+    return is_jump(d) && static_cast<Operations>(d.op) != Operations::JMP;
+}
+
+bool is_call(DecodedInstruction const& d) {
+    return d.valid && !d.wide && static_cast<Operations>(d.op) == Operations::CALL;
+}
+
+bool is_return(DecodedInstruction const& d) {
+    return d.valid && !d.wide && static_cast<Operations>(d.op) == Operations::RET;
+}
+
+bool is_halt(DecodedInstruction const& d) {
+    return d.valid && !d.wide && static_cast<Operations>(d.op) == Operations::HLT;
+}
+
+bool has_static_target(DecodedInstruction const& d) {
+    return (is_jump(d) || is_call(d)) && d.args[0].kind == OperandKind::Value;
+}
+
+ui32 static_target_of(DecodedInstruction const& d) {
+    return d.args[0].value + d.pc + (is_call(d) ? d.size : 0);
+}
+
+Operand to_operand(instruction::Argument const& arg) {
+    return std::visit(instruction::Visitor {
+        [] (instruction::Value arg)         { return Operand { OperandKind::Value, 0, static_cast<ui32>(arg.value) }; },
+        [] (instruction::Register arg)      { return Operand { OperandKind::Register, static_cast<ui8>(arg.id), 0 }; },
+        [] (instruction::Displacement arg)  { return Operand { OperandKind::Displacement, static_cast<ui8>(arg.reg.id), static_cast<ui32>(arg.displacement) }; },
+        [] (instruction::Address arg)       { return Operand { OperandKind::Address, 0, static_cast<ui32>(arg.address) }; },
+        [] (instruction::Deferred arg)      { return Operand { OperandKind::Deferred, static_cast<ui8>(arg.reg.id), 0 }; }
+    }, arg);
+}
+
+instruction::Argument to_argument(Operand const& operand) {
+    instruction::Register reg = instruction::Register::A;
+    reg.id = operand.reg;
+    switch(operand.kind) {
+        case OperandKind::Register:     return reg;
+        case OperandKind::Value:        return instruction::Value(static_cast<i32>(operand.value));
+        case OperandKind::Address:      return instruction::Address(operand.value);
+        case OperandKind::Deferred:     return instruction::Deferred(reg);
+        case OperandKind::Displacement: return instruction::Displacement(reg, static_cast<i32>(operand.value));
+        default:
+            throw std::runtime_error("This operand doesn't exist");
+    }
+}
+
+std::vector<ui32> encode(DecodedInstruction const& d) {
+    auto words = [] (auto const& i) {
+        std::vector<ui32> w { i.get_main_instruction() };
+        if (i.get_byte_size() > sizeof(ui32))
+            w.push_back(i.get_first_extra());
+        if (i.get_byte_size() > 2 * sizeof(ui32))
+            w.push_back(i.get_second_extra());
+        return w;
+    };
+
+    auto count = arg_count_of(d);
+    if (d.wide) {
+        auto ope = static_cast<WideOperations>(d.op);
+        if (count == 1)
+            return words(WideInstruction(ope, to_argument(d.args[0])));
+        return words(WideInstruction(ope, to_argument(d.args[0]), to_argument(d.args[1])));
+    }
+
+    auto ope = static_cast<Operations>(d.op);
+    if (count == 0)
+        return words(instruction::Instruction(ope));
+    if (count == 1)
+        return words(instruction::Instruction(ope, to_argument(d.args[0])));
+    return words(instruction::Instruction(ope, to_argument(d.args[0]), to_argument(d.args[1])));
+}
+
+namespace {
+
+template<typename I>
+void decode_arguments(DecodedInstruction& d, I const& i) {
+    auto count = arg_count_of(d);
+    if (count == 1) {
+        d.args[0] = to_operand(i.get_complete_argument());
+    } else if (count == 2) {
+        d.args[0] = to_operand(i.get_first_argument());
+        d.args[1] = to_operand(i.get_second_argument());
+    }
+}
+
+}
+
+Program::Program(vcx::Executable const& exe) : indices(exe.code.size(), invalid_index) {
+    auto word_at = [&exe] (ui32 word) { return word < exe.code.size() ? exe.code[word] : 0; };
+
+    for(ui32 word = 0; word < exe.code.size();) {
+        DecodedInstruction d;
+        d.pc = word * 4;
+
+        ui32 main = exe.code[word];
+        if (WideInstruction::is_wide(main)) {
+            WideInstruction i(main, word_at(word + 1), word_at(word + 2));
+            d.op = static_cast<ui8>(i.get_operation());
+            d.wide = true;
+            d.valid = true;
+            d.size = i.get_byte_size();
+            decode_arguments(d, i);
+        } else {
+            instruction::Instruction i(main, word_at(word + 1), word_at(word + 2));
+            d.op = static_cast<ui8>(i.get_operation());
+            d.valid = is_known_operation(i.get_operation());
+            d.size = d.valid ? i.get_byte_size() : 4;
+            if (d.valid)
+                decode_arguments(d, i);
+        }
+
+        if (word + d.size / 4 > exe.code.size())
+            d.valid = false;
+
+        indices[word] = instructions.size();
+        instructions.push_back(d);
+        word += d.size / 4;
+    }
+}
+
+Program::Program(std::vector<DecodedInstruction> instructions, ui32 code_words) : instructions(std::move(instructions)), indices(code_words, invalid_index) {
+    for(ui32 i = 0; i < this->instructions.size(); ++i) {
+        ui32 word = this->instructions[i].pc / 4;
+        if (word < indices.size())
+            indices[word] = i;
+    }
+}
+
+ui32 Program::index_of(ui32 pc) const {
+    ui32 word = pc / 4;
+    if (pc % 4 != 0 || word >= indices.size())
+        return invalid_index;
+    return indices[word];
+}
+
+bool Program::patch(ui32 pc, DecodedInstruction d) {
+    auto index = index_of(pc);
+    if (index == invalid_index)
+        return false;
+    d.pc = pc;
+    d.size = instructions[index].size;
+    instructions[index] = d;
+    return true;
+}
+
+std::vector<DecodedInstruction> const& Program::get_instructions() const {
+    return instructions;
+}
+
+ui32 Program::get_code_size() const {
+    return indices.size() * 4;
+}
+
+}}
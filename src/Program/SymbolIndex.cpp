@@ -0,0 +1,57 @@
+#include <vcrate/Program/SymbolIndex.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+
+namespace vcrate { namespace program {
+
+namespace {
+
+bool before(SymbolIndex::Symbol const& s, ui32 address) {
+    return s.address < address;
+}
+
+}
+
+SymbolIndex::SymbolIndex(vcx::Executable const& exe) {
+    symbols.reserve(exe.symbols.size());
+    for(auto const& p : exe.symbols)
+        symbols.push_back({ p.second, p.first });
+    // Stable, the map gave them in the order of their names
+    std::stable_sort(symbols.begin(), symbols.end(), [] (Symbol const& a, Symbol const& b) { return a.address < b.address; });
+}
+
+SymbolIndex::Symbol const* SymbolIndex::enclosing(ui32 address) const {
+    auto it = std::upper_bound(symbols.begin(), symbols.end(), address, [] (ui32 a, Symbol const& s) { return a < s.address; });
+    if (it == symbols.begin())
+        return nullptr;
+    return &*std::lower_bound(symbols.begin(), it, std::prev(it)->address, before);
+}
+
+SymbolIndex::Symbol const* SymbolIndex::at(ui32 address) const {
+    auto it = std::lower_bound(symbols.begin(), symbols.end(), address, before);
+    if (it == symbols.end() || it->address != address)
+        return nullptr;
+    return &*it;
+}
+
+std::string SymbolIndex::location_of(ui32 address) const {
+    auto symbol = enclosing(address);
+
+    std::stringstream ss;
+    if (symbol) {
+        ss << symbol->name;
+        if (address != symbol->address)
+            ss << "+" << address - symbol->address;
+    } else {
+        ss << "0x" << std::hex << address;
+    }
+    return ss.str();
+}
+
+std::vector<SymbolIndex::Symbol> const& SymbolIndex::get_symbols() const {
+    return symbols;
+}
+
+}}
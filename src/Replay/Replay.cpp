@@ -0,0 +1,141 @@
+#include <vcrate/Replay/Replay.hpp>
+
+#include <vcrate/Interpreter/Interpreter.hpp>
+
+#include <algorithm>
+
+namespace vcrate { namespace replay {
+
+namespace {
+
+constexpr ui64 fnv_offset = 0xcbf29ce484222325;
+constexpr ui64 fnv_prime = 0x100000001b3;
+
+void hash_bytes(ui64& hash, void const* data, std::size_t size) {
+    auto bytes = static_cast<ui8 const*>(data);
+    for(std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= fnv_prime;
+    }
+}
+
+void hash_words(ui64& hash, std::vector<ui32> const& words) {
+    ui32 size = words.size();
+    hash_bytes(hash, &size, sizeof(size));
+    hash_bytes(hash, words.data(), words.size() * sizeof(ui32));
+}
+
+template<typename T>
+void write(std::ostream& os, T const& value) {
+    os.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+template<typename T>
+void read(std::istream& is, T& value) {
+    is.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+}
+
+ui64 hash_of(vcx::Executable const& exe) {
+    ui64 hash = fnv_offset;
+    hash_bytes(hash, &exe.entry_point, sizeof(exe.entry_point));
+    for(auto const& p : exe.symbols) {
+        hash_bytes(hash, p.first.data(), p.first.size());
+        hash_bytes(hash, &p.second, sizeof(p.second));
+    }
+    hash_words(hash, exe.jmp_table);
+    hash_words(hash, exe.data);
+    hash_words(hash, exe.code);
+    return hash;
+}
+
+void Recording::save(std::ostream& os) const {
+    write(os, magic);
+    write(os, version);
+    write(os, executable_hash);
+    write(os, seed);
+    write(os, memory_size);
+    write(os, static_cast<ui8>(trap_handler.has_value()));
+    write(os, trap_handler.value_or(0));
+    write(os, instructions);
+    write(os, halt_code);
+}
+
+std::optional<Recording> Recording::load(std::istream& is) {
+    ui32 m = 0, v = 0;
+    read(is, m);
+    read(is, v);
+    if (!is || m != magic || v != version)
+        return std::nullopt;
+
+    Recording recording;
+    read(is, recording.executable_hash);
+    read(is, recording.seed);
+    read(is, recording.memory_size);
+    ui8 has_trap_handler = 0;
+    ui32 trap_handler = 0;
+    read(is, has_trap_handler);
+    read(is, trap_handler);
+    if (has_trap_handler)
+        recording.trap_handler = trap_handler;
+    read(is, recording.instructions);
+    read(is, recording.halt_code);
+    if (!is)
+        return std::nullopt;
+    return recording;
+}
+
+Replayer::Replayer(vcx::Executable const& exe, Recording const& recording, ui64 checkpoint_period, ui32 max_checkpoints)
+    : checkpoint_period(std::max<ui64>(1, checkpoint_period)), max_checkpoints(std::max<ui32>(2, max_checkpoints)), sandbox(recording.memory_size) {
+    sandbox.load_executable(exe);
+    counters = interpreter::Counters(sandbox);
+    counters.trap_handler = recording.trap_handler;
+    checkpoints.push_back({ sandbox, counters });
+}
+
+SandBox& Replayer::get_sandbox() {
+    return sandbox;
+}
+
+interpreter::Counters& Replayer::get_counters() {
+    return counters;
+}
+
+ui64 Replayer::get_instruction() const {
+    return counters.instructions;
+}
+
+bool Replayer::is_halted() const {
+    return sandbox.is_halted();
+}
+
+void Replayer::step() {
+    interpreter::Interpreter::run_next_instruction(sandbox, counters);
+    if (counters.instructions % checkpoint_period != 0 || checkpoints.back().counters.instructions >= counters.instructions)
+        return;
+    checkpoints.push_back({ sandbox, counters });
+
+    // The checkpoints left are at the multiples of the doubled period, the first one at the start
+    if (checkpoints.size() > max_checkpoints) {
+        checkpoint_period *= 2;
+        auto kept = std::remove_if(checkpoints.begin(), checkpoints.end(),
+            [this] (Checkpoint const& checkpoint) { return checkpoint.counters.instructions % checkpoint_period != 0; });
+        checkpoints.erase(kept, checkpoints.end());
+    }
+}
+
+void Replayer::seek(ui64 instruction) {
+    if (instruction < counters.instructions) {
+        auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), instruction,
+            [] (ui64 instruction, Checkpoint const& checkpoint) { return instruction < checkpoint.counters.instructions; });
+        --it;
+        sandbox = it->sandbox;
+        counters = it->counters;
+    }
+
+    while(counters.instructions < instruction && !sandbox.is_halted())
+        step();
+}
+
+}}
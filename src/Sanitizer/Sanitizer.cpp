@@ -0,0 +1,266 @@
+#include <vcrate/Sanitizer/Sanitizer.hpp>
+
+#include <vcrate/Interpreter/Interpreter.hpp>
+
+#include <algorithm>
+
+namespace vcrate { namespace sanitizer {
+
+using program::Access;
+using program::DecodedInstruction;
+using program::Operand;
+using program::OperandKind;
+using bytecode::Operations;
+
+namespace {
+
+bool is_memory(Operand const& arg) {
+    return arg.kind == OperandKind::Address || arg.kind == OperandKind::Deferred || arg.kind == OperandKind::Displacement;
+}
+
+ui32 address_of(SandBox const& sandbox, Operand const& arg) {
+    switch(arg.kind) {
+        case OperandKind::Address:      return arg.value;
+        case OperandKind::Deferred:     return sandbox.get_register(arg.reg);
+        case OperandKind::Displacement: return sandbox.get_register(arg.reg) + arg.value;
+        default:                        return 0;
+    }
+}
+
+ui32 value_of(SandBox const& sandbox, Operand const& arg) {
+    switch(arg.kind) {
+        case OperandKind::Register: return sandbox.get_register(arg.reg);
+        case OperandKind::Value:    return arg.value;
+        default:                    return sandbox.get_memory_at(address_of(sandbox, arg));
+    }
+}
+
+// The arguments of the Interpreter as a DecodedInstruction, to use the tables of the Program
+DecodedInstruction decoded_of(interpreter::CachedInstruction const& c, ui32 pc) {
+    DecodedInstruction d;
+    d.pc = pc;
+    d.op = c.operation;
+    d.size = c.size;
+    d.wide = c.wide;
+    d.valid = c.wide || program::is_known_operation(c.get_operation());
+    if (d.valid) {
+        for(ui32 i = 0; i < program::arg_count_of(d); ++i)
+            d.args[i] = program::to_operand(c.args[i]);
+    }
+    return d;
+}
+
+bool is(DecodedInstruction const& d, Operations ope) {
+    return !d.wide && d.op == static_cast<ui8>(ope);
+}
+
+}
+
+char const* to_string(Kind kind) {
+    switch(kind) {
+        case Kind::UseAfterFree:    return "use after free";
+        case Kind::DoubleFree:      return "double free";
+        case Kind::InvalidFree:     return "invalid free";
+        case Kind::OutOfBounds:     return "out of bounds";
+        case Kind::Uninitialized:   return "uninitialized read";
+        default:                    return "unknown";
+    }
+}
+
+Sanitizer::Sanitizer(vcx::Executable const& exe, SandBox const& sandbox)
+    : symbols(exe), cache(exe), stack_base(sandbox.get_sp()), lowest_sp(sandbox.get_sp()) {}
+
+void Sanitizer::run(SandBox& sandbox, interpreter::Counters& counters) {
+    while(!sandbox.is_halted())
+        run_next_instruction(sandbox, counters);
+}
+
+void Sanitizer::run_next_instruction(SandBox& sandbox, interpreter::Counters& counters) {
+    pc = sandbox.get_pc();
+    auto const& instruction = cache.fetch(sandbox, pc);
+    auto d = decoded_of(instruction, pc);
+    ui32 sp = sandbox.get_sp();
+
+    if (!d.valid || before(sandbox, counters, d))
+        interpreter::Interpreter::run_next_instruction(sandbox, counters, cache);
+    if (d.valid)
+        after(sandbox, d, sp);
+}
+
+std::vector<Report> const& Sanitizer::get_reports() const {
+    return reports;
+}
+
+void Sanitizer::report(std::ostream& os) const {
+    for(auto const& r : reports) {
+        os << "Sanitizer : " << to_string(r.kind) << " at " << r.pc << " in " << symbols.location_of(r.pc) << ", ";
+        if (r.size > 0)
+            os << (r.write ? "write" : "read") << " of " << r.size << " bytes at " << r.address;
+        else
+            os << "DEL of " << r.address;
+        if (!r.detail.empty())
+            os << ", " << r.detail;
+        os << " (" << r.count << (r.count > 1 ? " times)\n" : " time)\n");
+    }
+}
+
+bool Sanitizer::before(SandBox& sandbox, interpreter::Counters& counters, DecodedInstruction const& d) {
+    // 64 bits operations access two words
+    ui32 size = d.wide ? 8 : 4;
+    for(ui32 i = 0; i < program::arg_count_of(d); ++i) {
+        auto a = program::access_of(d, i);
+        if (!is_memory(d.args[i]) || a == Access::None || a == Access::Address)
+            continue;
+        ui32 address = address_of(sandbox, d.args[i]);
+        if (a == Access::Read || a == Access::ReadWrite)
+            access(address, size, false);
+        if (a == Access::Write || a == Access::ReadWrite)
+            access(address, size, true);
+    }
+
+    if (is(d, Operations::POP) || is(d, Operations::RET))
+        access(sandbox.get_sp(), 4, false);
+    else if (is(d, Operations::LVE))
+        access(sandbox.get_bp(), 4, false);
+    else if (is(d, Operations::NEW) || is(d, Operations::DEL)) {
+        ++counters.instructions;
+        sandbox.set_pc(pc + d.size);
+        if (is(d, Operations::NEW))
+            allocate(sandbox, counters, d);
+        else
+            free(sandbox, counters, value_of(sandbox, d.args[0]));
+        return false;
+    }
+    return true;
+}
+
+void Sanitizer::after(SandBox const& sandbox, DecodedInstruction const& d, ui32 sp) {
+    // The words the stack grew by are written only by a push
+    ui32 new_sp = sandbox.get_sp();
+    if (new_sp <= stack_base)
+        stack_written.resize((stack_base - new_sp) / 4, false);
+    lowest_sp = std::min(lowest_sp, new_sp);
+    if (new_sp < sp && (is(d, Operations::PUSH) || is(d, Operations::CALL) || is(d, Operations::ETR)) && !stack_written.empty())
+        stack_written.back() = true;
+}
+
+void Sanitizer::access(ui32 address, ui32 size, bool write) {
+    ui32 end = address + size;
+
+    auto it = blocks.upper_bound(address);
+    if (it != blocks.begin()) {
+        auto& [start, block] = *std::prev(it);
+        if (address < start + block.size) {
+            if (end > start + block.size)
+                return fault(Kind::OutOfBounds, address, size, write, "crossing the end of " + describe(start, block));
+            for(ui32 a = address; a < end; ++a) {
+                if (write) {
+                    block.written[a - start] = true;
+                } else if (!block.written[a - start]) {
+                    return fault(Kind::Uninitialized, address, size, write,
+                                 "byte " + std::to_string(a - start) + " of " + describe(start, block));
+                }
+            }
+            return;
+        }
+    }
+
+    ui32 sp = stack_base - 4 * stack_written.size();
+    if (address >= sp && address < stack_base) {
+        for(ui32 a = address & ~3u; a < end && a < stack_base; a += 4) {
+            ui32 word = (stack_base - 4 - a) / 4;
+            if (write) {
+                stack_written[word] = true;
+            } else if (!stack_written[word]) {
+                return fault(Kind::Uninitialized, address, size, write,
+                             "in the stack, " + std::to_string(stack_base - address) + " bytes below its base");
+            }
+        }
+        return;
+    }
+    if (address >= lowest_sp && address < sp)
+        return fault(Kind::OutOfBounds, address, size, write, "in the stack, " + std::to_string(sp - address) + " bytes below the sp");
+
+    auto f = freed.upper_bound(address);
+    if (f != freed.begin() && address < std::prev(f)->first + std::prev(f)->second.size)
+        return fault(Kind::UseAfterFree, address, size, write, "in " + describe(std::prev(f)->first, std::prev(f)->second));
+
+    if (end > heap_begin && address < heap_end) {
+        // Relative to the closest block
+        std::string detail = "outside of any block";
+        if (it != blocks.end() && (it == blocks.begin() || it->first - address < address - std::prev(it)->first - std::prev(it)->second.size))
+            detail = std::to_string(it->first - address) + " bytes before " + describe(it->first, it->second);
+        else if (it != blocks.begin())
+            detail = std::to_string(address - std::prev(it)->first - std::prev(it)->second.size) + " bytes after " + describe(std::prev(it)->first, std::prev(it)->second);
+        fault(Kind::OutOfBounds, address, size, write, detail);
+    }
+}
+
+void Sanitizer::allocate(SandBox& sandbox, interpreter::Counters& counters, DecodedInstruction const& d) {
+    ui32 size = value_of(sandbox, d.args[1]);
+    ui32 address = sandbox.allocate(size + redzone);
+    counters.on_allocate(address, size);
+    if (d.args[0].kind == OperandKind::Register)
+        sandbox.set_register(d.args[0].reg, address);
+    else
+        sandbox.set_memory_at(address_of(sandbox, d.args[0]), address);
+
+    // Freed blocks are forgotten once their memory is given again
+    auto it = freed.lower_bound(address);
+    if (it != freed.begin() && std::prev(it)->first + std::prev(it)->second.size + redzone > address)
+        --it;
+    while(it != freed.end() && it->first < address + size + redzone)
+        it = freed.erase(it);
+
+    blocks[address] = { size, pc, 0, true, std::vector<bool>(size, false) };
+    heap_begin = std::min(heap_begin, address);
+    heap_end = std::max(heap_end, address + size + redzone);
+}
+
+void Sanitizer::free(SandBox& sandbox, interpreter::Counters& counters, ui32 address) {
+    if (blocks.count(address) == 0) {
+        auto it = freed.find(address);
+        if (it != freed.end())
+            fault(Kind::DoubleFree, address, 0, false, describe(address, it->second));
+        else
+            fault(Kind::InvalidFree, address, 0, false, "not the start of a block");
+        return;
+    }
+
+    counters.on_deallocate(address);
+    auto node = blocks.extract(address);
+    node.mapped().freed_at = pc;
+    node.mapped().live = false;
+    node.mapped().written.clear();
+    quarantined += node.mapped().size + redzone;
+    freed.insert(std::move(node));
+
+    quarantine.push_back(address);
+    while(quarantined > quarantine_size) {
+        auto oldest = freed.find(quarantine.front());
+        quarantined -= oldest->second.size + redzone;
+        sandbox.deallocate(quarantine.front());
+        quarantine.pop_front();
+    }
+}
+
+void Sanitizer::fault(Kind kind, ui32 address, ui32 size, bool write, std::string detail) {
+    auto key = std::make_pair(kind, pc);
+    auto it = report_indices.find(key);
+    if (it != report_indices.end()) {
+        ++reports[it->second].count;
+        return;
+    }
+    report_indices.emplace(key, reports.size());
+    reports.push_back({ kind, pc, address, size, write, std::move(detail), 1 });
+}
+
+std::string Sanitizer::describe(ui32 address, Block const& block) const {
+    std::string s = "the block of " + std::to_string(block.size) + " bytes at " + std::to_string(address)
+                  + " allocated at " + std::to_string(block.allocated_at) + " in " + symbols.location_of(block.allocated_at);
+    if (!block.live)
+        s += " and freed at " + std::to_string(block.freed_at) + " in " + symbols.location_of(block.freed_at);
+    return s;
+}
+
+}}
@@ -0,0 +1,571 @@
+#include <vcrate/Server/Server.hpp>
+
+#include <vcrate/Cache/DiskCache.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/Interpreter/Interpreter.hpp>
+#include <vcrate/Interpreter/VerifiedInterpreter.hpp>
+#include <vcrate/Pool/SandBoxPool.hpp>
+#include <vcrate/Program/Compact.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+#include <vcrate/Replay/Replay.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace vcrate { namespace server {
+
+namespace {
+
+// Larger frames are refused instead of allocated
+constexpr ui32 max_frame_size = 1u << 28;
+
+void put_32(std::string& s, ui32 v) {
+    for(ui32 i = 0; i < 4; ++i)
+        s.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+void put_64(std::string& s, ui64 v) {
+    put_32(s, static_cast<ui32>(v));
+    put_32(s, static_cast<ui32>(v >> 32));
+}
+
+void put_string(std::string& s, std::string const& v) {
+    put_32(s, v.size());
+    s += v;
+}
+
+class Reader {
+public:
+
+    explicit Reader(std::string const& frame) : frame(frame) {}
+
+    bool magic(char const* m) {
+        if (frame.compare(position, 4, m) != 0)
+            return false;
+        position += 4;
+        return true;
+    }
+
+    bool get_8(ui8& v) {
+        if (frame.size() - position < 1)
+            return false;
+        v = static_cast<ui8>(frame[position++]);
+        return true;
+    }
+
+    bool get_32(ui32& v) {
+        if (frame.size() - position < 4)
+            return false;
+        v = 0;
+        for(ui32 i = 0; i < 4; ++i)
+            v |= static_cast<ui32>(static_cast<ui8>(frame[position++])) << (8 * i);
+        return true;
+    }
+
+    bool get_64(ui64& v) {
+        ui32 low, high;
+        if (!get_32(low) || !get_32(high))
+            return false;
+        v = static_cast<ui64>(high) << 32 | low;
+        return true;
+    }
+
+    bool get_string(std::string& v) {
+        ui32 size;
+        if (!get_32(size) || frame.size() - position < size)
+            return false;
+        v = frame.substr(position, size);
+        position += size;
+        return true;
+    }
+
+    bool at_end() const {
+        return position == frame.size();
+    }
+
+private:
+
+    std::string const& frame;
+    std::size_t position = 0;
+
+};
+
+bool read_exactly(int fd, char* data, std::size_t size) {
+    while(size > 0) {
+        auto n = ::read(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool write_exactly(int fd, char const* data, std::size_t size) {
+    while(size > 0) {
+        // A client gone away is an error on this connection, not a SIGPIPE for the whole server
+        auto n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool read_frame(int fd, std::string& frame) {
+    char header[4];
+    if (!read_exactly(fd, header, sizeof(header)))
+        return false;
+    ui32 size = 0;
+    for(ui32 i = 0; i < 4; ++i)
+        size |= static_cast<ui32>(static_cast<ui8>(header[i])) << (8 * i);
+    if (size > max_frame_size)
+        return false;
+    frame.resize(size);
+    return read_exactly(fd, frame.data(), size);
+}
+
+bool write_frame(int fd, std::string const& payload) {
+    std::string frame;
+    put_string(frame, payload);
+    return write_exactly(fd, frame.data(), frame.size());
+}
+
+bool address_of(std::string const& socket_path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+        return false;
+    std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+    return true;
+}
+
+// Where the output of the request run by this thread goes, nullptr outside of a request
+thread_local std::string* captured = nullptr;
+
+// Unbuffered, so every character reaches the string of the thread writing it
+class Capture : public std::streambuf {
+public:
+
+    explicit Capture(std::streambuf* forward) : forward(forward) {}
+
+protected:
+
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        if (captured) {
+            captured->push_back(traits_type::to_char_type(c));
+            return c;
+        }
+        return forward ? forward->sputc(traits_type::to_char_type(c)) : c;
+    }
+
+    std::streamsize xsputn(char const* s, std::streamsize n) override {
+        if (captured) {
+            captured->append(s, n);
+            return n;
+        }
+        return forward ? forward->sputn(s, n) : n;
+    }
+
+    int sync() override {
+        return captured || !forward ? 0 : forward->pubsync();
+    }
+
+private:
+
+    std::streambuf* forward;
+
+};
+
+// Packed in little endian words, the way the sandbox addresses memory
+bool pass_input(SandBox& sandbox, interpreter::Counters& counters, std::string const& input) {
+    ui32 size = input.size();
+    ui32 address = sandbox.allocate(size);
+    if (address == 0)
+        return false;
+    counters.on_allocate(address, size);
+    for(ui32 i = 0; i < size; i += 4) {
+        ui32 word = 0;
+        for(ui32 b = 0; b < 4 && i + b < size; ++b)
+            word |= static_cast<ui32>(static_cast<ui8>(input[i + b])) << (8 * b);
+        sandbox.set_memory_at(address + i, word);
+    }
+    sandbox.set_register(0, address);
+    sandbox.set_register(1, size);
+    return true;
+}
+
+}
+
+struct Server::Loaded {
+    vcx::Executable exe;
+    // Set if the executable passes the verifier
+    std::optional<program::Program> program;
+    // For the location of a trap
+    program::SymbolIndex symbols;
+    // Of the executable, to know if a coverage is of it without hashing it again
+    ui64 hash;
+    std::unique_ptr<pool::SandBoxPool> sandboxes;
+};
+
+char const* to_string(Status status) {
+    switch(status) {
+        case Status::Halted:            return "halted";
+        case Status::LoadError:         return "load error";
+        case Status::InvalidRequest:    return "invalid request";
+        case Status::LimitReached:      return "limit reached";
+        case Status::Trapped:           return "trapped";
+        default:                        return "unknown status";
+    }
+}
+
+std::string encode(Request const& request) {
+    std::string s = "VCRQ";
+    put_string(s, request.path);
+    put_string(s, request.input);
+    put_64(s, request.max_instructions);
+    put_32(s, request.memory_size);
+    return s;
+}
+
+std::string encode(Response const& response) {
+    std::string s = "VCRS";
+    s.push_back(static_cast<char>(response.status));
+    put_32(s, response.halt_code);
+    put_64(s, response.instructions);
+    put_string(s, response.output);
+    put_string(s, response.message);
+    return s;
+}
+
+std::optional<Request> decode_request(std::string const& frame) {
+    Reader reader(frame);
+    Request request;
+    if (!reader.magic("VCRQ") || !reader.get_string(request.path) || !reader.get_string(request.input)
+     || !reader.get_64(request.max_instructions) || !reader.get_32(request.memory_size) || !reader.at_end())
+        return std::nullopt;
+    return request;
+}
+
+std::optional<Response> decode_response(std::string const& frame) {
+    Reader reader(frame);
+    Response response;
+    ui8 status;
+    if (!reader.magic("VCRS") || !reader.get_8(status) || status > static_cast<ui8>(Status::Trapped)
+     || !reader.get_32(response.halt_code) || !reader.get_64(response.instructions)
+     || !reader.get_string(response.output) || !reader.get_string(response.message) || !reader.at_end())
+        return std::nullopt;
+    response.status = static_cast<Status>(status);
+    return response;
+}
+
+std::optional<Response> send(std::string const& socket_path, Request const& request) {
+    sockaddr_un address;
+    if (!address_of(socket_path, address))
+        return std::nullopt;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return std::nullopt;
+
+    std::optional<Response> response;
+    std::string frame;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0
+     && write_frame(fd, encode(request)) && read_frame(fd, frame))
+        response = decode_response(frame);
+    ::close(fd);
+    return response;
+}
+
+Server::Server(Options options) : options(std::move(options)) {
+    previous = std::cout.rdbuf();
+    capture = std::make_unique<Capture>(previous);
+    std::cout.rdbuf(capture.get());
+}
+
+Server::~Server() {
+    std::cout.rdbuf(previous);
+}
+
+std::shared_ptr<Server::Loaded> Server::load(std::string const& path, std::string& error) {
+    struct stat status;
+    if (::stat(path.c_str(), &status) != 0) {
+        error = "File (" + path + ") couldn't be opened";
+        return nullptr;
+    }
+    i64 modified = static_cast<i64>(status.st_mtim.tv_sec) * 1'000'000'000 + status.st_mtim.tv_nsec;
+    i64 size = status.st_size;
+
+    // The first request for a file reads it, the ones racing with it wait for it instead of reading it too
+    std::promise<Loading> promise;
+    std::shared_future<Loading> loading;
+    bool reader = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(path);
+        if (it != cache.end() && it->second.modified == modified && it->second.size == size) {
+            loading = it->second.loading;
+        } else {
+            loading = promise.get_future().share();
+            cache[path] = { modified, size, loading };
+            ++loads;
+            reader = true;
+        }
+    }
+    if (reader) {
+        // The requests waiting for it get the error, and the next one reads the file again
+        Loading result;
+        try {
+            result = read(path);
+        } catch(std::exception const& e) {
+            result = { nullptr, "File (" + path + ") couldn't be loaded: " + e.what() };
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = cache.find(path);
+            if (it != cache.end() && it->second.modified == modified && it->second.size == size)
+                cache.erase(it);
+        }
+        promise.set_value(std::move(result));
+    }
+
+    auto const& result = loading.get();
+    if (!result.loaded)
+        error = result.error;
+    return result.loaded;
+}
+
+Server::Loading Server::read(std::string const& path) const {
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+        return { nullptr, "File (" + path + ") couldn't be opened" };
+    std::optional<vcx::Executable> exe;
+    std::optional<cache::Prepared> prepared;
+    if (!options.cache_directory.empty()) {
+        std::string contents(std::istreambuf_iterator<char>(is), {});
+        prepared = cache::DiskCache(options.cache_directory).prepare(contents);
+        if (prepared)
+            exe = std::move(prepared->exe);
+    } else {
+        exe = program::read_executable(is);
+    }
+    if (!exe)
+        return { nullptr, "File (" + path + ") is not a valid executable" };
+
+    auto loaded = std::make_shared<Loaded>();
+    loaded->exe = std::move(*exe);
+    if (prepared) {
+        if (prepared->verified)
+            loaded->program.emplace(std::move(prepared->program));
+    } else {
+        loaded->program.emplace(loaded->exe);
+        if (verifier::has_errors(verifier::verify(loaded->exe, *loaded->program)))
+            loaded->program.reset();
+    }
+    loaded->symbols = program::SymbolIndex(loaded->exe);
+    loaded->hash = replay::hash_of(loaded->exe);
+    loaded->sandboxes = std::make_unique<pool::SandBoxPool>(loaded->exe, options.memory_size, options.workers);
+    return { loaded, "" };
+}
+
+Response Server::handle(Request const& request, coverage::Coverage* coverage) {
+    // One failing request doesn't take the server down
+    try {
+        return run(request, coverage);
+    } catch(std::exception const& e) {
+        captured = nullptr;
+        Response response;
+        response.status = Status::InvalidRequest;
+        response.message = std::string("Request failed: ") + e.what();
+        return response;
+    }
+}
+
+Response Server::run(Request const& request, coverage::Coverage* coverage) {
+    Response response;
+    auto loaded = load(request.path, response.message);
+    if (!loaded) {
+        response.status = Status::LoadError;
+        return response;
+    }
+    if (request.memory_size > options.max_memory_size) {
+        response.status = Status::InvalidRequest;
+        response.message = "Memory of " + std::to_string(request.memory_size) + " bytes is over the limit of "
+                         + std::to_string(options.max_memory_size) + " bytes";
+        return response;
+    }
+
+    // Only sandboxes of the default size are pooled
+    std::optional<pool::SandBoxPool::Lease> lease;
+    std::unique_ptr<SandBox> own;
+    SandBox* sandbox;
+    if (request.memory_size == 0 || request.memory_size == options.memory_size) {
+        lease.emplace(loaded->sandboxes->acquire());
+        sandbox = &**lease;
+    } else {
+        own = std::make_unique<SandBox>(request.memory_size);
+        own->load_executable(loaded->exe);
+        sandbox = own.get();
+    }
+
+    interpreter::Counters counters(*sandbox);
+    if (!request.input.empty() && !pass_input(*sandbox, counters, request.input)) {
+        response.status = Status::InvalidRequest;
+        response.message = "Input of " + std::to_string(request.input.size()) + " bytes doesn't fit in the sandbox";
+        return response;
+    }
+
+    ui64 limit = request.max_instructions > 0 ? request.max_instructions : std::numeric_limits<ui64>::max();
+    if (coverage && coverage->get_executable_hash() != loaded->hash)
+        *coverage = coverage::Coverage(loaded->exe);
+    // The loop without a coverage stays as tight as before
+    auto run = [&] (auto const& step) {
+        if (coverage) {
+            while(!sandbox->is_halted() && counters.instructions < limit) {
+                coverage->before(*sandbox);
+                step();
+                coverage->after(*sandbox);
+            }
+        } else {
+            while(!sandbox->is_halted() && counters.instructions < limit)
+                step();
+        }
+    };
+
+    captured = &response.output;
+    if (loaded->program) {
+        run([&] { interpreter::VerifiedInterpreter::run_next_instruction(*loaded->program, *sandbox, counters); });
+    } else {
+        // Per request, the program may write to its code
+        interpreter::DecodeCache decoded(loaded->exe);
+        run([&] { interpreter::Interpreter::run_next_instruction(*sandbox, counters, decoded); });
+    }
+    captured = nullptr;
+
+    response.halt_code = sandbox->get_register(0);
+    response.instructions = counters.instructions;
+    if (!sandbox->is_halted()) {
+        response.status = Status::LimitReached;
+    } else if (counters.traps > 0) {
+        response.status = Status::Trapped;
+        response.message = std::string(interpreter::to_string(counters.trap.code)) + " at " + std::to_string(counters.trap.pc)
+                         + " in " + loaded->symbols.location_of(counters.trap.pc);
+    }
+    return response;
+}
+
+void Server::serve_connection(int client) {
+    // Requests fail on their own, anything else only drops this connection
+    try {
+        std::string frame;
+        while(read_frame(client, frame)) {
+            auto request = decode_request(frame);
+            Response response;
+            if (request) {
+                response = handle(*request);
+            } else {
+                response.status = Status::InvalidRequest;
+                response.message = "Frame is not a request";
+            }
+            if (!write_frame(client, encode(response)))
+                break;
+        }
+    } catch(std::exception const&) {}
+    ::close(client);
+}
+
+bool Server::serve(std::ostream& log) {
+    sockaddr_un address;
+    if (!address_of(options.socket_path, address)) {
+        log << "Socket path (" << options.socket_path << ") is not valid\n";
+        return false;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        log << "Socket couldn't be created: " << std::strerror(errno) << '\n';
+        return false;
+    }
+    // Left behind by a server that didn't stop cleanly
+    ::unlink(options.socket_path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        log << "Socket (" << options.socket_path << ") couldn't be listened on: " << std::strerror(errno) << '\n';
+        ::close(fd);
+        return false;
+    }
+    log << "Listening on " << options.socket_path << " with " << options.workers << " workers" << std::endl;
+
+    std::mutex queue_mutex;
+    std::condition_variable ready;
+    std::deque<int> pending;
+    bool stopping = false;
+
+    std::vector<std::thread> workers;
+    for(ui32 i = 0; i < std::max(options.workers, 1u); ++i) {
+        workers.emplace_back([&] {
+            for(;;) {
+                int client;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    ready.wait(lock, [&] { return stopping || !pending.empty(); });
+                    if (pending.empty())
+                        return;
+                    client = pending.front();
+                    pending.pop_front();
+                }
+                serve_connection(client);
+            }
+        });
+    }
+
+    for(;;) {
+        int client = ::accept(fd, nullptr, nullptr);
+        if (client < 0 && errno == EINTR)
+            continue;
+        if (client < 0) {
+            log << "Accepting failed: " << std::strerror(errno) << '\n';
+            break;
+        }
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        pending.push_back(client);
+        ready.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    for(auto& worker : workers)
+        worker.join();
+    ::close(fd);
+    ::unlink(options.socket_path.c_str());
+    return true;
+}
+
+ui64 Server::get_loads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return loads;
+}
+
+}}
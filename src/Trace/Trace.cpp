@@ -0,0 +1,141 @@
+#include <vcrate/Trace/Trace.hpp>
+
+#include <vcrate/bytecode/Operations.hpp>
+#include <vcrate/instruction/Instruction.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace vcrate { namespace trace {
+
+namespace {
+
+ui32 peek(SandBox const& sandbox, instruction::Argument const& arg) {
+    return std::visit(instruction::Visitor {
+        [        ] (instruction::Value arg)          { return static_cast<ui32>(arg.value); },
+        [&sandbox] (instruction::Register arg)       { return sandbox.get_register(arg.id); },
+        [&sandbox] (instruction::Displacement arg)   { return sandbox.get_memory_at(sandbox.get_register(arg.reg.id) + arg.displacement); },
+        [&sandbox] (instruction::Address arg)        { return sandbox.get_memory_at(arg.address); },
+        [&sandbox] (instruction::Deferred arg)       { return sandbox.get_memory_at(sandbox.get_register(arg.reg.id)); }
+    }, arg);
+}
+
+template<typename I>
+void peek_arguments(SandBox const& sandbox, I const& instruction, ui32 arg_count, ui32* values) {
+    if (arg_count == 1) {
+        values[0] = peek(sandbox, instruction.get_complete_argument());
+    } else if (arg_count == 2) {
+        values[0] = peek(sandbox, instruction.get_first_argument());
+        values[1] = peek(sandbox, instruction.get_second_argument());
+    }
+}
+
+}
+
+TraceWriter::TraceWriter(std::string const& file, ui32 capacity)
+    : os(file, std::ios::binary), head(0), tail(0), done(false) {
+    ui64 size = 1;
+    while(size < capacity)
+        size <<= 1;
+    ring.resize(size);
+    mask = size - 1;
+
+    TraceHeader header;
+    os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    // Nothing could be written, records would fill the ring for good
+    if (os)
+        writer = std::thread(&TraceWriter::flush_loop, this);
+}
+
+TraceWriter::~TraceWriter() {
+    done.store(true, std::memory_order_release);
+    if (writer.joinable())
+        writer.join();
+}
+
+bool TraceWriter::is_open() const {
+    return static_cast<bool>(os);
+}
+
+void TraceWriter::record(SandBox const& sandbox) {
+    if (!writer.joinable())
+        return;
+
+    auto h = head.load(std::memory_order_relaxed);
+    while(h - tail.load(std::memory_order_acquire) > mask)
+        std::this_thread::yield();
+
+    auto& r = ring[h & mask];
+    r.pc = sandbox.get_pc();
+    r.instruction[0] = sandbox.get_memory_at(r.pc);
+    r.instruction[1] = sandbox.get_memory_at(r.pc + 4);
+    r.instruction[2] = sandbox.get_memory_at(r.pc + 8);
+    r.values[0] = r.values[1] = 0;
+    r.flags = (sandbox.get_flag_zero() ? TraceRecord::flag_zero : 0) | (sandbox.get_flag_greater() ? TraceRecord::flag_greater : 0);
+    r.sp = sandbox.get_sp();
+
+    try {
+        if (interpreter::WideInstruction::is_wide(r.instruction[0])) {
+            interpreter::WideInstruction is(r.instruction[0], r.instruction[1], r.instruction[2]);
+            peek_arguments(sandbox, is, interpreter::WideInstruction::arg_count_of(is.get_operation()), r.values);
+        } else {
+            instruction::Instruction is(r.instruction[0], r.instruction[1], r.instruction[2]);
+            peek_arguments(sandbox, is, bytecode::OpDefinition::get(is.get_operation()).arg_count(), r.values);
+        }
+    } catch(std::exception const&) {
+        // The interpreter will report the invalid instruction, the record keeps its raw words
+    }
+
+    head.store(h + 1, std::memory_order_release);
+}
+
+void TraceWriter::flush_loop() {
+    for(;;) {
+        auto t = tail.load(std::memory_order_relaxed);
+        auto h = head.load(std::memory_order_acquire);
+
+        if (t == h) {
+            if (done.load(std::memory_order_acquire) && head.load(std::memory_order_acquire) == t)
+                break;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        auto begin = t & mask;
+        auto count = std::min<ui64>(h - t, ring.size() - begin);
+        os.write(reinterpret_cast<char const*>(&ring[begin]), count * sizeof(TraceRecord));
+        tail.store(t + count, std::memory_order_release);
+    }
+    os.flush();
+}
+
+TraceReader::TraceReader(std::istream& is) : is(is) {
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    valid = is
+        && header.magic == TraceHeader::expected_magic
+        && header.version == TraceHeader::expected_version
+        && header.record_size == sizeof(TraceRecord);
+}
+
+bool TraceReader::is_valid() const {
+    return valid;
+}
+
+bool TraceReader::seek(ui64 index) {
+    if (!valid)
+        return false;
+    is.clear();
+    is.seekg(sizeof(TraceHeader) + index * sizeof(TraceRecord));
+    return static_cast<bool>(is);
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    if (!valid)
+        return false;
+    is.read(reinterpret_cast<char*>(&record), sizeof(record));
+    return static_cast<bool>(is);
+}
+
+}}
@@ -0,0 +1,268 @@
+#include <vcrate/Verifier/Verifier.hpp>
+
+#include <vcrate/Interpreter/WideInstruction.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+namespace vcrate { namespace verifier {
+
+using program::Access;
+using program::DecodedInstruction;
+using program::OperandKind;
+using Operations = bytecode::Operations;
+
+std::string to_string(Issue::Severity severity) {
+    switch(severity) {
+        case Issue::Severity::Error:    return "error";
+        case Issue::Severity::Warning:  return "warning";
+        default:                        return "unknown";
+    }
+}
+
+namespace {
+
+// Stack depth in words, relative to the return address of the function
+struct StackState {
+    i32 depth = 0;
+    // Depth before each ETR not yet left
+    std::vector<i32> frames;
+    // Set when SP is changed inside a frame, LVE makes it known again
+    bool unknown = false;
+
+    bool operator == (StackState const& other) const {
+        return depth == other.depth && frames == other.frames && unknown == other.unknown;
+    }
+};
+
+std::string describe(StackState const& state) {
+    if (state.unknown)
+        return "unknown";
+    return std::to_string(state.depth) + (state.frames.empty() ? "" : " in " + std::to_string(state.frames.size()) + " frame(s)");
+}
+
+class Checker {
+public:
+
+    Checker(vcx::Executable const& exe, program::Program const& program) : exe(exe), program(program) {}
+
+    std::vector<Issue> run() {
+        if (!program.at(exe.entry_point))
+            error(exe.entry_point, "The entry point isn't the address of an instruction");
+
+        std::vector<ui32> functions;
+        if (program.at(exe.entry_point))
+            functions.push_back(exe.entry_point);
+
+        for(auto const& d : program.get_instructions()) {
+            check_instruction(d);
+            if (program::is_call(d) && program::has_static_target(d) && program.at(program::static_target_of(d)))
+                functions.push_back(program::static_target_of(d));
+        }
+
+        std::sort(functions.begin(), functions.end());
+        functions.erase(std::unique(functions.begin(), functions.end()), functions.end());
+        for(auto f : functions)
+            check_stack(f);
+
+        std::stable_sort(issues.begin(), issues.end(), [] (Issue const& a, Issue const& b) { return a.pc < b.pc; });
+        return issues;
+    }
+
+private:
+
+    void error(ui32 pc, std::string const& message) {
+        issues.push_back({ Issue::Severity::Error, pc, message });
+    }
+
+    void warning(ui32 pc, std::string const& message) {
+        issues.push_back({ Issue::Severity::Warning, pc, message });
+    }
+
+    void check_instruction(DecodedInstruction const& d) {
+        if (!d.valid) {
+            if (d.size == 4 && !d.wide && !program::is_known_operation(static_cast<Operations>(d.op))) {
+                std::ostringstream ss;
+                ss << "Unknown operation 0x" << std::hex << static_cast<ui32>(d.op);
+                error(d.pc, ss.str());
+            } else {
+                error(d.pc, "The instruction doesn't fit in the code");
+            }
+            return;
+        }
+
+        for(ui32 i = 0; i < program::arg_count_of(d); ++i) {
+            auto access = program::access_of(d, i);
+            auto const& arg = d.args[i];
+            bool write = access == Access::Write || access == Access::ReadWrite;
+
+            if (write && arg.kind == OperandKind::Value)
+                error(d.pc, "Writes to an immediate value");
+            if (access == Access::Address && (arg.kind == OperandKind::Register || arg.kind == OperandKind::Value))
+                error(d.pc, "Takes the address of an argument that has none");
+            if (write && arg.kind == OperandKind::Address && arg.value < program.get_code_size())
+                error(d.pc, "Writes into the code");
+            if (d.wide && arg.kind == OperandKind::Register && arg.reg >= instruction::Register::L.id)
+                error(d.pc, "This register can't start a pair");
+        }
+
+        if (program::has_static_target(d) && !program.at(program::static_target_of(d)))
+            error(d.pc, (program::is_call(d) ? "Calls " : "Jumps to ") + std::to_string(program::static_target_of(d)) + ", which isn't the address of an instruction");
+    }
+
+    void check_stack(ui32 function) {
+        std::unordered_map<ui32, StackState> states;
+        std::vector<std::pair<ui32, StackState>> pending { { function, StackState{} } };
+
+        while(!pending.empty()) {
+            auto [pc, state] = pending.back();
+            pending.pop_back();
+
+            while(true) {
+                auto d = program.at(pc);
+                // Bad targets are already reported by check_instruction
+                if (!d || !d->valid)
+                    break;
+
+                auto it = states.find(pc);
+                if (it != states.end()) {
+                    if (!(it->second == state))
+                        error(pc, "The stack depth differs between paths (" + describe(it->second) + " and " + describe(state) + ")");
+                    break;
+                }
+                states.emplace(pc, state);
+
+                if (!step(*d, state, pending))
+                    break;
+
+                pc += d->size;
+                if (pc >= program.get_code_size()) {
+                    error(d->pc, "The execution runs past the end of the code");
+                    break;
+                }
+            }
+        }
+    }
+
+    // Returns false when the path ends here
+    bool step(DecodedInstruction const& d, StackState& state, std::vector<std::pair<ui32, StackState>>& pending) {
+        if (program::writes_register(d, instruction::Register::PC.id)) {
+            warning(d.pc, "Writes to the program counter, the paths from here aren't checked");
+            return false;
+        }
+
+        if (program::writes_register(d, instruction::Register::SP.id)) {
+            if (state.frames.empty()) {
+                warning(d.pc, "Changes the stack outside of a frame, the paths from here aren't checked");
+                return false;
+            }
+            state.unknown = true;
+            return true;
+        }
+
+        if (d.wide)
+            return true;
+
+        switch(static_cast<Operations>(d.op)) {
+            case Operations::PUSH:
+                if (!state.unknown)
+                    ++state.depth;
+                return true;
+
+            case Operations::POP:
+                if (state.unknown)
+                    return true;
+                --state.depth;
+                if (state.depth < 0) {
+                    error(d.pc, "Pops the return address");
+                    return false;
+                }
+                if (!state.frames.empty() && state.depth <= state.frames.back()) {
+                    error(d.pc, "Pops the base pointer saved by ETR");
+                    return false;
+                }
+                return true;
+
+            case Operations::ETR:
+                if (state.unknown) {
+                    warning(d.pc, "Enters a frame with an unknown stack depth, the paths from here aren't checked");
+                    return false;
+                }
+                state.frames.push_back(state.depth);
+                ++state.depth;
+                return true;
+
+            case Operations::LVE:
+                if (state.frames.empty()) {
+                    error(d.pc, "LVE without a matching ETR");
+                    return false;
+                }
+                state.depth = state.frames.back();
+                state.frames.pop_back();
+                state.unknown = false;
+                return true;
+
+            case Operations::RET:
+                if (!state.frames.empty())
+                    error(d.pc, "Returns without leaving its frame");
+                else if (state.depth != 0)
+                    error(d.pc, "Returns with " + std::to_string(state.depth) + " word(s) left on the stack");
+                return false;
+
+            case Operations::HLT:
+                return false;
+
+            case Operations::CALL:
+                if (!program::has_static_target(d))
+                    warning(d.pc, "Indirect call, the callee isn't checked");
+                return true;
+
+            default:
+                break;
+        }
+
+        if (program::is_jump(d)) {
+            bool conditional = program::is_conditional_jump(d);
+            if (!program::has_static_target(d)) {
+                warning(d.pc, "Indirect jump, the paths from its target aren't checked");
+                return conditional;
+            }
+            if (!conditional) {
+                pending.push_back({ program::static_target_of(d), state });
+                return false;
+            }
+            pending.push_back({ program::static_target_of(d), state });
+        }
+
+        return true;
+    }
+
+    vcx::Executable const& exe;
+    program::Program const& program;
+    std::vector<Issue> issues;
+
+};
+
+}
+
+std::vector<Issue> verify(vcx::Executable const& exe, program::Program const& program) {
+    return Checker(exe, program).run();
+}
+
+bool has_errors(std::vector<Issue> const& issues) {
+    return std::any_of(issues.begin(), issues.end(), [] (Issue const& i) { return i.severity == Issue::Severity::Error; });
+}
+
+void print_issues(std::ostream& os, std::vector<Issue> const& issues, vcx::Executable const& exe) {
+    auto word_at = [&exe] (ui32 pc) { return pc / 4 < exe.code.size() ? exe.code[pc / 4] : 0; };
+    for(auto const& issue : issues) {
+        os << to_string(issue.severity) << " at " << std::setw(6) << issue.pc << " : ";
+        if (issue.pc / 4 < exe.code.size())
+            os << interpreter::instruction_to_string(word_at(issue.pc), word_at(issue.pc + 4), word_at(issue.pc + 8)) << " : ";
+        os << issue.message << '\n';
+    }
+}
+
+}}
@@ -0,0 +1,131 @@
+#include <vcrate/Benchmark/Benchmark.hpp>
+#include <vcrate/Benchmark/Kernels.hpp>
+#include <vcrate/Benchmark/Programs.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace vcrate;
+
+int main(int argc, char** argv) {
+    benchmark::Options options;
+    ui32 iterations = 100'000;
+    std::string filter = "";
+    std::string engine = "";
+    bool macro = false;
+    std::string export_folder = "";
+    std::string output_file = "";
+    std::string baseline_file = "";
+    f64 tolerance = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-r" || arg == "--repeat") && i + 1 < argc) {
+            options.repetitions = std::stoul(argv[++i]);
+        } else if ((arg == "-w" || arg == "--warmup") && i + 1 < argc) {
+            options.warmup = std::stoul(argv[++i]);
+        } else if ((arg == "-n" || arg == "--iterations") && i + 1 < argc) {
+            iterations = std::stoul(argv[++i]);
+        } else if ((arg == "-f" || arg == "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if ((arg == "-e" || arg == "--engine") && i + 1 < argc) {
+            engine = argv[++i];
+        } else if (arg == "-m" || arg == "--macro") {
+            macro = true;
+        } else if (arg == "--export" && i + 1 < argc) {
+            export_folder = argv[++i];
+        } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if ((arg == "-b" || arg == "--baseline") && i + 1 < argc) {
+            baseline_file = argv[++i];
+        } else if ((arg == "-t" || arg == "--tolerance") && i + 1 < argc) {
+            tolerance = std::stod(argv[++i]);
+        } else {
+            if (arg != "--help")
+                std::cout << "Argument not supported\n";
+            std::cout << "Usage: " << argv[0] << " [--help] [-r | --repeat <count>] [-w | --warmup <count>] "
+                      << "[-n | --iterations <count>] [-f | --filter <kernel substring>] [-e | --engine <name>] "
+                      << "[-m | --macro] [--export <folder>] [-o | --output <file>] "
+                      << "[-b | --baseline <file> [-t | --tolerance <percent>]]\n";
+            return arg != "--help";
+        }
+    }
+
+    if (options.repetitions == 0) {
+        std::cout << "At least one repetition is required\n";
+        return 1;
+    }
+
+    std::vector<benchmark::Result> baseline;
+    if (!baseline_file.empty()) {
+        std::ifstream is(baseline_file);
+        if (!is) {
+            std::cout << "File (" << baseline_file << ") couldn't be opened\n";
+            return 1;
+        }
+        auto loaded = benchmark::load_results(is);
+        if (!loaded) {
+            std::cout << "File (" << baseline_file << ") is not a benchmark result file\n";
+            return 1;
+        }
+        baseline = std::move(*loaded);
+    }
+
+    auto kernels = macro ? benchmark::macro_programs() : benchmark::micro_kernels(iterations);
+
+    if (!export_folder.empty()) {
+        for(auto const& kernel : kernels) {
+            auto file = export_folder + "/" + kernel.name + ".vcx";
+            std::ofstream os(file);
+            os << kernel.exe;
+            if (!os) {
+                std::cout << "File (" << file << ") couldn't be written\n";
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    std::vector<benchmark::Result> results;
+    for(auto const& kernel : kernels) {
+        if (kernel.name.find(filter) == std::string::npos)
+            continue;
+        for(auto const& e : benchmark::engines()) {
+            if (!engine.empty() && e.name != engine)
+                continue;
+            results.push_back(benchmark::measure(kernel, e, options));
+        }
+    }
+
+    if (results.empty()) {
+        std::cout << "Nothing matches the filters\n";
+        return 1;
+    }
+
+    benchmark::print_results(std::cout, results);
+
+    bool ok = true;
+    if (macro) {
+        std::cout << '\n';
+        ok = benchmark::print_comparison(std::cout, results);
+    }
+
+    if (!output_file.empty()) {
+        std::ofstream os(output_file);
+        benchmark::save_results(os, results);
+        if (!os) {
+            std::cout << "File (" << output_file << ") couldn't be written\n";
+            return 1;
+        }
+    }
+
+    if (!baseline_file.empty()) {
+        std::cout << '\n';
+        if (!benchmark::check_regressions(std::cout, baseline, results, tolerance / 100.))
+            ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include <iostream>
+
+#include <vcrate/Alias.hpp>
+#include <vcrate/Compiler/Compiler.hpp>
+#include <vcrate/Program/Compact.hpp>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace vcrate;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Require a file in argument\n";
+        return 1;
+    }
+
+    std::string file = "";
+    std::string output = "";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--help" || arg[0] == '-') {
+            if (arg != "--help")
+                std::cout << "Argument not supported\n";
+            std::cout << "Usage: " << argv[0] << " [--help] [-o <output>] <filename>\n";
+            return arg != "--help";
+        } else {
+            file = arg;
+        }
+    }
+
+    if (output.empty()) {
+        auto dot = file.rfind('.');
+        output = (dot == std::string::npos ? file : file.substr(0, dot)) + ".cpp";
+    }
+
+    std::ifstream is(file, std::ios::binary);
+    if (!is) {
+        std::cout << "File (" << file << ") couldn't be opened\n";
+        return 1;
+    }
+
+    auto exe = program::read_executable(is);
+    if (!exe) {
+        std::cout << "File (" << file << ") is not a valid executable\n";
+        return 1;
+    }
+
+    std::ofstream os(output);
+    if (!os) {
+        std::cout << "File (" << output << ") couldn't be opened\n";
+        return 1;
+    }
+
+    try {
+        compiler::compile(os, *exe);
+    } catch(std::exception const& e) {
+        std::cout << "File (" << file << ") couldn't be compiled: " << e.what() << '\n';
+        return 1;
+    }
+
+    std::cout << "Written to " << output << '\n';
+}
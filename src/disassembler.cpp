@@ -5,29 +5,31 @@
 #include <vcrate/Interpreter/Interpreter.hpp>
 #include <vcrate/instruction/Instruction.hpp>
 #include <vcrate/bytecode/Operations.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Program/Compact.hpp>
+#include <vcrate/Analysis/ControlFlowGraph.hpp>
+#include <vcrate/Disassembler/Disassembler.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+#include <vcrate/Coverage/Coverage.hpp>
+#include <vcrate/Replay/Replay.hpp>
 
+#include <algorithm>
 #include <fstream>
-#include <numeric>
 #include <sstream>
 #include <iomanip>
+#include <optional>
+#include <thread>
 
 using namespace vcrate::instruction;
 using namespace vcrate::interpreter;
 using namespace vcrate::vcx;
 using namespace vcrate;
 
-void box(std::string const& title, std::string const& content, ui32 column = 1) {
+void box(std::string const& title, std::vector<std::string> const& contents, ui32 column = 1) {
     ui32 max = title.size()+4;
     max += (column - (max - 1) % column) % column;
-    std::vector<std::string> contents;
-    {
-        std::stringstream ss(content); 
-        std::string s;
-        while(std::getline(ss, s, '\n')) {
-            contents.push_back(s);
-            max = std::max<ui32>((s.size() + 2 + 1) * column + 1, max);
-        }
-    }
+    for(auto const& s : contents)
+        max = std::max<ui32>((s.size() + 2 + 1) * column + 1, max);
 
     auto repeat = [] (ui32 n, auto s) {
         while(n--)
@@ -95,50 +97,115 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    std::string file = argv[1];
-    std::ifstream is(file);
+    std::string file = "";
+    std::string cfg_file = "";
+    std::string coverage_file = "";
+    bool plain = false;
+    ui32 workers = std::max(std::thread::hardware_concurrency(), 1u);
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cfg" && i + 1 < argc) {
+            cfg_file = argv[++i];
+        } else if (arg == "--coverage" && i + 1 < argc) {
+            coverage_file = argv[++i];
+        } else if (arg == "--plain") {
+            plain = true;
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = std::stoul(argv[++i]);
+        } else if (arg == "--help" || arg[0] == '-') {
+            if (arg != "--help")
+                std::cout << "Argument not supported\n";
+            std::cout << "Usage: " << argv[0] << " [--help] [--cfg <graphviz file>] [--coverage <file>] [--plain] [--workers <count>] <filename>\n";
+            return arg != "--help";
+        } else {
+            file = arg;
+        }
+    }
+
+    std::ifstream is(file, std::ios::binary);
 
     if (!is) {
         std::cout << "File (" << file << ") couldn't be opened\n";
         return 1;
     }
     
-    Executable exe;
-    is >> exe;
+    bool compact = program::is_compact(is);
+    auto loaded = program::read_executable(is);
     is.close();
+    if (!loaded) {
+        std::cout << "File (" << file << ") is not a valid executable\n";
+        return 1;
+    }
+    Executable exe = std::move(*loaded);
+
+    if (!cfg_file.empty()) {
+        program::Program program(exe);
+        analysis::ControlFlowGraph cfg(exe, program);
+        std::ofstream os(cfg_file);
+        cfg.to_dot(os, exe);
+        if (!os) {
+            std::cout << "File (" << cfg_file << ") couldn't be written\n";
+            return 1;
+        }
+    }
+
+    // Overlaid on the instructions, it must be of this executable
+    std::optional<coverage::Coverage> coverage;
+    if (!coverage_file.empty()) {
+        std::ifstream cis(coverage_file, std::ios::binary);
+        coverage = coverage::Coverage::load(cis);
+        if (!coverage) {
+            std::cout << "File (" << coverage_file << ") is not a valid coverage\n";
+            return 1;
+        }
+        if (coverage->get_executable_hash() != replay::hash_of(exe)) {
+            std::cout << "File (" << coverage_file << ") is the coverage of another executable\n";
+            return 1;
+        }
+    }
+
+    // Written as it's decoded, there is no box to measure
+    if (plain) {
+        disassembler::write_plain(std::cout, exe, workers, coverage ? &*coverage : nullptr);
+        return 0;
+    }
+
+    std::stringstream compact_form;
+    program::write_compact(compact_form, exe);
 
     constexpr ui32 size = 45;
 
     std::cout << "\033[1m" << "Executable (" << file << ")" << ":\033[22m\n";
-    box("Header (16 bytes)", 
-        left_right_text(size, "Entry point",  std::to_string(exe.entry_point), '.')                          + '\n' +
-        left_right_text(size, "Symbols",      std::to_string(get_symbols_size(exe.symbols)) + " bytes", '.') + '\n' +
-        left_right_text(size, "Jump table",   std::to_string(exe.jmp_table.size()*4) + " bytes", '.')        + '\n' +
-        left_right_text(size, "Data",         std::to_string(exe.data.size()*4) + " bytes", '.')             + '\n' +
-        left_right_text(size, "Instructions", std::to_string(exe.code.size()*4) + " bytes", '.')             + '\n'
-    );
+    box("Header (16 bytes)", {
+        left_right_text(size, "Entry point",  std::to_string(exe.entry_point), '.'),
+        left_right_text(size, "Symbols",      std::to_string(get_symbols_size(exe.symbols)) + " bytes", '.'),
+        left_right_text(size, "Jump table",   std::to_string(exe.jmp_table.size()*4) + " bytes", '.'),
+        left_right_text(size, "Data",         std::to_string(exe.data.size()*4) + " bytes", '.'),
+        left_right_text(size, "Instructions", std::to_string(exe.code.size()*4) + " bytes", '.'),
+        left_right_text(size, "Format",       compact ? "compact" : "standard", '.'),
+        left_right_text(size, "Compact form", std::to_string(compact_form.str().size()) + " bytes", '.')
+    });
 
     {
-        std::string sym;
+        std::vector<std::string> sym;
         for(auto const& p : exe.symbols)
-            sym += left_right_text(size, p.first, std::to_string(p.second), '.') + '\n';
+            sym.push_back(left_right_text(size, p.first, std::to_string(p.second), '.'));
         if (sym.empty())
-            sym = std::string(size, ' ');
+            sym.push_back(std::string(size, ' '));
         box("Symbols (" + std::to_string(exe.symbols.size()) + ")", sym);
     }
 
     {
-        std::string jmp = std::accumulate(std::begin(exe.jmp_table), std::end(exe.jmp_table), std::string{}, 
-        [] (std::string const& acc, ui32 s1) {
-            return acc + std::to_string(s1) + '\n';
-        });
+        std::vector<std::string> jmp;
+        for(auto target : exe.jmp_table)
+            jmp.push_back(std::to_string(target));
         if (jmp.empty())
-            jmp = std::string((size - 4) / 3, ' ');
+            jmp.push_back(std::string((size - 4) / 3, ' '));
         box(center(size, "Jump table (" + std::to_string(exe.jmp_table.size()) + ")"), jmp, 3);
     }
 
     {
-        std::string datas;
+        std::vector<std::string> datas;
         std::string hex;
         std::string chr;
         ui32 packet = 0;
@@ -157,36 +224,40 @@ int main(int argc, char** argv) {
 
             if (++packet > 1) {
                 packet = 0;
-                datas += left_right_text(size, hex, chr) + '\n';
+                datas.push_back(left_right_text(size, hex, chr));
                 hex = chr = "";
             }
         }
         if (!hex.empty())
-            datas += left_right_text(size, hex, chr + "    ") + '\n';
+            datas.push_back(left_right_text(size, hex, chr + "    "));
         if (datas.empty())
-            datas = std::string(size, ' ');
+            datas.push_back(std::string(size, ' '));
 
         box("Data (" + std::to_string(exe.data.size() * 4) + " bytes)", datas);
     }
     
     {
+        // The box is measured on its widest line, so the lines are kept until the last one is decoded
+        std::vector<std::string> insn;
         ui32 instruction_count = 0;
-        std::string insn;
-        for(ui32 pc = 0; pc < exe.code.size();) {
-            ui32 extra0 = pc + 1 < exe.code.size() ? exe.code[pc+1] : 0;
-            ui32 extra1 = pc + 2 < exe.code.size() ? exe.code[pc+2] : 0;
-            Instruction isn(exe.code[pc], extra0, extra1);
-
-            if (pc*4 == exe.entry_point)
-                insn += isn.to_string() + " *\n";
-            else
-                insn += isn.to_string() + '\n';
-
-            instruction_count++;
-            pc += isn.get_byte_size() / 4;
-        }
+        program::SymbolIndex symbols(exe);
+        disassembler::disassemble(exe, [&] (disassembler::Line const& line) {
+            // A symbol gets a line of its own
+            if (auto symbol = symbols.at(line.pc))
+                insn.push_back(symbol->name + ":");
+            std::string text = line.pc == exe.entry_point ? line.text + " *" : line.text;
+            // Executed instructions are marked with a +, missed ones with a -, conditional jumps tell their directions
+            if (coverage) {
+                std::string covered = disassembler::coverage_of(*coverage, line);
+                text = (covered == "missed" ? "- " : "+ ") + text;
+                if (line.conditional_jump && covered != "missed")
+                    text += " [" + covered + "]";
+            }
+            insn.push_back(text);
+            ++instruction_count;
+        }, workers);
         if (insn.empty())
-            insn = std::string((size - 3) / 2, ' ');
+            insn.push_back(std::string((size - 3) / 2, ' '));
         box(center(size, "Instructions (" + std::to_string(instruction_count) + ")"), insn, 2);
     }
 }
\ No newline at end of file
@@ -1,21 +1,40 @@
 #include <vcrate/Sandbox/SandBox.hpp>
 #include <vcrate/Interpreter/Interpreter.hpp>
+#include <vcrate/Interpreter/VerifiedInterpreter.hpp>
 #include <vcrate/bytecode/Operations.hpp>
 #include <vcrate/vcx/Executable.hpp>
+#include <vcrate/Profiler/Profiler.hpp>
+#include <vcrate/Trace/Trace.hpp>
+#include <vcrate/Replay/Replay.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Program/Compact.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+#include <vcrate/Compiler/NativeProgram.hpp>
+#include <vcrate/Server/Server.hpp>
+#include <vcrate/Cache/DiskCache.hpp>
+#include <vcrate/Batch/Batch.hpp>
+#include <vcrate/Debugger/Debugger.hpp>
+#include <vcrate/Sanitizer/Sanitizer.hpp>
+#include <vcrate/Coverage/Coverage.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <bitset>
 #include <cstdlib>
 #include <ctime>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
 
 using namespace vcrate::interpreter;
 using namespace vcrate;
 
 int main(int argc, char** argv) {
-    std::srand(std::time(nullptr));
-
     if (argc < 2) {
         std::cout << "Require a file in argument\n";
         return 1;
@@ -23,49 +42,382 @@ int main(int argc, char** argv) {
 
     std::string file = "";
     bool print_instructions = false;
-    bool wait_after_instructions = false;
+    bool debug = false;
+    bool profile = false;
+    std::string folded_file = "";
+    ui32 sample_period = 1000;
+    std::string trace_file = "";
+    std::string record_file = "";
+    std::string replay_file = "";
+    ui64 seek = 0;
+    std::string metrics_file = "";
+    bool verify = false;
+    bool sanitize = false;
+    std::string coverage_file = "";
+    std::string native_file = "";
+    std::string trap_handler = "";
+    std::string serve_socket = "";
+    ui32 workers = std::max(std::thread::hardware_concurrency(), 1u);
+    std::optional<ui32> max_memory;
+    std::string client_socket = "";
+    std::string input_file = "";
+    ui64 limit = 0;
+    std::string cache_directory = "";
+    std::string batch_inputs = "";
+    std::string batch_output = "";
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "-v" || arg == "--verbose") {
             print_instructions = true;
         } else if (arg == "-d" || arg == "--debug") {
-            wait_after_instructions = true;
+            debug = true;
+        } else if (arg == "-p" || arg == "--profile") {
+            profile = true;
+        } else if ((arg == "--profile-folded" || arg == "--profile-period") && i + 1 < argc) {
+            profile = true;
+            if (arg == "--profile-folded")
+                folded_file = argv[++i];
+            else
+                sample_period = std::stoul(argv[++i]);
+        } else if ((arg == "-t" || arg == "--trace") && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if ((arg == "-m" || arg == "--metrics") && i + 1 < argc) {
+            metrics_file = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_file = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else if (arg == "--native" && i + 1 < argc) {
+            native_file = argv[++i];
+        } else if (arg == "--trap-handler" && i + 1 < argc) {
+            trap_handler = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serve_socket = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = std::stoul(argv[++i]);
+        } else if (arg == "--max-memory" && i + 1 < argc) {
+            max_memory = std::stoul(argv[++i]);
+        } else if (arg == "--client" && i + 1 < argc) {
+            client_socket = argv[++i];
+        } else if (arg == "--input" && i + 1 < argc) {
+            input_file = argv[++i];
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = std::stoull(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch_inputs = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            batch_output = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_directory = argv[++i];
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (arg == "--sanitize") {
+            sanitize = true;
+        } else if (arg == "--coverage" && i + 1 < argc) {
+            coverage_file = argv[++i];
+        } else if (arg == "--seek" && i + 1 < argc) {
+            seek = std::stoull(argv[++i]);
         } else if (arg == "--help" || arg[0] == '-') {
             if (arg != "--help")
                 std::cout << "Argument not supported\n";
-            std::cout << "Usage: " << argv[0] << " [--help] [-v | --verbose] <filename>\n";
+            std::cout << "Usage: " << argv[0] << " [--help] [-v | --verbose] [-d | --debug] [-p | --profile] "
+                      << "[--profile-folded <file>] [--profile-period <instructions>] [-t | --trace <file>] "
+                      << "[--record <file> | --replay <file> [--seek <instruction>]] [-m | --metrics <file | ->] [--verify] [--sanitize] [--coverage <file>] [--native <shared object>] [--trap-handler <symbol>] [--cache <directory>] <filename>\n"
+                      << "       " << argv[0] << " --serve <socket> [--workers <count>] [--max-memory <bytes>] [--cache <directory>]\n"
+                      << "       " << argv[0] << " --client <socket> [--input <file>] [--limit <instructions>] <filename>\n"
+                      << "       " << argv[0] << " --batch <file | directory> --output <directory | -> [--workers <count>] [--limit <instructions>] [--cache <directory>] [--coverage <file>] <filename>\n";
             return arg != "--help";
         } else {
             file = arg;
         }
     }
 
-    std::ifstream is(file);
+    // What a run covered is or-ed into the coverage already in the file, so runs add up
+    auto write_coverage = [&coverage_file] (coverage::Coverage covered, vcx::Executable const& exe, std::ostream& log) {
+        if (std::ifstream is{ coverage_file, std::ios::binary }) {
+            auto previous = coverage::Coverage::load(is);
+            if (!previous) {
+                log << "File (" << coverage_file << ") is not a coverage\n";
+                return false;
+            }
+            if (!covered.merge(*previous)) {
+                log << "File (" << coverage_file << ") holds the coverage of another executable\n";
+                return false;
+            }
+        }
+        std::ofstream os(coverage_file, std::ios::binary);
+        covered.save(os);
+        if (!os) {
+            log << "File (" << coverage_file << ") couldn't be written\n";
+            return false;
+        }
+        auto summary = covered.summarize(program::Program(exe));
+        log << "Coverage : " << summary.executed << " / " << summary.instructions << " instructions, "
+            << summary.directions_covered << " / " << summary.directions << " branch directions\n";
+        return true;
+    };
+
+    // Runs requests until killed, the executables come with them
+    if (!serve_socket.empty()) {
+        server::Options options;
+        options.socket_path = serve_socket;
+        options.workers = workers;
+        if (max_memory)
+            options.max_memory_size = *max_memory;
+        options.cache_directory = cache_directory;
+        server::Server server(options);
+        return server.serve(std::cout) ? 0 : 1;
+    }
+
+    // Every input runs in this process, on the executable loaded once
+    if (!batch_inputs.empty()) {
+        batch::InputReader inputs(batch_inputs);
+        if (!inputs.is_open()) {
+            std::cout << "File (" << batch_inputs << ") couldn't be read\n";
+            return 1;
+        }
+        batch::ResultWriter writer(batch_output.empty() ? "-" : batch_output);
+        if (!writer.is_open()) {
+            std::cout << "Directory (" << batch_output << ") couldn't be written\n";
+            return 1;
+        }
+        server::Options options;
+        options.workers = workers;
+        options.cache_directory = cache_directory;
+        server::Server server(options);
+        coverage::Coverage covered;
+        auto summary = batch::run(server, std::filesystem::absolute(file).string(), inputs, writer, workers, limit,
+                                  coverage_file.empty() ? nullptr : &covered);
+        // The results may be on std::cout
+        std::cerr << summary.runs << " runs, " << summary.failures << " didn't halt\n";
+        if (!writer.good()) {
+            std::cerr << "Results couldn't be written\n";
+            return 1;
+        }
+        if (!coverage_file.empty() && !covered.is_empty()) {
+            std::ifstream is(file, std::ios::binary);
+            auto exe = program::read_executable(is);
+            if (!exe || !write_coverage(std::move(covered), *exe, std::cerr))
+                return 1;
+        }
+        return summary.failures > 0;
+    }
+
+    // The server reads the file, from its own working directory
+    if (!client_socket.empty()) {
+        server::Request request;
+        request.path = std::filesystem::absolute(file).string();
+        request.max_instructions = limit;
+        if (!input_file.empty()) {
+            std::ifstream is(input_file, std::ios::binary);
+            if (!is) {
+                std::cout << "File (" << input_file << ") couldn't be opened\n";
+                return 1;
+            }
+            request.input.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+        }
+        auto response = server::send(client_socket, request);
+        if (!response) {
+            std::cout << "Server (" << client_socket << ") couldn't be reached\n";
+            return 1;
+        }
+        std::cout << response->output;
+        std::cout << "Halt code : " << response->halt_code << '\n';
+        std::cout << "Instructions : " << response->instructions << '\n';
+        if (response->status != server::Status::Halted) {
+            std::cout << "Status : " << server::to_string(response->status);
+            if (!response->message.empty())
+                std::cout << " (" << response->message << ')';
+            std::cout << '\n';
+        }
+        return response->status == server::Status::Halted ? 0 : 1;
+    }
+
+    std::ifstream is(file, std::ios::binary);
 
     if (!is) {
         std::cout << "File (" << file << ") couldn't be opened\n";
         return 1;
     }
     
-    vcx::Executable exe;
-    is >> exe;
+    // With a cache, a file already run is neither parsed nor decoded again
+    std::optional<cache::Prepared> prepared;
+    std::optional<vcx::Executable> loaded;
+    if (!cache_directory.empty()) {
+        std::string contents(std::istreambuf_iterator<char>(is), {});
+        prepared = cache::DiskCache(cache_directory).prepare(contents);
+        if (prepared)
+            loaded = std::move(prepared->exe);
+    } else {
+        loaded = program::read_executable(is);
+    }
     is.close();
+    if (!loaded) {
+        std::cout << "File (" << file << ") is not a valid executable\n";
+        return 1;
+    }
+    auto exe = std::move(*loaded);
+
+    if (!trap_handler.empty() && exe.symbols.count(trap_handler) == 0) {
+        std::cout << "Symbol (" << trap_handler << ") not found\n";
+        return 1;
+    }
+
+    replay::Recording recording;
+    recording.executable_hash = replay::hash_of(exe);
+    recording.seed = std::time(nullptr);
+    recording.memory_size = 1 << 24;
+    if (!trap_handler.empty())
+        recording.trap_handler = exe.symbols.at(trap_handler);
+
+    if (!replay_file.empty()) {
+        std::ifstream is(replay_file, std::ios::binary);
+        auto loaded = replay::Recording::load(is);
+        if (!loaded) {
+            std::cout << "File (" << replay_file << ") is not a recording\n";
+            return 1;
+        }
+        if (loaded->executable_hash != recording.executable_hash) {
+            std::cout << "File (" << replay_file << ") wasn't recorded with this executable\n";
+            return 1;
+        }
+        if (!trap_handler.empty() && loaded->trap_handler != recording.trap_handler) {
+            std::cout << "File (" << replay_file << ") wasn't recorded with this trap handler\n";
+            return 1;
+        }
+        recording = *loaded;
+    }
+
+    // A verified program runs on the VerifiedInterpreter
+    std::optional<program::Program> program;
+    if (verify && prepared && prepared->verified) {
+        program.emplace(std::move(prepared->program));
+    } else if (verify) {
+        program.emplace(exe);
+        auto issues = verifier::verify(exe, *program);
+        verifier::print_issues(std::cout, issues, exe);
+        if (verifier::has_errors(issues)) {
+            std::cout << "File (" << file << ") doesn't pass the verifier\n";
+            return 1;
+        }
+    }
+
+    // A compiled program runs natively, there is no instruction to look at in between
+    std::unique_ptr<compiler::NativeProgram> native;
+    if (!native_file.empty()) {
+        if (print_instructions || debug || profile || !trace_file.empty() || seek > 0) {
+            std::cout << "A native program can't be run instruction by instruction\n";
+            return 1;
+        }
+        native = std::make_unique<compiler::NativeProgram>(native_file);
+        if (!native->is_loaded()) {
+            std::cout << "File (" << native_file << ") couldn't be loaded: " << native->get_error() << '\n';
+            return 1;
+        }
+        if (!native->is_compiled_from(exe)) {
+            std::cout << "File (" << native_file << ") wasn't compiled from this executable\n";
+            return 1;
+        }
+    }
+
+    // The sanitizer is an engine of its own, the program runs on it from the start to the halt
+    if (sanitize && (native || debug || profile || !trace_file.empty() || seek > 0)) {
+        std::cout << "The sanitizer can't be used with a native program, the debugger, the profiler, a trace or a seek\n";
+        return 1;
+    }
+    // Collected by the loop below, which neither of them goes through
+    if (!coverage_file.empty() && (native || sanitize || debug)) {
+        std::cout << "Coverage can't be collected with a native program, the sanitizer or the debugger\n";
+        return 1;
+    }
+
+    std::srand(recording.seed);
 
-    SandBox sandbox(1 << 24);
+    SandBox sandbox(recording.memory_size);
     sandbox.load_executable(exe);
 
+    std::optional<profiler::Profiler> profiler;
+    if (profile)
+        profiler.emplace(exe, sample_period);
+
+    std::optional<coverage::Coverage> coverage;
+    if (!coverage_file.empty())
+        coverage.emplace(exe);
+
+    std::unique_ptr<trace::TraceWriter> trace;
+    if (!trace_file.empty()) {
+        trace = std::make_unique<trace::TraceWriter>(trace_file);
+        if (!trace->is_open()) {
+            std::cout << "File (" << trace_file << ") couldn't be opened\n";
+            return 1;
+        }
+    }
+
     auto chrono_start = std::chrono::high_resolution_clock::now();
     std::cout << "# Start #" << std::endl;
 
-    while(!sandbox.is_halted() && sandbox.get_pc() < 100) {
-        auto is = Interpreter::fetch_instruction(sandbox);
+    // The code is decoded once, unless the program writes to it
+    DecodeCache cache(exe);
+    Counters counters(sandbox);
+    counters.trap_handler = recording.trap_handler;
+    // The size of each block is only followed for the metrics
+    if (!metrics_file.empty())
+        counters.track_heap();
+    // The replayer runs with the trap handler of the recording too
+    if (seek > 0) {
+        replay::Replayer replayer(exe, recording);
+        if (!metrics_file.empty())
+            replayer.get_counters().track_heap();
+        replayer.seek(seek);
+        sandbox = replayer.get_sandbox();
+        counters = replayer.get_counters();
+    }
+
+    if (native)
+        native->run(sandbox, counters);
+
+    std::optional<sanitizer::Sanitizer> sanitizer;
+    if (sanitize) {
+        sanitizer.emplace(exe, sandbox);
+        sanitizer->run(sandbox, counters);
+    }
+
+    // Until the debugger is quit or its input ends, then the program goes on as without it
+    if (debug) {
+        debugger::Debugger debugger(exe, sandbox, counters);
+        debugger.repl(std::cin, std::cout);
+    }
+
+    // Without anything to look at each instruction, the engines run their own loop, fused steps included
+    if (!print_instructions && !trace && !profiler && !coverage && !sandbox.is_halted()) {
+        if (program)
+            VerifiedInterpreter::run(*program, sandbox, counters);
+        else
+            Interpreter::run(sandbox, counters, cache);
+    }
+
+    while(!sandbox.is_halted()) {
+        if (print_instructions) {
+            auto pc = sandbox.get_pc();
+            auto is = instruction_to_string(sandbox.get_memory_at(pc), sandbox.get_memory_at(pc + 4), sandbox.get_memory_at(pc + 8));
+            std::cout << "\033[31m\033[1m< " << pc << " : " << is << " >\033[0m"; 
+        }
+        if (trace)
+            trace->record(sandbox);
+        if (profiler)
+            profiler->before(sandbox);
+        if (coverage)
+            coverage->before(sandbox);
+        if (program)
+            VerifiedInterpreter::run_next_instruction(*program, sandbox, counters);
+        else
+            Interpreter::run_next_instruction(sandbox, counters, cache);
+        if (profiler)
+            profiler->after(sandbox);
+        if (coverage)
+            coverage->after(sandbox);
         if (print_instructions)
-            std::cout << "\033[31m\033[1m< " << sandbox.get_pc() << " : " << is.to_string() << " >\033[0m"; 
-        Interpreter::run_next_instruction(sandbox);
-        if (wait_after_instructions)
-            std::cin.get();
-        else if (print_instructions)
             std::cout << '\n';
     }
 
@@ -74,5 +426,56 @@ int main(int argc, char** argv) {
     auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
     std::cout << "Duration : " << nanos / 1'000'000. << " ms (" << nanos / 1'000'000'000. << " s)\n";
     std::cout << "Halt code : " << sandbox.get_register(0) << '\n';
+    if (counters.traps > 0)
+        std::cout << "Trap : " << to_string(counters.trap.code) << " at " << counters.trap.pc << " in " << program::SymbolIndex(exe).location_of(counters.trap.pc)
+                  << " (" << counters.traps << " in total)\n";
+    if (sanitizer) {
+        sanitizer->report(std::cout);
+        std::cout << "Sanitizer : " << sanitizer->get_reports().size() << " faults\n";
+    }
+
+    if (metrics_file == "-") {
+        std::cout << counters.to_json() << '\n';
+    } else if (!metrics_file.empty()) {
+        std::ofstream os(metrics_file);
+        os << counters.to_json() << '\n';
+        if (!os) {
+            std::cout << "File (" << metrics_file << ") couldn't be written\n";
+            return 1;
+        }
+    }
+
+    if (!record_file.empty()) {
+        recording.instructions = counters.instructions;
+        recording.halt_code = sandbox.get_register(0);
+        std::ofstream os(record_file, std::ios::binary);
+        recording.save(os);
+        if (!os) {
+            std::cout << "File (" << record_file << ") couldn't be written\n";
+            return 1;
+        }
+    }
+
+    if (!replay_file.empty() && (counters.instructions != recording.instructions || sandbox.get_register(0) != recording.halt_code)) {
+        std::cout << "Replay diverged : " << counters.instructions << " instructions (" << recording.instructions << " recorded), "
+                  << "halt code " << sandbox.get_register(0) << " (" << recording.halt_code << " recorded)\n";
+        return 1;
+    }
+
+    if (coverage && !write_coverage(std::move(*coverage), exe, std::cout))
+        return 1;
+
+    if (profiler) {
+        std::cout << '\n';
+        profiler->report(std::cout);
+        if (!folded_file.empty()) {
+            std::ofstream os(folded_file);
+            if (!os) {
+                std::cout << "File (" << folded_file << ") couldn't be opened\n";
+                return 1;
+            }
+            profiler->folded_stacks(os);
+        }
+    }
 
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <iostream>
+
+#include <vcrate/Alias.hpp>
+#include <vcrate/Optimizer/Optimizer.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Program/Compact.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+#include <vcrate/vcx/Executable.hpp>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace vcrate::optimizer;
+using namespace vcrate;
+
+bool passes_verifier(vcx::Executable const& exe) {
+    program::Program program(exe);
+    return !verifier::has_errors(verifier::verify(exe, program));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Require a file in argument\n";
+        return 1;
+    }
+
+    std::string file = "";
+    std::string output = "";
+    Options options;
+    bool compact = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--compact") {
+            compact = true;
+        } else if (arg == "--no-fold") {
+            options.fold_constants = false;
+        } else if (arg == "--no-dce") {
+            options.eliminate_dead_code = false;
+        } else if (arg == "--no-thread") {
+            options.thread_jumps = false;
+        } else if (arg == "--no-moves") {
+            options.remove_redundant_moves = false;
+        } else if (arg == "--no-strength") {
+            options.reduce_strength = false;
+        } else if (arg == "--help" || arg[0] == '-') {
+            if (arg != "--help")
+                std::cout << "Argument not supported\n";
+            std::cout << "Usage: " << argv[0] << " [--help] [-o <output>] [--compact] [--no-fold] [--no-dce] [--no-thread] [--no-moves] [--no-strength] <filename>\n";
+            return arg != "--help";
+        } else {
+            file = arg;
+        }
+    }
+
+    if (output.empty()) {
+        auto dot = file.rfind('.');
+        output = (dot == std::string::npos ? file : file.substr(0, dot)) + ".opt.vcx";
+    }
+
+    std::ifstream is(file, std::ios::binary);
+    if (!is) {
+        std::cout << "File (" << file << ") couldn't be opened\n";
+        return 1;
+    }
+
+    auto loaded = program::read_executable(is);
+    if (!loaded) {
+        std::cout << "File (" << file << ") is not a valid executable\n";
+        return 1;
+    }
+    auto const& exe = *loaded;
+
+    Statistics statistics;
+    vcx::Executable optimized;
+    try {
+        optimized = optimize(exe, options, statistics);
+    } catch(std::exception const& e) {
+        std::cout << "File (" << file << ") couldn't be optimized: " << e.what() << '\n';
+        return 1;
+    }
+
+    // An optimization must never turn a sound executable into one the verifier rejects
+    if (passes_verifier(exe) && !passes_verifier(optimized)) {
+        std::cout << "The optimized executable doesn't pass the verifier anymore, nothing written\n";
+        return 1;
+    }
+
+    std::ofstream os(output, std::ios::binary);
+    if (!os) {
+        std::cout << "File (" << output << ") couldn't be opened\n";
+        return 1;
+    }
+    if (compact)
+        program::write_compact(os, optimized);
+    else
+        os << optimized;
+
+    statistics.print(std::cout);
+    std::cout << "Written to " << output << '\n';
+}
@@ -3,14 +3,47 @@
 #include <vcrate/bytecode/Operations.hpp>
 
 #include <vcrate/bytecode/v1.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/Program/Program.hpp>
+#include <vcrate/Verifier/Verifier.hpp>
+#include <vcrate/Optimizer/Optimizer.hpp>
+#include <vcrate/Program/Compact.hpp>
+#include <vcrate/Interpreter/DecodeCache.hpp>
+#include <vcrate/Interpreter/VerifiedInterpreter.hpp>
+#include <vcrate/Interpreter/Counters.hpp>
+#include <vcrate/Benchmark/Builder.hpp>
+#include <vcrate/Pool/SandBoxPool.hpp>
+#include <vcrate/Benchmark/Kernels.hpp>
+#include <vcrate/Benchmark/Programs.hpp>
+#include <vcrate/Server/Server.hpp>
+#include <vcrate/Cache/DiskCache.hpp>
+#include <vcrate/Batch/Batch.hpp>
+#include <vcrate/Disassembler/Disassembler.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+#include <vcrate/Debugger/Debugger.hpp>
+#include <vcrate/Sanitizer/Sanitizer.hpp>
+#include <vcrate/Coverage/Coverage.hpp>
+#include <vcrate/Replay/Replay.hpp>
+#include <vcrate/Compiler/Compiler.hpp>
+#include <vcrate/Compiler/NativeProgram.hpp>
+#include <vcrate/Analysis/ControlFlowGraph.hpp>
+#include <vcrate/Profiler/Profiler.hpp>
+#include <vcrate/Trace/Trace.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <bitset>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <optional>
 #include <limits>
+#include <map>
+#include <sstream>
+#include <vector>
 
 using namespace vcrate;
 using namespace vcrate::bytecode;
@@ -313,6 +346,1263 @@ bool test_instruction_equals(bin_to_inst const& bin, interm_to_inst const& inter
     return correct;
 }
 
+bool test_wide_instruction(WideInstruction const& inst) {
+    bin_to_inst bin { inst.get_main_instruction(), std::nullopt, std::nullopt };
+    if (inst.get_byte_size() > sizeof(ui32))
+        bin.extra0 = inst.get_first_extra();
+    if (inst.get_byte_size() > 2 * sizeof(ui32))
+        bin.extra1 = inst.get_second_extra();
+
+    try {
+
+        WideInstruction from_bin(bin.base, bin.extra0.value_or(0), bin.extra1.value_or(0));
+        if (from_bin.get_operation() != inst.get_operation() || from_bin.to_string() != inst.to_string()) {
+            error_header();
+            print_bin(bin);
+            std::cout << " gives <" << from_bin.to_string() << "> but <" << inst.to_string() << "> was expected\n";
+            return false;
+        }
+        if (from_bin.get_byte_size() != inst.get_byte_size()) {
+            error_header();
+            print_bin(bin);
+            std::cout << " is " << from_bin.get_byte_size() << " bytes but " << inst.get_byte_size() << " was expected\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        print_bin(bin);
+        std::cout << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << "<" << inst.to_string() << "> => ";
+    print_bin(bin);
+    std::cout << "\n";
+    return true;
+}
+
+vcx::Executable executable_of(std::vector<Instruction> const& code) {
+    vcx::Executable exe;
+    exe.entry_point = 0;
+    for(auto const& i : code) {
+        exe.code.push_back(i.get_main_instruction());
+        if (i.get_byte_size() > sizeof(ui32))
+            exe.code.push_back(i.get_first_extra());
+        if (i.get_byte_size() > 2 * sizeof(ui32))
+            exe.code.push_back(i.get_second_extra());
+    }
+    return exe;
+}
+
+bool test_verifier(std::string const& name, std::vector<Instruction> const& code, bool rejected) {
+    auto exe = executable_of(code);
+
+    try {
+
+        auto issues = verifier::verify(exe, program::Program(exe));
+        if (verifier::has_errors(issues) != rejected) {
+            error_header();
+            std::cout << name << (rejected ? " was accepted\n" : " was rejected\n");
+            verifier::print_issues(std::cout, issues, exe);
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << (rejected ? " is rejected\n" : " is accepted\n");
+    return true;
+}
+
+ui32 halt_code_of(vcx::Executable const& exe) {
+    SandBox sandbox(1 << 16);
+    sandbox.load_executable(exe);
+    interpreter::Counters counters(sandbox);
+    Interpreter::run(sandbox, counters);
+    return sandbox.get_register(0);
+}
+
+// The optimized code must halt with the same code and be at most `max_instructions` long
+bool test_optimizer(std::string const& name, std::vector<Instruction> const& code, ui32 max_instructions) {
+    auto exe = executable_of(code);
+
+    try {
+
+        optimizer::Statistics statistics;
+        auto optimized = optimizer::optimize(exe, optimizer::Options{}, statistics);
+        auto instructions = program::Program(optimized).get_instructions().size();
+        auto expected = halt_code_of(exe);
+        auto result = halt_code_of(optimized);
+        if (result != expected || instructions > max_instructions) {
+            error_header();
+            std::cout << name << " halts with " << result << " instead of " << expected
+                      << " in " << instructions << " instructions (" << max_instructions << " expected)\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " is optimized\n";
+    return true;
+}
+
+// `exe` depends on the address of its instructions in a way the optimizer can't follow, it must be refused
+bool test_optimizer_refuses(std::string const& name, vcx::Executable const& exe) {
+    try {
+
+        optimizer::Statistics statistics;
+        auto optimized = optimizer::optimize(exe, optimizer::Options{}, statistics);
+        error_header();
+        std::cout << name << " is optimized, halting with " << halt_code_of(optimized) << " instead of " << halt_code_of(exe) << "\n";
+        return false;
+
+    } catch(std::runtime_error const& e) {
+        good_header();
+        std::cout << name << " is refused: " << e.what() << "\n";
+        return true;
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool test_compact(std::string const& name, vcx::Executable const& exe) {
+    try {
+
+        std::stringstream ss;
+        program::write_compact(ss, exe);
+        auto read = program::read_compact(ss);
+        if (!read || read->entry_point != exe.entry_point || read->symbols != exe.symbols
+            || read->jmp_table != exe.jmp_table || read->data != exe.data || read->code != exe.code) {
+            error_header();
+            std::cout << name << " doesn't read back the same\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " reads back the same\n";
+    return true;
+}
+
+// The program halts with `expected` with or without a DecodeCache
+bool test_decode_cache(std::string const& name, std::vector<Instruction> const& code, ui32 expected) {
+    auto exe = executable_of(code);
+
+    try {
+
+        SandBox sandbox(1 << 16);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        DecodeCache cache(exe);
+        Interpreter::run(sandbox, counters, cache);
+        auto cached = sandbox.get_register(0);
+        auto uncached = halt_code_of(exe);
+        if (cached != expected || uncached != expected) {
+            error_header();
+            std::cout << name << " halts with " << cached << " cached and " << uncached << " uncached instead of " << expected << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " halts with " << expected << "\n";
+    return true;
+}
+
+// Runs `ADD A, 1` once then patches it into `ADD A, 5`, of the same size, and runs it again
+std::vector<Instruction> self_modifying_code() {
+    Instruction original(Operations::ADD, Register::A, Value(1));
+    Instruction patched(Operations::ADD, Register::A, Value(5));
+    ui32 old_words[3] = { original.get_main_instruction(), original.get_first_extra(), original.get_second_extra() };
+    ui32 new_words[3] = { patched.get_main_instruction(), patched.get_first_extra(), patched.get_second_extra() };
+
+    std::vector<Instruction> code { Instruction(Operations::MOV, Register::B, Value(2)) };
+    ui32 loop = code[0].get_byte_size();
+    code.push_back(original);
+    for(ui32 w = 0; w < original.get_byte_size() / 4; ++w)
+        if (old_words[w] != new_words[w])
+            code.push_back(Instruction(Operations::MOV, Address(loop + 4 * w), Value(new_words[w])));
+    code.push_back(Instruction(Operations::DEC, Register::B));
+    code.push_back(Instruction(Operations::CMP, Register::B, Value(0)));
+
+    ui32 pc = 0;
+    for(auto const& i : code)
+        pc += i.get_byte_size();
+    code.push_back(Instruction(Operations::JMPNE, Value(static_cast<i32>(loop) - static_cast<i32>(pc))));
+    code.push_back(Instruction(Operations::HLT));
+    return code;
+}
+
+// `targets` functions adding 1, 2, 3 to A, called in turn through a register from one call site
+vcx::Executable indirect_calls(ui32 targets, ui32 iterations) {
+    std::vector<Instruction> code;
+    std::vector<ui32> functions;
+    ui32 pc = 0;
+    auto emit = [&code, &pc] (Instruction const& i) {
+        code.push_back(i);
+        pc += i.get_byte_size();
+    };
+
+    for(ui32 t = 0; t < targets; ++t) {
+        functions.push_back(pc);
+        emit(Instruction(Operations::ADD, Register::A, Value(t + 1)));
+        emit(Instruction(Operations::RET));
+    }
+
+    ui32 entry_point = pc;
+    Register registers[] = { Register::C, Register::E, Register::F };
+    emit(Instruction(Operations::MOV, Register::A, Value(0)));
+    emit(Instruction(Operations::MOV, Register::B, Value(iterations)));
+    for(ui32 t = 0; t < targets; ++t)
+        emit(Instruction(Operations::MOV, registers[t], Value(functions[t])));
+    ui32 loop = pc;
+    emit(Instruction(Operations::CALL, Register::C));
+    for(ui32 t = 0; t + 1 < targets; ++t)
+        emit(Instruction(Operations::SWP, registers[t], registers[t + 1]));
+    emit(Instruction(Operations::DEC, Register::B));
+    emit(Instruction(Operations::CMP, Register::B, Value(0)));
+    emit(Instruction(Operations::JMPNE, Value(static_cast<i32>(loop) - static_cast<i32>(pc))));
+    emit(Instruction(Operations::HLT));
+
+    auto exe = executable_of(code);
+    exe.entry_point = entry_point;
+    return exe;
+}
+
+// Counts the calls in A with a frame per call
+vcx::Executable deep_recursion(ui32 depth) {
+    benchmark::Builder b;
+    auto entry = b.label();
+    auto function = b.label();
+    auto done = b.label();
+
+    b.bind(entry);
+    b.push(Instruction(Operations::MOV, Register::B, Value(depth)));
+    b.call(function);
+    b.push(Instruction(Operations::HLT));
+
+    b.bind(function);
+    b.push(Instruction(Operations::CMP, Register::B, Value(0)));
+    b.jump(Operations::JMPE, done);
+    b.push(Instruction(Operations::ETR));
+    b.push(Instruction(Operations::DEC, Register::B));
+    b.call(function);
+    b.push(Instruction(Operations::INC, Register::A));
+    b.push(Instruction(Operations::LVE));
+    b.bind(done);
+    b.push(Instruction(Operations::RET));
+
+    return b.build(entry);
+}
+
+// Runs `exe` on the VerifiedInterpreter, calls and returns fused, it must halt as on the Interpreter
+// after as many instructions and calls
+bool test_verified_calls(std::string const& name, vcx::Executable const& exe) {
+    try {
+
+        program::Program program(exe);
+        SandBox sandbox(1 << 16);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        VerifiedInterpreter::run(program, sandbox, counters);
+
+        SandBox expected(1 << 16);
+        expected.load_executable(exe);
+        interpreter::Counters expected_counters(expected);
+        Interpreter::run(expected, expected_counters);
+
+        if (sandbox.get_register(0) != expected.get_register(0) || counters.instructions != expected_counters.instructions
+         || counters.calls != expected_counters.calls) {
+            error_header();
+            std::cout << name << " halts with " << sandbox.get_register(0) << " after " << counters.instructions << " instructions and "
+                      << counters.calls << " calls instead of " << expected.get_register(0) << " after " << expected_counters.instructions
+                      << " and " << expected_counters.calls << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " halts as interpreted\n";
+    return true;
+}
+
+// Compiles `exe` to a shared object with $CXX (c++ by default) run from the root of the repository
+// Returns the path of the shared object, without its extension, throws std::runtime_error if it can't be built
+std::string build_native(vcx::Executable const& exe) {
+    auto base = (std::filesystem::temp_directory_path() / "vcrate-test-native").string();
+    {
+        std::ofstream os(base + ".cpp");
+        compiler::compile(os, exe);
+    }
+    auto cxx = std::getenv("CXX");
+    auto command = std::string(cxx ? cxx : "c++") + " -std=c++17 -O1 -fPIC -shared"
+        + " -I include -I lib/bytecode-description/include -I lib/sandbox/include"
+        + " -o " + base + ".so " + base + ".cpp";
+    if (std::system(command.c_str()) != 0)
+        throw std::runtime_error("can't be built with: " + command);
+    return base;
+}
+
+// Runs `exe` with the `handler` symbol as trap handler if it has one, on the Interpreter and on the
+// VerifiedInterpreter if the program passes the verifier. Both must trap with `code` and halt with `expected`
+// With `verified_only`, the trap is one of the VerifiedInterpreter alone and the program must pass the verifier
+bool test_trap(std::string const& name, vcx::Executable const& exe, TrapCode code, ui32 expected, bool verified_only = false, bool native = false) {
+    try {
+
+        program::Program program(exe);
+        bool verified = !verifier::has_errors(verifier::verify(exe, program));
+        if (verified_only && !verified) {
+            error_header();
+            std::cout << name << " is rejected by the verifier\n";
+            return false;
+        }
+        std::optional<compiler::NativeProgram> compiled;
+        if (native) {
+            auto base = build_native(exe);
+            compiled.emplace(base + ".so");
+            std::filesystem::remove(base + ".cpp");
+            std::filesystem::remove(base + ".so");
+        }
+
+        std::vector<std::string> engines = { "interpreted", "cached", "verified", "native" };
+        for(ui32 engine = verified_only ? 2 : 0; engine < (native ? 4 : verified ? 3 : 2); ++engine) {
+            SandBox sandbox(1 << 16);
+            sandbox.load_executable(exe);
+            interpreter::Counters counters(sandbox);
+            auto handler = exe.symbols.find("handler");
+            if (handler != exe.symbols.end())
+                counters.trap_handler = handler->second;
+
+            if (engine == 0) {
+                Interpreter::run(sandbox, counters);
+            } else if (engine == 1) {
+                interpreter::DecodeCache cache(exe);
+                Interpreter::run(sandbox, counters, cache);
+            } else if (engine == 2) {
+                VerifiedInterpreter::run(program, sandbox, counters);
+            } else {
+                if (!compiled->is_loaded())
+                    throw std::runtime_error(compiled->get_error());
+                compiled->run(sandbox, counters);
+            }
+
+            if (counters.trap.code != code || sandbox.get_register(0) != expected) {
+                error_header();
+                std::cout << name << " " << engines[engine] << " traps with " << to_string(counters.trap.code)
+                          << " and halts with " << sandbox.get_register(0) << " instead of " << to_string(code) << " and " << expected << "\n";
+                return false;
+            }
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " traps with " << to_string(code) << "\n";
+    return true;
+}
+
+vcx::Executable division_by_zero(bool with_handler) {
+    benchmark::Builder b;
+    auto entry = b.label();
+    auto handler = b.label();
+
+    b.bind(entry);
+    b.push(Instruction(Operations::MOV, Register::A, Value(5)));
+    b.push(Instruction(Operations::MOV, Register::B, Value(0)));
+    b.push(Instruction(Operations::DIV, Register::A, Register::B));
+    b.push(Instruction(Operations::ADD, Register::A, Value(1)));
+    b.push(Instruction(Operations::HLT));
+
+    if (with_handler) {
+        b.bind(handler, "handler");
+        b.push(Instruction(Operations::POP, Register::C));
+        b.push(Instruction(Operations::ADD, Register::A, Register::C));
+        b.push(Instruction(Operations::RET));
+    }
+    return b.build(entry);
+}
+
+// Divides the lowest 64 bits value by -1, then the lowest 32 bits value, both wrap to themselves without a trap
+// The handler returns to the instruction after the faulting MOD, whose destination must be left as it was
+vcx::Executable modulo_by_zero() {
+    benchmark::Builder b;
+    auto entry = b.label();
+    auto handler = b.label();
+
+    b.bind(entry);
+    b.push(Instruction(Operations::MOV, Register::A, Value(5)));
+    b.push(Instruction(Operations::MOV, Register::B, Value(0)));
+    b.push(Instruction(Operations::MOD, Register::A, Register::B));
+    b.push(Instruction(Operations::HLT));
+
+    b.bind(handler, "handler");
+    b.push(Instruction(Operations::POP, Register::C));
+    b.push(Instruction(Operations::RET));
+    return b.build(entry);
+}
+
+// Jumps through a register to the middle of an instruction, a handler is set but must not be called
+vcx::Executable jump_to_invalid_pc() {
+    benchmark::Builder b;
+    auto entry = b.label();
+    auto handler = b.label();
+
+    b.bind(entry);
+    b.push(Instruction(Operations::MOV, Register::A, Value(3)));
+    b.push(Instruction(Operations::MOV, Register::B, Value(2)));
+    b.push(Instruction(Operations::JMP, Register::B));
+    b.push(Instruction(Operations::HLT));
+
+    b.bind(handler, "handler");
+    b.push(Instruction(Operations::POP, Register::C));
+    b.push(Instruction(Operations::INC, Register::A));
+    b.push(Instruction(Operations::RET));
+    return b.build(entry);
+}
+
+vcx::Executable division_overflow() {
+    benchmark::Builder b;
+    auto entry = b.label();
+
+    b.bind(entry);
+    b.push(Instruction(Operations::MOV, Register::A, Value(0)));
+    b.push(Instruction(Operations::MOV, Register::B, Value(std::numeric_limits<i32>::min())));
+    b.push(Instruction(Operations::MOV, Register::C, Value(-1)));
+    b.push(Instruction(Operations::MOV, Register::D, Value(-1)));
+    b.push(WideInstruction(WideOperations::DIVL, Register::A, Register::C));
+    b.push(Instruction(Operations::ADD, Register::A, Register::B));
+    b.push(Instruction(Operations::DIV, Register::A, Register::C));
+    b.push(Instruction(Operations::HLT));
+    return b.build(entry);
+}
+
+// Writes 64 bits over its own second instruction, which a verified program can't do
+vcx::Executable wide_write_to_code() {
+    benchmark::Builder b;
+    auto entry = b.label();
+
+    b.bind(entry);
+    b.push(Instruction(Operations::MOV, Register::A, Value(3)));
+    b.push(Instruction(Operations::MOV, Register::B, Value(4)));
+    b.push(WideInstruction(WideOperations::MOVL, Deferred(Register::B), Register::C));
+    b.push(Instruction(Operations::HLT));
+    return b.build(entry);
+}
+
+// A sandbox given back to the pool after running `exe` is acquired again as SandBox::load_executable leaves it
+bool test_pool(std::string const& name, vcx::Executable const& exe) {
+    try {
+
+        pool::SandBoxPool pool(exe, 1 << 16, 1);
+        SandBox fresh(1 << 16);
+        fresh.load_executable(exe);
+
+        SandBox* first = nullptr;
+        {
+            auto sandbox = pool.acquire();
+            first = &*sandbox;
+            interpreter::Counters counters(*sandbox);
+            Interpreter::run(*sandbox, counters);
+        }
+
+        auto sandbox = pool.acquire();
+        bool same = &*sandbox == first && !sandbox->is_halted() && pool.get_reused() == 1;
+        for(ui32 r = 0; r < 16; ++r)
+            same = same && sandbox->get_register(r) == fresh.get_register(r);
+        for(ui32 address = 0; address < (1 << 16); address += 4)
+            same = same && sandbox->get_memory_at(address) == fresh.get_memory_at(address);
+        if (!same) {
+            error_header();
+            std::cout << name << " isn't reset\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " is reset\n";
+    return true;
+}
+
+bool test_server(std::string const& name, vcx::Executable const& exe, server::Request request, server::Status status, std::string const& output, ui32 halt_code) {
+    try {
+
+        request.path = (std::filesystem::temp_directory_path() / "vcrate-test-server.vcx").string();
+        {
+            std::ofstream os(request.path, std::ios::binary);
+            program::write_compact(os, exe);
+        }
+
+        server::Server server(server::Options{});
+        // The second run finds the executable in the cache, and goes through the encoding of the protocol
+        auto first = server.handle(request);
+        auto second = server::decode_response(server::encode(server.handle(*server::decode_request(server::encode(request)))));
+        std::filesystem::remove(request.path);
+
+        for(auto const& response : { first, *second }) {
+            if (response.status != status || response.output != output || response.halt_code != halt_code) {
+                error_header();
+                std::cout << name << " is " << server::to_string(response.status) << " with output \"" << response.output
+                          << "\" and halt code " << response.halt_code << " (" << server::to_string(status) << ", \"" << output << "\" and " << halt_code << " expected)\n";
+                return false;
+            }
+        }
+        if (server.get_loads() != 1) {
+            error_header();
+            std::cout << name << " is loaded " << server.get_loads() << " times\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " is served\n";
+    return true;
+}
+
+bool test_disk_cache(std::string const& name, vcx::Executable const& exe) {
+    try {
+
+        auto directory = (std::filesystem::temp_directory_path() / "vcrate-test-cache").string();
+        std::filesystem::remove_all(directory);
+        cache::DiskCache cache(directory);
+
+        std::ostringstream os;
+        program::write_compact(os, exe);
+        auto contents = os.str();
+        auto key = cache::DiskCache::key_of(contents);
+
+        auto prepared = cache.prepare(contents);
+        auto loaded = cache.load(key, contents.size());
+        // The key of a file of another size
+        bool colliding_missed = !cache.load(key, contents.size() + 1);
+        // A corrupted or truncated entry is a miss, not a crash
+        auto entry = cache.path_of(key);
+        auto size = std::filesystem::file_size(entry);
+        {
+            std::fstream fs(entry, std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekg(size - 2);
+            char c = fs.get();
+            fs.seekp(size - 2);
+            fs.put(c ^ 1);
+        }
+        bool corrupted_missed = !cache.load(key, contents.size());
+        std::filesystem::resize_file(entry, size - 1);
+        bool truncated_missed = !cache.load(key, contents.size());
+        std::filesystem::remove_all(directory);
+
+        bool same = prepared && loaded && colliding_missed && corrupted_missed && truncated_missed && loaded->verified == prepared->verified
+                 && loaded->exe.code == exe.code && loaded->exe.symbols == exe.symbols && loaded->exe.entry_point == exe.entry_point
+                 && loaded->program.get_instructions().size() == prepared->program.get_instructions().size()
+                 && loaded->program.get_code_size() == prepared->program.get_code_size();
+        for(ui32 pc = 0; same && pc < exe.code.size() * 4; pc += 4) {
+            auto a = loaded->program.at(pc);
+            auto b = prepared->program.at(pc);
+            same = (a == nullptr) == (b == nullptr) && (!a || std::memcmp(a, b, sizeof(*a)) == 0);
+        }
+        if (!same) {
+            error_header();
+            std::cout << name << " isn't loaded back as it was stored\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " is loaded back\n";
+    return true;
+}
+
+bool test_batch(std::string const& name, vcx::Executable const& exe, std::vector<std::string> const& inputs, ui32 workers) {
+    try {
+
+        auto temporary = std::filesystem::temp_directory_path();
+        auto path = (temporary / "vcrate-test-batch.vcx").string();
+        auto directory = (temporary / "vcrate-test-batch").string();
+        std::filesystem::remove_all(directory);
+        {
+            std::ofstream os(path, std::ios::binary);
+            program::write_compact(os, exe);
+        }
+
+        // One per line, read as they are run
+        auto lines = (temporary / "vcrate-test-batch.txt").string();
+        {
+            std::ofstream os(lines, std::ios::binary);
+            for(auto const& input : inputs)
+                os << input << '\n';
+        }
+
+        server::Server server(server::Options{});
+        batch::Summary summary;
+        {
+            batch::InputReader batch_inputs(lines);
+            batch::ResultWriter writer(directory);
+            summary = batch::run(server, path, batch_inputs, writer, workers);
+        }
+
+        // In the order of the inputs, whatever the order they ran in
+        std::ifstream results(std::filesystem::path(directory) / "results.tsv");
+        std::string line;
+        bool same = summary.runs == inputs.size() && summary.failures == 0 && server.get_loads() == 1;
+        for(ui32 i = 0; same && i < inputs.size(); ++i) {
+            std::ifstream os(std::filesystem::path(directory) / (std::to_string(i + 1) + ".out"));
+            std::string output((std::istreambuf_iterator<char>(os)), {});
+            same = std::getline(results, line) && output == inputs[i].substr(0, 1)
+                && line == std::to_string(i + 1) + "\thalted\t" + std::to_string(inputs[i].size()) + "\t4\t";
+        }
+        std::filesystem::remove_all(directory);
+        std::filesystem::remove(path);
+        std::filesystem::remove(lines);
+
+        if (!same) {
+            error_header();
+            std::cout << name << " doesn't give the result of each input\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " gives the result of each input\n";
+    return true;
+}
+
+bool test_disassembler(std::string const& name, vcx::Executable const& exe, ui32 workers, ui32 chunk_words) {
+    try {
+
+        auto expected = disassembler::decode_chunk(exe, 0, exe.code.size());
+        std::vector<disassembler::Line> lines;
+        disassembler::disassemble(exe, [&] (disassembler::Line const& line) { lines.push_back(line); }, workers, chunk_words);
+
+        bool same = lines.size() == expected.size();
+        for(ui32 i = 0; same && i < lines.size(); ++i)
+            same = lines[i].pc == expected[i].pc && lines[i].size == expected[i].size && lines[i].text == expected[i].text;
+        if (!same) {
+            error_header();
+            std::cout << name << " gives " << lines.size() << " instructions (" << expected.size() << " expected) or other ones\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " is disassembled in order\n";
+    return true;
+}
+
+bool test_symbol_index(std::string const& name, vcx::Executable const& exe, ui32 address, std::string const& expected) {
+    try {
+
+        program::SymbolIndex symbols(exe);
+        auto location = symbols.location_of(address);
+        // The same as looking at every symbol
+        std::map<std::string, ui32>::value_type const* best = nullptr;
+        for(auto const& p : exe.symbols)
+            if (p.second <= address && (!best || p.second > best->second))
+                best = &p;
+        auto enclosing = symbols.enclosing(address);
+        if (location != expected || (best == nullptr) != (enclosing == nullptr) || (best && best->first != enclosing->name)) {
+            error_header();
+            std::cout << name << " is at " << location << " (" << expected << " expected)\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " is at " << expected << "\n";
+    return true;
+}
+
+// Runs `exe` under a debugger stopping at its first `ope`, `hits` times, then again a step and a next at a time
+// Stops don't change the run, which must halt as on the Interpreter after as many instructions
+bool test_debugger(std::string const& name, vcx::Executable const& exe, Operations ope, bool verified, ui32 hits, ui64 nexts) {
+    try {
+
+        SandBox expected(1 << 16);
+        expected.load_executable(exe);
+        interpreter::Counters expected_counters(expected);
+        Interpreter::run(expected, expected_counters);
+
+        program::Program program(exe);
+        auto it = std::find_if(program.get_instructions().begin(), program.get_instructions().end(), [ope] (program::DecodedInstruction const& d) {
+            return !d.wide && d.op == static_cast<ui8>(ope);
+        });
+
+        SandBox sandbox(1 << 16);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        debugger::Debugger debugger(exe, sandbox, counters);
+        debugger.add_breakpoint(it->pc);
+        ui32 stops = 0;
+        while(debugger.resume() == debugger::Stop::Breakpoint)
+            stops += sandbox.get_pc() == it->pc;
+
+        ui64 runs[2] = {};
+        for(ui32 mode = 0; mode < 2; ++mode) {
+            SandBox stepped(1 << 16);
+            stepped.load_executable(exe);
+            interpreter::Counters stepped_counters(stepped);
+            debugger::Debugger d(exe, stepped, stepped_counters);
+            do
+                ++runs[mode];
+            while((mode == 0 ? d.step() : d.next()) != debugger::Stop::Halted);
+            if (stepped.get_register(0) != expected.get_register(0) || stepped_counters.instructions != expected_counters.instructions)
+                runs[mode] = 0;
+        }
+
+        if (debugger.is_verified() != verified || stops != hits || sandbox.get_register(0) != expected.get_register(0)
+         || counters.instructions != expected_counters.instructions || runs[0] != expected_counters.instructions || runs[1] != nexts) {
+            error_header();
+            std::cout << name << " stops " << stops << " times and halts with " << sandbox.get_register(0) << " after " << counters.instructions
+                      << " instructions, " << runs[0] << " steps and " << runs[1] << " nexts instead of " << hits << " times, "
+                      << expected.get_register(0) << " after " << expected_counters.instructions << " instructions and " << nexts << " nexts"
+                      << (debugger.is_verified() == verified ? "" : (verified ? ", not verified" : ", verified")) << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " stops " << hits << " times\n";
+    return true;
+}
+
+// Runs `code` on the Sanitizer, which must find only faults of `kinds` by the instructions at `pcs`, and halt as on the Interpreter
+bool test_sanitizer(std::string const& name, std::vector<Instruction> const& code, std::vector<std::pair<sanitizer::Kind, ui32>> const& faults) {
+    auto exe = executable_of(code);
+
+    try {
+
+        SandBox sandbox(1 << 16);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        sanitizer::Sanitizer sanitizer(exe, sandbox);
+        sanitizer.run(sandbox, counters);
+
+        std::vector<std::pair<sanitizer::Kind, ui32>> found;
+        for(auto const& r : sanitizer.get_reports())
+            found.emplace_back(r.kind, r.pc);
+        if (found != faults || sandbox.get_register(0) != halt_code_of(exe)) {
+            error_header();
+            std::cout << name << " halts with " << sandbox.get_register(0) << " and finds " << found.size() << " faults instead of " << faults.size() << "\n";
+            sanitizer.report(std::cout);
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " finds " << faults.size() << " faults\n";
+    return true;
+}
+
+// Runs `code` with a coverage, which must tell for each instruction what disassembler::coverage_of gives in `expected`,
+// and come back the same from a file or merged with itself
+bool test_coverage(std::string const& name, std::vector<Instruction> const& code, std::vector<std::string> const& expected) {
+    auto exe = executable_of(code);
+
+    try {
+
+        SandBox sandbox(1 << 16);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        coverage::Coverage covered(exe);
+        while(!sandbox.is_halted()) {
+            covered.before(sandbox);
+            Interpreter::run_next_instruction(sandbox, counters);
+            covered.after(sandbox);
+        }
+
+        std::stringstream ss;
+        covered.save(ss);
+        auto loaded = coverage::Coverage::load(ss);
+        coverage::Coverage merged;
+        bool merges = loaded && merged.merge(covered) && merged.merge(*loaded) && !merged.merge(coverage::Coverage(executable_of({ Instruction(Operations::HLT) })));
+
+        std::vector<std::string> found[3];
+        for(auto const& line : disassembler::decode_chunk(exe, 0, exe.code.size())) {
+            found[0].push_back(disassembler::coverage_of(covered, line));
+            if (loaded)
+                found[1].push_back(disassembler::coverage_of(*loaded, line));
+            found[2].push_back(disassembler::coverage_of(merged, line));
+        }
+        if (found[0] != expected || found[1] != expected || found[2] != expected || !merges) {
+            error_header();
+            std::cout << name << " covers";
+            for(auto const& f : found[0])
+                std::cout << " " << f;
+            std::cout << (found[1] != found[0] ? ", not the same once loaded" : "") << (merges && found[2] == found[0] ? "" : ", not the same once merged") << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " misses " << std::count(expected.begin(), expected.end(), "missed") << " instructions\n";
+    return true;
+}
+
+// Seeks forth and back on a Replayer keeping at most `max_checkpoints`, each position must be the one
+// a replay seeking straight to it reaches
+bool test_replay(std::string const& name, vcx::Executable const& exe, ui64 checkpoint_period, ui32 max_checkpoints) {
+    try {
+
+        replay::Recording recording;
+        recording.executable_hash = replay::hash_of(exe);
+        recording.memory_size = 1 << 16;
+
+        replay::Replayer replayer(exe, recording, checkpoint_period, max_checkpoints);
+        replayer.seek(std::numeric_limits<ui64>::max());
+        ui64 total = replayer.get_instruction();
+        if (!replayer.is_halted() || total < 4 * checkpoint_period * max_checkpoints) {
+            error_header();
+            std::cout << name << " runs " << total << " instructions, too few to drop checkpoints\n";
+            return false;
+        }
+
+        for(ui64 target : { total / 2, total / 7, ui64(1), total - 1, total / 3, ui64(0) }) {
+            replayer.seek(target);
+            replay::Replayer straight(exe, recording);
+            straight.seek(target);
+            bool same = replayer.get_instruction() == target && straight.get_instruction() == target;
+            for(ui32 id = 0; id < 16; ++id)
+                same = same && replayer.get_sandbox().get_register(id) == straight.get_sandbox().get_register(id);
+            if (!same) {
+                error_header();
+                std::cout << name << " seeks to " << replayer.get_instruction() << " instead of " << target
+                          << " or doesn't get the registers of a straight replay\n";
+                return false;
+            }
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " seeks back and forth\n";
+    return true;
+}
+
+// Runs `code` on the Interpreter, with the heap tracked or not, and its counters must give `expected` as JSON
+bool test_counters(std::string const& name, std::vector<Instruction> const& code, bool track_heap, std::string const& expected) {
+    auto exe = executable_of(code);
+
+    try {
+
+        SandBox sandbox(1 << 16);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        if (track_heap)
+            counters.track_heap();
+        Interpreter::run(sandbox, counters);
+
+        auto json = counters.to_json();
+        if (json != expected) {
+            error_header();
+            std::cout << name << " gives " << json << " instead of " << expected << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " gives " << expected << "\n";
+    return true;
+}
+
+// Profiles `exe` sampling every `sample_period` instructions, the report must count as many instructions and calls
+// as the counters, and the folded stacks must hold every sample, never deeper than `depth` frames (reached if every instruction is sampled)
+bool test_profiler(std::string const& name, vcx::Executable const& exe, ui32 sample_period, ui32 depth) {
+    try {
+
+        SandBox sandbox(1 << 16);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        profiler::Profiler profiler(exe, sample_period);
+        while(!sandbox.is_halted()) {
+            profiler.before(sandbox);
+            Interpreter::run_next_instruction(sandbox, counters);
+            profiler.after(sandbox);
+        }
+
+        std::stringstream report;
+        profiler.report(report);
+        ui64 instructions = 0, calls = 0;
+        for(std::string line; std::getline(report, line);) {
+            std::stringstream ss(line);
+            std::string first;
+            ss >> first;
+            if (first == "Instructions")
+                ss >> first >> instructions;
+            else if (first == "CALL")
+                ss >> calls;
+        }
+
+        std::stringstream folded;
+        profiler.folded_stacks(folded);
+        ui64 samples = 0;
+        ui32 deepest = 0;
+        for(std::string line; std::getline(folded, line);) {
+            auto space = line.rfind(' ');
+            samples += std::stoull(line.substr(space + 1));
+            deepest = std::max<ui32>(deepest, std::count(line.begin(), line.begin() + space, ';') + 1);
+        }
+
+        if (instructions != counters.instructions || calls != counters.calls || samples != instructions / sample_period
+            || deepest > depth || (sample_period == 1 && deepest != depth)) {
+            error_header();
+            std::cout << name << " counts " << instructions << " instructions, " << calls << " calls, " << samples << " samples and "
+                      << deepest << " frames instead of " << counters.instructions << ", " << counters.calls << ", "
+                      << counters.instructions / sample_period << " and " << depth << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " counts every instruction\n";
+    return true;
+}
+
+// Traces `exe` to a file, reading it back must give a record per instruction with the pc and sp executed,
+// also when seeking to each record, and a trace to a file that can't be opened must record nothing
+bool test_trace(std::string const& name, vcx::Executable const& exe) {
+    try {
+
+        auto file = (std::filesystem::temp_directory_path() / "vcrate-test-trace.vctr").string();
+        std::vector<std::pair<ui32, ui32>> executed;
+        {
+            SandBox sandbox(1 << 16);
+            sandbox.load_executable(exe);
+            interpreter::Counters counters(sandbox);
+            trace::TraceWriter writer(file, 4);
+            trace::TraceWriter unopened((std::filesystem::temp_directory_path() / "vcrate-no-directory" / "trace.vctr").string(), 4);
+            if (!writer.is_open() || unopened.is_open()) {
+                error_header();
+                std::cout << name << " opens the traces it shouldn't or doesn't open those it should\n";
+                return false;
+            }
+            while(!sandbox.is_halted()) {
+                executed.emplace_back(sandbox.get_pc(), sandbox.get_sp());
+                writer.record(sandbox);
+                unopened.record(sandbox);
+                Interpreter::run_next_instruction(sandbox, counters);
+            }
+        }
+
+        std::ifstream is(file, std::ios::binary);
+        trace::TraceReader reader(is);
+        std::vector<std::pair<ui32, ui32>> read;
+        trace::TraceRecord record;
+        while(reader.next(record))
+            read.emplace_back(record.pc, record.sp);
+
+        bool seeks = reader.is_valid();
+        for(ui64 index = read.size(); seeks && index-- > 0;)
+            seeks = reader.seek(index) && reader.next(record) && std::make_pair(record.pc, record.sp) == read[index];
+        std::filesystem::remove(file);
+
+        if (read != executed || !seeks) {
+            error_header();
+            std::cout << name << " reads " << read.size() << " records instead of the " << executed.size() << " executed"
+                      << (seeks ? "" : ", or not the same once seeking") << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " reads back every record\n";
+    return true;
+}
+
+// Measures `kernel` once on every benchmark engine, all must halt with the same code and output
+// after as many instructions, and print something if `printing`
+bool test_engines(std::string const& name, benchmark::Kernel const& kernel, bool printing = false) {
+    try {
+
+        benchmark::Options options;
+        options.warmup = 0;
+        options.repetitions = 1;
+        std::vector<benchmark::Result> results;
+        for(auto const& engine : benchmark::engines())
+            results.push_back(benchmark::measure(kernel, engine, options));
+
+        std::stringstream comparison;
+        bool same = benchmark::print_comparison(comparison, results);
+        for(auto const& r : results)
+            same = same && r.instructions == results.front().instructions && r.durations.size() == 1;
+        if (printing && results.front().output.empty())
+            same = false;
+        if (!same) {
+            error_header();
+            std::cout << name << " doesn't run the same on every engine:";
+            for(auto const& r : results)
+                std::cout << " " << r.engine << " (" << r.instructions << " instructions, halt code " << r.halt_code << ", " << r.output.size() << " bytes printed)";
+            std::cout << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " runs the same on " << benchmark::engines().size() << " engines\n";
+    return true;
+}
+
+// Saves `baseline` and loads it back, then checks `current` against it with a 5 % tolerance:
+// it must regress only if `regressed`
+bool test_regressions(std::string const& name, std::vector<f64> const& baseline, std::vector<f64> const& current, ui64 current_instructions, bool regressed) {
+    try {
+
+        benchmark::Result base;
+        base.kernel = "kernel";
+        base.engine = "engine";
+        base.instructions = 1000;
+        base.durations = baseline;
+        benchmark::Result result = base;
+        result.instructions = current_instructions;
+        result.durations = current;
+
+        std::stringstream ss;
+        benchmark::save_results(ss, { base });
+        auto loaded = benchmark::load_results(ss);
+        if (!loaded || loaded->size() != 1 || loaded->front().kernel != base.kernel || loaded->front().engine != base.engine
+            || loaded->front().instructions != base.instructions || loaded->front().durations != base.durations) {
+            error_header();
+            std::cout << name << " doesn't load the saved baseline back\n";
+            return false;
+        }
+
+        std::stringstream report;
+        if (benchmark::check_regressions(report, *loaded, { result }, 0.05) == regressed) {
+            error_header();
+            std::cout << name << (regressed ? " doesn't regress" : " regresses") << "\n" << report.str();
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << (regressed ? " regresses" : " doesn't regress") << "\n";
+    return true;
+}
+
+// Two loops, one in the other, counting down from 3
+// The blocks start at the entry point, both loop headers, after the inner loop and at the HLT
+vcx::Executable nested_loops(std::vector<ui32>& block_pcs) {
+    benchmark::Builder b;
+    auto entry = b.label();
+    auto outer = b.label();
+    auto inner = b.label();
+
+    b.bind(entry);
+    block_pcs.push_back(b.here());
+    b.push(Instruction(Operations::MOV, Register::A, Value(3)));
+    b.bind(outer);
+    block_pcs.push_back(b.here());
+    b.push(Instruction(Operations::MOV, Register::B, Value(3)));
+    b.bind(inner);
+    block_pcs.push_back(b.here());
+    b.push(Instruction(Operations::DEC, Register::B));
+    b.push(Instruction(Operations::CMP, Register::B, Value(0)));
+    b.jump(Operations::JMPNE, inner);
+    block_pcs.push_back(b.here());
+    b.push(Instruction(Operations::DEC, Register::A));
+    b.push(Instruction(Operations::CMP, Register::A, Value(0)));
+    b.jump(Operations::JMPNE, outer);
+    block_pcs.push_back(b.here());
+    b.push(Instruction(Operations::HLT));
+
+    return b.build(entry);
+}
+
+// Builds the control flow graph of `exe`, its blocks must start at `block_pcs` with the immediate dominators
+// and the loop depths given for each block, in the same order
+bool test_control_flow(std::string const& name, vcx::Executable const& exe, std::vector<ui32> const& block_pcs,
+                       std::vector<ui32> const& dominators, std::vector<ui32> const& depths) {
+    try {
+
+        program::Program program(exe);
+        analysis::ControlFlowGraph cfg(exe, program);
+        auto const& blocks = cfg.get_blocks();
+
+        std::vector<ui32> found_pcs, found_dominators, found_depths;
+        for(ui32 b = 0; b < blocks.size(); ++b) {
+            found_pcs.push_back(blocks[b].begin_pc);
+            found_dominators.push_back(blocks[b].immediate_dominator);
+            found_depths.push_back(cfg.loop_depth(b));
+        }
+        bool dominates = true;
+        for(ui32 a = 0; a < blocks.size(); ++a)
+            for(ui32 b = 0; b < blocks.size(); ++b) {
+                bool expected = a == b;
+                for(ui32 d = b; !expected && d < dominators.size() && dominators[d] != analysis::ControlFlowGraph::none; d = dominators[d])
+                    expected = dominators[d] == a;
+                dominates = dominates && cfg.dominates(a, b) == expected;
+            }
+
+        if (found_pcs != block_pcs || found_dominators != dominators || found_depths != depths || !dominates) {
+            error_header();
+            std::cout << name << " finds the blocks (pc, immediate dominator, loop depth)";
+            for(ui32 b = 0; b < blocks.size(); ++b)
+                std::cout << " (" << found_pcs[b] << ", " << static_cast<i32>(found_dominators[b]) << ", " << found_depths[b] << ")";
+            std::cout << (dominates ? "" : ", dominates disagrees with them") << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " finds " << block_pcs.size() << " blocks and " << *std::max_element(depths.begin(), depths.end()) << " nested loops\n";
+    return true;
+}
+
+// The native program built from `exe` must halt as interpreted, after as many instructions and calls and with the same output
+bool test_native(std::string const& name, vcx::Executable const& exe) {
+    try {
+
+        auto base = build_native(exe);
+        compiler::NativeProgram native(base + ".so");
+        if (!native.is_loaded() || !native.is_compiled_from(exe)) {
+            error_header();
+            std::cout << name << " can't be loaded: " << native.get_error() << "\n";
+            return false;
+        }
+
+        std::ostringstream output, expected_output;
+        SandBox sandbox(1 << 24);
+        sandbox.load_executable(exe);
+        interpreter::Counters counters(sandbox);
+        auto old = std::cout.rdbuf(output.rdbuf());
+        native.run(sandbox, counters);
+
+        SandBox expected(1 << 24);
+        expected.load_executable(exe);
+        interpreter::Counters expected_counters(expected);
+        std::cout.rdbuf(expected_output.rdbuf());
+        Interpreter::run(expected, expected_counters);
+        std::cout.rdbuf(old);
+
+        std::filesystem::remove(base + ".cpp");
+        std::filesystem::remove(base + ".so");
+
+        if (sandbox.get_register(0) != expected.get_register(0) || counters.instructions != expected_counters.instructions
+         || counters.calls != expected_counters.calls || output.str() != expected_output.str()) {
+            error_header();
+            std::cout << name << " halts with " << sandbox.get_register(0) << " after " << counters.instructions << " instructions and "
+                      << counters.calls << " calls instead of " << expected.get_register(0) << " after " << expected_counters.instructions
+                      << " and " << expected_counters.calls << (output.str() == expected_output.str() ? "" : ", not printing the same") << "\n";
+            return false;
+        }
+
+    } catch(std::exception const& e) {
+        exception_header();
+        std::cout << name << " " << e.what() << "\n";
+        return false;
+    }
+
+    good_header();
+    std::cout << name << " halts as interpreted\n";
+    return true;
+}
 
 int main() {
     std::cout << "Start testing...\n";
@@ -621,4 +1911,309 @@ int main() {
     });
 
 
+
+    title("Wide operations");
+    subtitle("One argument");
+    test_wide_instruction(WideInstruction(WideOperations::ITL, Register::A));
+    test_wide_instruction(WideInstruction(WideOperations::DBGD, Displacement(Register::B, -8)));
+    test_wide_instruction(WideInstruction(WideOperations::INCL, Address(std::numeric_limits<ui32>::max())));
+
+    subtitle("Two arguments");
+    test_wide_instruction(WideInstruction(WideOperations::ADDL, Register::C, Register::E));
+    test_wide_instruction(WideInstruction(WideOperations::MOVL, Deferred(Register::SP), Value(std::numeric_limits<i32>::min())));
+    test_wide_instruction(WideInstruction(WideOperations::CMPD, Displacement(Register::L, 1), Address(bytecode::v1::arg_12_signed_value.max_value() + 1)));
+
+    title("Verifier");
+    test_verifier("Balanced stack", {
+        Instruction(Operations::PUSH, Register::A), Instruction(Operations::POP, Register::B), Instruction(Operations::HLT)
+    }, false);
+    test_verifier("Write to an immediate", {
+        Instruction(Operations::MOV, Value(1), Register::A), Instruction(Operations::HLT)
+    }, true);
+    test_verifier("Pop of the return address", {
+        Instruction(Operations::POP, Register::A), Instruction(Operations::RET)
+    }, true);
+    test_verifier("Jump inside an instruction", {
+        Instruction(Operations::JMP, Value(2)), Instruction(Operations::HLT)
+    }, true);
+    test_verifier("Paths with different depths", {
+        Instruction(Operations::CMP, Register::A, Value(0)), Instruction(Operations::JMPE, Value(8)),
+        Instruction(Operations::PUSH, Register::A), Instruction(Operations::RET)
+    }, true);
+
+    title("Optimizer");
+    test_optimizer("Constant folding", {
+        Instruction(Operations::MOV, Register::A, Value(6)), Instruction(Operations::MOV, Register::B, Value(7)),
+        Instruction(Operations::MULU, Register::A, Register::B), Instruction(Operations::INC, Register::A),
+        Instruction(Operations::HLT)
+    }, 3);
+    test_optimizer("Strength reduction", {
+        Instruction(Operations::MOV, Register::A, Register::C), Instruction(Operations::ADD, Register::A, Value(13)),
+        Instruction(Operations::MULU, Register::A, Value(8)), Instruction(Operations::MOD, Register::A, Value(64)),
+        Instruction(Operations::HLT)
+    }, 5);
+    test_optimizer("Jump threading and dead code", {
+        Instruction(Operations::MOV, Register::A, Value(1)), Instruction(Operations::JMP, Value(8)),
+        Instruction(Operations::MOV, Register::A, Value(2)), Instruction(Operations::JMP, Value(8)),
+        Instruction(Operations::MOV, Register::A, Value(3)), Instruction(Operations::HLT)
+    }, 2);
+    test_optimizer("Redundant moves", {
+        Instruction(Operations::MOV, Register::A, Value(5)), Instruction(Operations::MOV, Register::B, Register::B),
+        Instruction(Operations::MOV, Register::A, Value(5)), Instruction(Operations::MOV, Register::C, Value(1)),
+        Instruction(Operations::MOV, Register::C, Register::A), Instruction(Operations::ADD, Register::A, Register::C),
+        Instruction(Operations::HLT)
+    }, 4);
+    // Its code addresses are loaded as values, moving the code would call the wrong instructions
+    for(auto const& kernel : benchmark::micro_kernels(10)) {
+        if (kernel.name == "indirect-call")
+            test_optimizer_refuses("Kernel " + kernel.name, kernel.exe);
+    }
+    test_optimizer_refuses("Jump through memory", executable_of({
+        Instruction(Operations::MOV, Register::A, Value(1)), Instruction(Operations::JMP, Deferred(Register::SP)), Instruction(Operations::HLT)
+    }));
+
+    title("Compact encoding");
+    {
+        auto exe = executable_of({
+            Instruction(Operations::MOV, Register::A, Value(-5)), Instruction(Operations::PUSH, Displacement(Register::SP, -8)),
+            Instruction(Operations::MOV, Address(1 << 20), Deferred(Register::C)), Instruction(Operations::HLT)
+        });
+        test_compact("Instructions", exe);
+
+        exe.code.insert(exe.code.begin() + 1, 0xFFFFFFFF);
+        exe.code.push_back(WideInstruction(WideOperations::ADDL, Register::C, Register::E).get_main_instruction());
+        exe.entry_point = 4;
+        exe.symbols["main"] = 4;
+        exe.jmp_table = { 0, 4 };
+        exe.data = { 1, 2, 0xDEADBEEF };
+        test_compact("Raw words, symbols and data", exe);
+    }
+
+    title("Decode cache");
+    test_decode_cache("Self modifying code", self_modifying_code(), 6);
+
+    title("Verified calls");
+    test_verified_calls("Indirect call", indirect_calls(1, 20));
+    test_verified_calls("Indirect calls to 3 targets", indirect_calls(3, 20));
+    test_verified_calls("Deep recursion", deep_recursion(128));
+    for(auto const& kernel : benchmark::micro_kernels(500)) {
+        if (kernel.name == "call-recursion" || kernel.name == "indirect-call")
+            test_verified_calls("Kernel " + kernel.name, kernel.exe);
+    }
+
+    title("Traps");
+    test_trap("Division by zero", division_by_zero(false), TrapCode::DivisionByZero, 5);
+    test_trap("Division by zero with a handler", division_by_zero(true), TrapCode::DivisionByZero, 5 + static_cast<ui32>(TrapCode::DivisionByZero) + 1);
+    test_trap("Modulo by zero with a returning handler", modulo_by_zero(), TrapCode::DivisionByZero, 5, false, true);
+    test_trap("Invalid pc with a handler", jump_to_invalid_pc(), TrapCode::InvalidPc, 3, true, true);
+    test_trap("Division overflow", division_overflow(), TrapCode::None, static_cast<ui32>(std::numeric_limits<i32>::min()));
+    test_trap("Wide write to the code", wide_write_to_code(), TrapCode::WriteToCode, 3, true);
+    test_trap("Write to a value", executable_of({
+        Instruction(Operations::MOV, Register::A, Value(3)), Instruction(Operations::MOV, Value(1), Register::A), Instruction(Operations::HLT)
+    }), TrapCode::InvalidWrite, 3);
+
+    title("Sandbox pool");
+    test_pool("Registers, stack and memory", executable_of({
+        Instruction(Operations::MOV, Register::A, Value(7)), Instruction(Operations::PUSH, Register::A),
+        Instruction(Operations::MOV, Address(1 << 12), Register::A), Instruction(Operations::NEW, Register::B, Value(16)),
+        Instruction(Operations::MOV, Deferred(Register::B), Register::A), Instruction(Operations::HLT)
+    }));
+
+
+    title("Server");
+    server::Request request;
+    request.input = "vcrate";
+    auto echo = executable_of({
+        Instruction(Operations::MOV, Register::C, Deferred(Register::A)), Instruction(Operations::OUT, Register::C),
+        Instruction(Operations::MOV, Register::A, Register::B), Instruction(Operations::HLT)
+    });
+    test_server("Input and output", echo, request, server::Status::Halted, "v", 6);
+    request.max_instructions = 3;
+    test_server("Instruction limit", echo, request, server::Status::LimitReached, "v", 6);
+    request.memory_size = server::Options{}.max_memory_size + 4;
+    test_server("Memory over the limit", echo, request, server::Status::InvalidRequest, "", 0);
+
+
+    title("Disk cache");
+    test_disk_cache("Deep recursion", deep_recursion(8));
+    test_disk_cache("Self modifying code", executable_of(self_modifying_code()));
+
+    title("Batch");
+    std::vector<std::string> records;
+    for(ui32 i = 0; i < 50; ++i)
+        records.push_back(std::string(1, 'a' + i % 26) + std::string(i, 'x'));
+    test_batch("One worker", echo, records, 1);
+    test_batch("Many workers", echo, records, 8);
+
+    title("Disassembler");
+    // Chunks cut instructions of 2 and 3 words, and some chunks start in the middle of one
+    for(auto const& kernel : benchmark::micro_kernels(10)) {
+        for(ui32 chunk_words : { 1, 2, 3, 7 })
+            test_disassembler("Kernel " + kernel.name + " in chunks of " + std::to_string(chunk_words) + " words", kernel.exe, 4, chunk_words);
+    }
+    test_disassembler("One worker", deep_recursion(8), 1, 5);
+
+    title("Symbol index");
+    vcx::Executable symbols;
+    symbols.symbols = { { "start", 8 }, { "alias", 40 }, { "loop", 40 }, { "end", 100 } };
+    test_symbol_index("Before the first symbol", symbols, 4, "0x4");
+    test_symbol_index("First symbol", symbols, 8, "start");
+    test_symbol_index("Inside a function", symbols, 36, "start+28");
+    test_symbol_index("Symbols sharing an address", symbols, 44, "alias+4");
+    test_symbol_index("Past the last symbol", symbols, 1000, "end+900");
+
+
+    title("Debugger");
+    // The instruction after the recursive call, reached once per frame
+    test_debugger("Deep recursion", deep_recursion(8), Operations::INC, true, 8, 3);
+    test_debugger("Self modifying code", executable_of(self_modifying_code()), Operations::DEC, false, 2, 12);
+
+
+    title("Sanitizer");
+    {
+        // The block of 16 bytes is at B, NEW is 8 bytes long
+        auto allocate = Instruction(Operations::NEW, Register::B, Value(16));
+        auto hlt = Instruction(Operations::HLT);
+        test_sanitizer("Written then read", {
+            allocate, Instruction(Operations::MOV, Displacement(Register::B, 12), Value(3)),
+            Instruction(Operations::MOV, Register::A, Displacement(Register::B, 12)), Instruction(Operations::DEL, Register::B), hlt
+        }, {});
+        test_sanitizer("Stack pushed then popped", {
+            Instruction(Operations::PUSH, Value(4)), Instruction(Operations::POP, Register::A), hlt
+        }, {});
+        test_sanitizer("Use after free", {
+            allocate, Instruction(Operations::MOV, Deferred(Register::B), Value(1)), Instruction(Operations::DEL, Register::B),
+            Instruction(Operations::MOV, Register::A, Deferred(Register::B)), hlt
+        }, { { sanitizer::Kind::UseAfterFree, 16 } });
+        test_sanitizer("Double free", {
+            allocate, Instruction(Operations::DEL, Register::B), Instruction(Operations::DEL, Register::B), hlt
+        }, { { sanitizer::Kind::DoubleFree, 12 } });
+        test_sanitizer("Invalid free", {
+            allocate, Instruction(Operations::ADD, Register::B, Value(4)), Instruction(Operations::DEL, Register::B), hlt
+        }, { { sanitizer::Kind::InvalidFree, 12 } });
+        test_sanitizer("Past the end of a block", {
+            allocate, Instruction(Operations::NEW, Register::C, Value(16)),
+            Instruction(Operations::MOV, Displacement(Register::B, 16), Value(1)), hlt
+        }, { { sanitizer::Kind::OutOfBounds, 16 } });
+        test_sanitizer("Uninitialized block", {
+            allocate, Instruction(Operations::MOV, Register::A, Displacement(Register::B, 8)), hlt
+        }, { { sanitizer::Kind::Uninitialized, 8 } });
+        test_sanitizer("Below the sp", {
+            Instruction(Operations::PUSH, Value(4)), Instruction(Operations::POP, Register::A),
+            Instruction(Operations::MOV, Register::C, Register::SP), Instruction(Operations::MOV, Register::A, Displacement(Register::C, -4)), hlt
+        }, { { sanitizer::Kind::OutOfBounds, 12 } });
+    }
+
+
+
+    title("Coverage");
+    {
+        auto dec = Instruction(Operations::DEC, Register::A);
+        auto cmp = Instruction(Operations::CMP, Register::A, Value(0));
+        auto hlt = Instruction(Operations::HLT);
+        test_coverage("Loop", {
+            Instruction(Operations::MOV, Register::A, Value(3)), dec, cmp,
+            Instruction(Operations::JMPNE, Value(-static_cast<i32>(dec.get_byte_size() + cmp.get_byte_size()))), hlt
+        }, { "executed", "executed", "executed", "both", "executed" });
+        auto jmpe = Instruction(Operations::JMPE, Value(0));
+        jmpe = Instruction(Operations::JMPE, Value(jmpe.get_byte_size() + hlt.get_byte_size()));
+        test_coverage("Branch never taken", {
+            Instruction(Operations::MOV, Register::A, Value(3)), cmp, jmpe, hlt, Instruction(Operations::INC, Register::A), hlt
+        }, { "executed", "executed", "not-taken", "executed", "missed", "missed" });
+        test_coverage("Branch always taken", {
+            Instruction(Operations::MOV, Register::A, Value(0)), cmp, jmpe, hlt, Instruction(Operations::INC, Register::A), hlt
+        }, { "executed", "executed", "taken", "missed", "executed", "executed" });
+    }
+
+
+    title("Replay");
+    test_replay("Checkpoints thinned", deep_recursion(64), 4, 4);
+    test_replay("Checkpoint on each instruction, two kept", deep_recursion(64), 1, 2);
+
+
+    title("Counters");
+    {
+        std::vector<Instruction> blocks = {
+            Instruction(Operations::NEW, Register::B, Value(16)), Instruction(Operations::NEW, Register::C, Value(32)),
+            Instruction(Operations::DEL, Register::B), Instruction(Operations::PUSH, Value(1)), Instruction(Operations::HLT)
+        };
+        test_counters("Heap not tracked", blocks, false,
+            "{\"instructions\": 5, \"calls\": 0, \"allocations\": 2, \"deallocations\": 1, \"allocated_bytes\": 48, "
+            "\"output_bytes\": 0, \"peak_stack_depth\": 4, \"traps\": 0}");
+        test_counters("Heap tracked", blocks, true,
+            "{\"instructions\": 5, \"calls\": 0, \"allocations\": 2, \"deallocations\": 1, \"allocated_bytes\": 48, "
+            "\"output_bytes\": 0, \"peak_stack_depth\": 4, \"heap_in_use\": 32, \"peak_heap\": 48, \"traps\": 0}");
+    }
+
+
+
+    title("Profiler");
+    test_profiler("Every instruction sampled", deep_recursion(8), 1, 10);
+    test_profiler("Sparse samples", deep_recursion(64), 7, 66);
+
+
+
+    title("Trace");
+    test_trace("Recursion, ring smaller than the trace", deep_recursion(16));
+
+
+
+    title("Benchmark engines");
+    for(auto const& kernel : benchmark::micro_kernels(100))
+        test_engines("Kernel " + kernel.name, kernel);
+
+    for(auto const& program : benchmark::macro_programs())
+        test_engines("Program " + program.name, program, true);
+
+
+    title("Benchmark regressions");
+    test_regressions("Same durations", { 100, 110, 105 }, { 100, 110, 105 }, 1000, false);
+    test_regressions("Within the tolerance", { 100, 110, 105 }, { 104, 112, 109 }, 1000, false);
+    test_regressions("Slower", { 100, 110, 105 }, { 120, 130, 125 }, 1000, true);
+    test_regressions("Slower but one run as fast", { 100, 110, 105 }, { 95, 130, 125 }, 1000, false);
+    test_regressions("Slower with other instructions", { 100, 110, 105 }, { 120, 130, 125 }, 2000, false);
+    {
+        std::stringstream header;
+        benchmark::save_results(header, {});
+        std::vector<std::pair<std::string, std::string>> malformed = {
+            { "without the header", "kernel\tengine\n" },
+            { "with a malformed duration", header.str() + "kernel\tengine\t1000\t100\t90\t110\t90,1x0,110\n" },
+            { "with an empty duration", header.str() + "kernel\tengine\t1000\t100\t90\t110\t90,,110\n" },
+            { "with malformed instructions", header.str() + "kernel\tengine\tmany\t100\t90\t110\t90,100,110\n" }
+        };
+        for(auto const& m : malformed) {
+            std::stringstream ss(m.second);
+            try {
+                if (benchmark::load_results(ss)) {
+                    error_header();
+                    std::cout << "Results " << m.first << " are loaded\n";
+                } else {
+                    good_header();
+                    std::cout << "Results " << m.first << " are refused\n";
+                }
+            } catch(std::exception const& e) {
+                exception_header();
+                std::cout << "Results " << m.first << " " << e.what() << "\n";
+            }
+        }
+    }
+
+
+    title("Control flow graph");
+    {
+        std::vector<ui32> block_pcs;
+        auto exe = nested_loops(block_pcs);
+        auto none = analysis::ControlFlowGraph::none;
+        test_control_flow("Nested loops", exe, block_pcs, { none, 0, 1, 2, 3 }, { 0, 1, 2, 1, 0 });
+        auto hlt = Instruction(Operations::HLT);
+        test_control_flow("Straight code", executable_of({ Instruction(Operations::MOV, Register::A, Value(1)), hlt }), { 0 }, { none }, { 0 });
+    }
+
+
+    title("Native programs");
+    test_native("Deep recursion", deep_recursion(64));
+    test_native("Indirect calls to 3 targets", indirect_calls(3, 20));
+    for(auto const& program : benchmark::macro_programs())
+        test_native("Program " + program.name, program.exe);
+
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include <iostream>
+
+#include <vcrate/Alias.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+#include <vcrate/Trace/Trace.hpp>
+#include <vcrate/Program/Compact.hpp>
+#include <vcrate/Program/SymbolIndex.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <string>
+
+using namespace vcrate::interpreter;
+using namespace vcrate::trace;
+using namespace vcrate;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Require a file in argument\n";
+        return 1;
+    }
+
+    std::string file = "";
+    ui64 from = 0;
+    ui64 count = static_cast<ui64>(-1);
+    std::string executable_file = "";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--from" && i + 1 < argc) {
+            from = std::stoull(argv[++i]);
+        } else if (arg == "--count" && i + 1 < argc) {
+            count = std::stoull(argv[++i]);
+        } else if ((arg == "-e" || arg == "--executable") && i + 1 < argc) {
+            executable_file = argv[++i];
+        } else if (arg == "--help" || arg[0] == '-') {
+            if (arg != "--help")
+                std::cout << "Argument not supported\n";
+            std::cout << "Usage: " << argv[0] << " [--help] [--from <record>] [--count <records>] [-e | --executable <file>] <filename>\n";
+            return arg != "--help";
+        } else {
+            file = arg;
+        }
+    }
+
+    std::ifstream is(file, std::ios::binary);
+
+    if (!is) {
+        std::cout << "File (" << file << ") couldn't be opened\n";
+        return 1;
+    }
+
+    // Locations are only known with the executable traced
+    std::optional<program::SymbolIndex> symbols;
+    if (!executable_file.empty()) {
+        std::ifstream es(executable_file, std::ios::binary);
+        auto exe = program::read_executable(es);
+        if (!exe) {
+            std::cout << "File (" << executable_file << ") is not a valid executable\n";
+            return 1;
+        }
+        symbols.emplace(*exe);
+    }
+
+    TraceReader reader(is);
+    if (!reader.is_valid()) {
+        std::cout << "File (" << file << ") is not a trace\n";
+        return 1;
+    }
+
+    TraceRecord record;
+    ui64 index = from;
+    if (!reader.seek(from))
+        return 0;
+
+    for(; count > 0 && reader.next(record); ++index, --count) {
+        std::string insn;
+        try {
+            insn = instruction_to_string(record.instruction[0], record.instruction[1], record.instruction[2]);
+        } catch(std::exception const& e) {
+            insn = std::string("?? (") + e.what() + ")";
+        }
+
+        std::cout << std::setw(10) << index << "  " << std::setw(10) << record.pc;
+        if (symbols)
+            std::cout << "  " << std::left << std::setw(20) << symbols->location_of(record.pc) << std::right;
+        std::cout << " : "
+                  << std::left << std::setw(32) << insn << std::right
+                  << " [" << record.values[0] << ", " << record.values[1] << "]"
+                  << " sp=" << record.sp
+                  << ((record.flags & TraceRecord::flag_zero) ? " Z" : "")
+                  << ((record.flags & TraceRecord::flag_greater) ? " G" : "")
+                  << '\n';
+    }
+}
@@ -1,11 +1,19 @@
 #include <iostream>
 #include <fstream>
+#include <cstring>
 
 #include <vcrate/Alias.hpp>
 
 #include <vcrate/vcx/Executable.hpp>
 #include <vcrate/instruction/Instruction.hpp>
 #include <vcrate/bytecode/Operations.hpp>
+#include <vcrate/Interpreter/WideInstruction.hpp>
+
+unsigned bits_of(float f) {
+    unsigned u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
 
 int main() {
     using namespace vcrate;
@@ -13,7 +21,7 @@ int main() {
     vcx::Executable exe;
 
     exe.entry_point = 0;
-    auto push = [&exe] (instruction::Instruction const& i) {
+    auto push = [&exe] (auto const& i) {
         exe.code.push_back(i.get_main_instruction());
         if (i.get_byte_size() > sizeof(ui32)) {
             exe.code.push_back(i.get_first_extra());
@@ -30,13 +38,21 @@ int main() {
     push(instruction::Instruction(bytecode::Operations::OUT, instruction::Value(' ')));
     
     float f = 2;
-    push(instruction::Instruction(bytecode::Operations::MULF, instruction::Register::A, instruction::Value(*(unsigned*)(&f))));
+    push(instruction::Instruction(bytecode::Operations::MULF, instruction::Register::A, instruction::Value(bits_of(f))));
     
     push(instruction::Instruction(bytecode::Operations::DBGF, instruction::Register::A));
     push(instruction::Instruction(bytecode::Operations::OUT, instruction::Value(' ')));
     push(instruction::Instruction(bytecode::Operations::DBG, instruction::Register::A));
     push(instruction::Instruction(bytecode::Operations::OUT, instruction::Value(' ')));
     
+    using interpreter::WideInstruction;
+    using interpreter::WideOperations;
+    push(instruction::Instruction(bytecode::Operations::MOV, instruction::Register::C, instruction::Value(21)));
+    push(WideInstruction(WideOperations::ITD, instruction::Register::C));
+    push(WideInstruction(WideOperations::MULD, instruction::Register::C, instruction::Value(bits_of(f))));
+    push(WideInstruction(WideOperations::DBGD, instruction::Register::C));
+    push(instruction::Instruction(bytecode::Operations::OUT, instruction::Value(' ')));
+
     //push(instruction::Instruction(bytecode::Operations::ITF, instruction::Register::A));
     //push(instruction::Instruction(bytecode::Operations::FTI, instruction::Register::A));
     //push(instruction::Instruction(bytecode::Operations::DBG, instruction::Register::A));